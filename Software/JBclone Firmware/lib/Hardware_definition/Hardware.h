@@ -1,71 +1,102 @@
-#ifndef __HARDWARE_DEFINITION_H__
-#define __HARDWARE_DEFINITION_H__
-
-#include <Arduino.h>
-#include <Wire.h>
-#include "EEprom.h"
-#include "Heater.h"
-
-constexpr int ADC_BITS = 12;
-constexpr float ADC_RES = 4096.0f; 
-constexpr float ADC_VREF = 3.3f;
-constexpr uint32_t _hartbeat_pulse_width = 5000; // us
-constexpr uint32_t _tc_amp_recovery_time = 1700; //us
-
-constexpr int _pin_hartbeat = PB15;
-constexpr int _pin_zero_cross = PA8;
-
-//100% control output half waves 
-constexpr unsigned int _zero_cross_period  = 10;
-
-// bus connecions
-constexpr int _pin_wire_sda = PB11;
-constexpr int _pin_wire_scl = PB10;
-
-//eeprom
-constexpr unsigned int _address_eeprom = 0x50;
-
-// serial
-#define _serial_hmi Serial1
-constexpr uint32_t _serial_hmi_baud = 115200;
-constexpr unsigned long _serial_hmi_timeout = 20; // ms
-constexpr uint32_t  _hmi_update_interval = 500; // ms
-
-#define _serial_usb Serial
-constexpr uint32_t _serial_usb_baud = 152000;
-constexpr unsigned long _serial_usb_timeout = 20; // ms
-constexpr char _serial_usb_terminator = '\n';
-
-// board specific
-constexpr int _board1_temp = PA2;
-constexpr int _board1_heater = PB9;
-constexpr float _board1_tc_gain = 200.0f;
-constexpr int _board1_stand = PB3;
-constexpr size_t _board1_mem_addr = Heater::eeprom_footprint * 0;
-
-constexpr int _board2_temp = PA3;
-constexpr int _board2_heater = PB8;
-constexpr float _board2_tc_gain = 400.0f;
-constexpr int _board2_stand = PB4;
-constexpr size_t _board2_mem_addr = Heater::eeprom_footprint * 1;
-
-constexpr int _board3_temp = PA0;
-constexpr int _board3_heater = PB7;
-constexpr float _board3_tc_gain = 400.0f;
-constexpr int _board3_stand = PB5;
-constexpr size_t _board3_mem_addr = Heater::eeprom_footprint * 2;
-
-constexpr int _board4_temp = PA1;
-constexpr int _board4_heater = PB6;
-constexpr float _board4_tc_gain = 400.0f;
-constexpr int _board4_stand = _board3_stand;
-constexpr size_t _board4_mem_addr = Heater::eeprom_footprint * 3;
-
-// gpio
-constexpr int _pin_gpio1 = PA4;
-constexpr int _pin_gpio2 = PA5;
-constexpr int _pin_gpio3 = PA6;
-constexpr int _pin_gpio4 = PA7; // TODO: CHECK
-constexpr int _pin_gpio5 = PB0;
-
+#ifndef __HARDWARE_DEFINITION_H__
+#define __HARDWARE_DEFINITION_H__
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "EEprom.h"
+#include "Heater.h"
+
+constexpr int ADC_BITS = 12;
+constexpr float ADC_RES = 4096.0f; 
+constexpr float ADC_VREF = 3.3f;
+constexpr uint32_t _hartbeat_pulse_width = 5000; // us
+constexpr uint32_t _tc_amp_recovery_time = 1700; //us
+
+constexpr int _pin_hartbeat = PB15;
+constexpr int _pin_zero_cross = PA8;
+constexpr uint32_t _zc_capture_timer_hz = 3000000; // TIM1_CH1 edge capture, 16 bit counter wraps every 21.8ms
+
+//100% control output half waves 
+constexpr unsigned int _zero_cross_period  = 10;
+
+// mains half-cycle, energy of a conducting half-cycle = heater power * half-cycle
+constexpr uint32_t _mains_half_cycle_us = 10000; // 50Hz
+
+// control tick, TIM4 update interrupt running sampling and PID below the zero cross EXTI (6)
+constexpr uint32_t _control_tick_us = 1000;
+constexpr uint32_t _control_tick_irq_priority = 10;
+constexpr uint32_t _control_events_per_tick = 16; // zero cross events taken per tick, bounds the tick time
+
+// zero cross watchdog, enabled heaters go to FAULT when the edges stop
+constexpr uint32_t _zero_cross_timeout_us = 5 * _mains_half_cycle_us;
+
+// heating watchdog, saturated output more than _heating_watchdog_error C below the setpoint
+// has to raise the PV by _heating_watchdog_rise C every _heating_watchdog_time ms
+constexpr uint32_t _heating_watchdog_time = 5000; // ms
+constexpr float _heating_watchdog_rise = 10.0f;
+constexpr float _heating_watchdog_error = 50.0f;
+
+// unsaved lifetime energy that triggers an EEPROM write, Wh
+constexpr float _energy_save_threshold_wh = 10.0f;
+
+// |SP - PV| considered in regulation, C
+constexpr float _regulation_band_temp = 2.0f;
+
+// bus connecions
+constexpr int _pin_wire_sda = PB11;
+constexpr int _pin_wire_scl = PB10;
+
+//eeprom
+constexpr unsigned int _address_eeprom = 0x50;
+
+// serial
+#define _serial_hmi Serial1
+constexpr uint32_t _serial_hmi_baud = 115200;
+constexpr unsigned long _serial_hmi_timeout = 20; // ms
+constexpr uint32_t  _hmi_update_interval = 500; // ms
+
+#define _serial_usb Serial
+constexpr uint32_t _serial_usb_baud = 152000;
+constexpr unsigned long _serial_usb_timeout = 20; // ms
+constexpr char _serial_usb_terminator = '\n';
+
+// id field of station wide commands, e.g. "s:prof:?"
+constexpr char _station_command_id = 's';
+
+// board specific
+constexpr int _board1_temp = PA2;
+constexpr int _board1_heater = PB9;
+constexpr float _board1_tc_gain = 200.0f;
+constexpr int _board1_stand = PB3;
+constexpr size_t _board1_mem_addr = Heater::eeprom_footprint * 0;
+constexpr size_t _board1_energy_addr = Heater::eeprom_footprint * 4 + Heater::energy_eeprom_footprint * 0;
+
+constexpr int _board2_temp = PA3;
+constexpr int _board2_heater = PB8;
+constexpr float _board2_tc_gain = 400.0f;
+constexpr int _board2_stand = PB4;
+constexpr size_t _board2_mem_addr = Heater::eeprom_footprint * 1;
+constexpr size_t _board2_energy_addr = Heater::eeprom_footprint * 4 + Heater::energy_eeprom_footprint * 1;
+
+constexpr int _board3_temp = PA0;
+constexpr int _board3_heater = PB7;
+constexpr float _board3_tc_gain = 400.0f;
+constexpr int _board3_stand = PB5;
+constexpr size_t _board3_mem_addr = Heater::eeprom_footprint * 2;
+constexpr size_t _board3_energy_addr = Heater::eeprom_footprint * 4 + Heater::energy_eeprom_footprint * 2;
+
+constexpr int _board4_temp = PA1;
+constexpr int _board4_heater = PB6;
+constexpr float _board4_tc_gain = 400.0f;
+constexpr int _board4_stand = _board3_stand;
+constexpr size_t _board4_mem_addr = Heater::eeprom_footprint * 3;
+constexpr size_t _board4_energy_addr = Heater::eeprom_footprint * 4 + Heater::energy_eeprom_footprint * 3;
+
+// gpio
+constexpr int _pin_gpio1 = PA4;
+constexpr int _pin_gpio2 = PA5;
+constexpr int _pin_gpio3 = PA6;
+constexpr int _pin_gpio4 = PA7; // TODO: CHECK
+constexpr int _pin_gpio5 = PB0;
+
 #endif
\ No newline at end of file
@@ -1,151 +1,392 @@
-#ifndef __HEATER_H__
-#define __HEATER_H__
-
-#include <Arduino.h>
-#include "EEprom.h"
-class Heater
-{
-private:
-    //temperature constrains and lookup
-    float _temp_sp_min;
-    float _temp_sp_max;
-    float _temp_runaway_threshold;
-    float _temp_sp;
-    float _temp_pv;
-
-    // [thermocouple_voltage_uV, temperature_C]
-    const static size_t _tc_cal_table_size = 10;
-    float _tc_cal_table[_tc_cal_table_size][2];
-    float _tc_max_voltage_setpoint;
-    float _tc_gain;
-
-    // PID loop
-    float _pid_kp;
-
-    float _pid_ki;
-    float _pid_integral;
-
-    float _pid_kd;
-    float _pid_derivative_prev_e_t;
-    float _pid_derivative_filter_tau;
-
-    const float _pid_output_min = 0.0f;
-    const float _pid_output_max = 1.0f;
-    float _pid_TCvoltage_sp;
-    float _pid_output;
-
-    bool _sample_scheduled = false;
-    volatile uint32_t _sample_Schedule_timestamp = 0;
-    
-    uint32_t _pid_TCvoltsge_pv_old_timestamp;
-    uint32_t _pid_TCvoltage_pv_timestamp;
-    float _pid_TCvoltage_pv;
-    
-    bool _pid_update_pending = false;
-
-    void pid_reset();
-    void pid_compute();
-    void pid_sample();
-
-    // general
-    int _tc_pin;
-    int _heater_pin;
-    int _stand_sense_pin;
-    bool _enable;
-
-    //sleep mode
-    uint32_t _sleep_delay_start_time = 0;
-    bool _sleep_delay_running = false;
-    float _sleep_delay = 0;
-    bool _sleep_state = false;
-    float _sleep_TCvoltage_set;
-
-    // hmi
-    void (*_hmi_update_function)(Heater *);
-    uint32_t _hmi_last_update_timestamp = 0;
-
-    // EEPROM
-    EEprom &_memory;
-    size_t _start_address;
-    bool save(String &response);
-    bool load_memory();
-
-public:
-
-    Heater(
-        int tc_pin, 
-        int heater_pin, 
-        int stand_sense_pin,
-        float tc_gain, 
-        size_t start_address, 
-        EEprom &eeprom, 
-        void (*_hmi_update_function)(Heater *) = nullptr
-    );
-    void init();
-
-    //HMI helpers
-    int get_pid_op_percent();
-    String get_pid_pv_t();
-    String get_pid_sp_t();
-    String get_state_txt();
-    long get_state_color();
-    String get_sleep_state_txt();
-
-
-    //state control
-    bool enable(String &cmd, String &response);
-
-    //temperatuere mode set
-    bool temp_set(String &cmd, String &response);
-    bool temp_measure(String &cmd, String &response);
-    bool temp_set_min(String &cmd, String &response);
-    bool temp_set_max(String &cmd, String &response);
-    bool temp_runaway_threshold(String &cmd, String &response);
-
-    //sleep
-    bool sleep_temp(String &cmd, String &response);
-    bool sleep_delay(String &cmd, String &response);
-    bool sleep_state(String &cmd, String &response);
-
-    //pid
-    bool pid_cli_gain(String &cmd, String &response);
-    bool pid_cli_ki(String &cmd, String &response);
-    bool pid_cli_kd(String &cmd, String &response);
-    bool pid_derivative_filter_t(String &cmd, String &response);
-    bool pid_output(String &cmd, String &response);
-    bool pid_voltage_setpoint(String &cmd, String &response);
-    void pid_schedule_sample();
-
-    //thermocouple
-    bool tc_cal_table(String &cmd, String &response);
-    bool tc_read_voltage(String &cmd, String &response);
-    float tcv_to_temp(float voltage);
-    float temp_to_tcv(float temp);
-
-    //heater
-    void update();
-    void update_output(float op_level);
-
-    // EEPROM
-    float* _eeprom_mapped_vars[10] = {
-        &_pid_TCvoltage_sp,
-        &_temp_sp_min,
-        &_temp_sp_max,
-        &_pid_kp,
-        &_pid_ki,
-        &_pid_kd,
-        &_pid_derivative_filter_tau,
-        &_sleep_delay,
-        &_sleep_TCvoltage_set,
-        &_temp_runaway_threshold,
-    };
-
-    static constexpr size_t eeprom_footprint =
-        (sizeof(float) * (sizeof(_eeprom_mapped_vars) / sizeof(_eeprom_mapped_vars[0]))) +
-        sizeof(_tc_cal_table);
-
-    bool restore_default_config(String &cmd, String &response);
-};
-
-
-#endif
+#ifndef __HEATER_H__
+#define __HEATER_H__
+
+#include <Arduino.h>
+#include "EEprom.h"
+#include "running_stats.h"
+#ifdef JBCLONE_CORO
+#include "coro.h"
+#endif
+/**
+ * @brief channel state machine.
+ *
+ * OFF -> HEATING on enable, HEATING -> REGULATING when PV enters the regulation band,
+ * HEATING/REGULATING -> SLEEP after the stand delay, SLEEP -> WAKING when lifted,
+ * WAKING -> REGULATING when PV enters the band again, any -> FAULT on a HeaterFault.
+ * A setpoint change while REGULATING goes back to HEATING.
+ * OPEN_LOOP drives a fixed duty without PID and stand detection (step tests).
+ */
+enum HeaterState : uint8_t
+{
+    HEATER_OFF,
+    HEATER_HEATING,
+    HEATER_REGULATING,
+    HEATER_SLEEP,
+    HEATER_WAKING,
+    HEATER_FAULT,
+    HEATER_OPEN_LOOP,
+};
+
+/**
+ * @brief cause of the last move to FAULT, kept until the channel is enabled again.
+ */
+enum HeaterFault : uint8_t
+{
+    FAULT_NONE,
+    FAULT_RUNAWAY,    // PV above the runaway threshold
+    FAULT_TC_OPEN,    // ADC at full scale, open thermocouple or amplifier
+    FAULT_NO_HEATING, // output saturated far below the setpoint without the PV rising
+    FAULT_ZERO_CROSS, // no mains zero cross, outputs would stay at their last level
+};
+
+/**
+ * @brief EEPROM blocks of a channel, written by the storage task in the RTOS build.
+ */
+enum HeaterStorage : uint8_t
+{
+    STORAGE_CONFIG, // configuration and calibration table
+    STORAGE_ENERGY, // heater power and lifetime energy
+};
+
+class Heater
+{
+public:
+    // control state captured at the start of a recording and restored by the replay,
+    // fixed width fields only so the layout is the same on the target and the host
+    struct Snapshot
+    {
+        float temp_sp_min;
+        float temp_sp_max;
+        float temp_runaway_threshold;
+        float temp_sp;
+        float temp_pv;
+        float tc_cal_table[10][2];
+        float tc_max_voltage_setpoint;
+        float tc_gain;
+        float pid_kp;
+        float pid_ki;
+        float pid_integral;
+        float pid_kd;
+        float pid_derivative_prev_e_t;
+        float pid_derivative_filter_tau;
+        float pid_TCvoltage_sp;
+        float pid_output;
+        float pid_TCvoltage_pv;
+        float regulation_sp_temp;
+        float open_loop_duty;
+        float sleep_delay;
+        float sleep_TCvoltage_set;
+        uint32_t sample_schedule_timestamp;
+        uint32_t pv_old_timestamp;
+        uint32_t pv_timestamp;
+        uint32_t state_timestamp;
+        uint32_t dip_timestamp;
+        uint32_t sleep_delay_start_time;
+        uint32_t heating_check_timestamp;
+        float heating_check_temp;
+        uint8_t state;
+        uint8_t sample_scheduled;
+        uint8_t pid_update_pending;
+        uint8_t output_state;
+        uint8_t dip_active;
+        uint8_t sleep_delay_running;
+        uint8_t fault;
+        uint8_t heating_check_active;
+    };
+
+    // diagnostic counters, reported by the station health command
+    struct HealthCounters
+    {
+        volatile uint32_t samples_scheduled;
+        uint32_t samples_missed;          // due again before the previous sample was taken
+        uint32_t samples_taken;
+        uint32_t pid_skipped;             // oversampling guard dt < 1ms
+        uint32_t saves;
+        uint32_t save_failures;
+        uint32_t save_time_us;
+        uint32_t save_time_us_max;
+    };
+
+private:
+    //temperature constrains and lookup
+    float _temp_sp_min;
+    float _temp_sp_max;
+    float _temp_runaway_threshold;
+    float _temp_sp;
+    float _temp_pv;
+
+    // [thermocouple_voltage_uV, temperature_C]
+    const static size_t _tc_cal_table_size = 10;
+    float _tc_cal_table[_tc_cal_table_size][2];
+    float _tc_max_voltage_setpoint;
+    float _tc_gain;
+
+    // PID loop
+    float _pid_kp;
+
+    float _pid_ki;
+    float _pid_integral;
+
+    float _pid_kd;
+    float _pid_derivative_prev_e_t;
+    float _pid_derivative_filter_tau;
+
+    const float _pid_output_min = 0.0f;
+    const float _pid_output_max = 1.0f;
+    float _pid_TCvoltage_sp;
+    float _pid_output;
+
+    // sample window, control tick side, from the EVENT_SAMPLE_DUE events
+    bool _sample_scheduled = false;
+    uint32_t _sample_Schedule_timestamp = 0;
+    uint16_t _sample_window = 0;
+
+    // output hold off until the sample of the window is taken, one writer each
+    volatile uint16_t _sample_request = 0; // window the ISR switched the output off for
+    volatile uint16_t _sample_ack = 0;     // window of the last sample taken by the control tick
+    
+    uint32_t _pid_TCvoltsge_pv_old_timestamp;
+    uint32_t _pid_TCvoltage_pv_timestamp;
+    float _pid_TCvoltage_pv;
+    
+    bool _pid_update_pending = false;
+
+    void pid_reset();
+    void pid_compute();
+    void pid_sample();
+
+    // general
+    uint8_t _channel;
+    int _tc_pin;
+    int _heater_pin;
+    int _stand_sense_pin;
+    bool _output_state = false; // last level written to the heater pin by the zero cross ISR
+
+    // state machine
+    volatile HeaterState _state = HEATER_OFF;
+    uint32_t _state_timestamp = 0; // ms, last transition
+    bool _dip_active = false;      // PV fell below the band while regulating
+    uint32_t _dip_timestamp = 0;
+    float _regulation_sp_temp = NAN; // effective setpoint cache, NAN = recompute
+    float _open_loop_duty = 0.0f;
+    HeaterFault _fault = FAULT_NONE;
+
+    // heating watchdog, PV at the start of the current window
+    bool _heating_check_active = false;
+    uint32_t _heating_check_timestamp = 0; // ms
+    float _heating_check_temp = 0.0f;
+
+    // rolling history of transition durations, ms
+    static const size_t _timing_history_size = 8;
+    struct TimingHistory
+    {
+        uint32_t ms[_timing_history_size];
+        uint8_t count;
+        uint8_t next;
+
+        void add(uint32_t value)
+        {
+            ms[next] = value;
+            next = (next + 1) % _timing_history_size;
+            if (count < _timing_history_size)
+                count++;
+        }
+    };
+    TimingHistory _history_heatup = {};
+    TimingHistory _history_wake = {};
+    TimingHistory _history_recovery = {};
+
+    void state_set(HeaterState new_state);
+    void state_regulation_update(float error);
+    void setpoint_changed();
+    void setpoint_constrain();
+    void heating_watchdog_update(float error);
+    float regulation_error();
+    bool is_enabled() const;
+
+    //sleep mode
+    uint32_t _sleep_delay_start_time = 0;
+    bool _sleep_delay_running = false;
+    float _sleep_delay = 0;
+    float _sleep_TCvoltage_set;
+
+    // hmi
+    void (*_hmi_update_function)(Heater *);
+    uint32_t _hmi_last_update_timestamp = 0;
+
+    // diagnostics
+    HealthCounters _health = {};
+
+    // regulation statistics since last reset or setpoint change
+    struct RegulationWindow
+    {
+        RunningStats error;    // C
+        RunningStats duty;     // 0-1
+        RunningStats interval; // ms
+        float time_total;      // s
+        float time_in_band;    // s
+
+        void reset()
+        {
+            error.reset();
+            duty.reset();
+            interval.reset();
+            time_total = 0.0f;
+            time_in_band = 0.0f;
+        }
+    };
+    RegulationWindow _stats_transient;
+    RegulationWindow _stats_settled;
+    void stats_reset();
+    void stats_update(float dt, float error);
+
+    // energy accounting, half-cycle counters written by the zero cross ISR
+    volatile uint32_t _energy_halfcycles_on = 0;
+    volatile uint32_t _energy_halfcycles_total = 0;
+    uint32_t _energy_drained_on = 0;
+    uint32_t _energy_drained_total = 0;
+    float _heater_power = 0.0f;           // W, configured per cartridge
+    uint32_t _session_halfcycles_on = 0;
+    uint32_t _session_halfcycles_total = 0;
+    uint64_t _session_energy_uj = 0;
+    uint32_t _session_start_timestamp = 0; // ms
+    float _lifetime_energy_wh = 0.0f;      // persisted
+    uint64_t _lifetime_unsaved_uj = 0;     // not yet added to the persisted total
+    void energy_update();
+    bool energy_save(bool wait = true);
+    bool energy_write();
+    bool energy_load();
+
+    // EEPROM
+    EEprom &_memory;
+    size_t _start_address;
+    size_t _energy_address;
+    bool save(String &response);
+    float *config_slot(size_t index);
+    uint32_t config_write_begin();
+    void config_write_end(bool good_op, uint32_t start_time);
+    bool config_write();
+    bool storage_request(HeaterStorage block, bool wait);
+    bool load_memory();
+#ifdef JBCLONE_CORO
+    uint8_t _storage_pending = 0; // HeaterStorage bits requested, see storage_write_async()
+    CoroTask<bool> config_write_async();
+    CoroTask<bool> energy_write_async();
+#endif
+
+public:
+
+    Heater(
+        int tc_pin, 
+        int heater_pin, 
+        int stand_sense_pin,
+        float tc_gain, 
+        size_t start_address, 
+        size_t energy_address,
+        EEprom &eeprom, 
+        void (*_hmi_update_function)(Heater *) = nullptr
+    );
+    void init(uint8_t channel);
+
+    //diagnostics
+    const HealthCounters &get_health() const { return _health; }
+    void clear_health();
+    int get_tc_pin() const { return _tc_pin; }
+    int get_stand_pin() const { return _stand_sense_pin; }
+    bool sample_pending() const { return _sample_scheduled; }
+    HeaterState get_state() const { return _state; }
+    HeaterFault get_fault() const { return _fault; }
+    void fault(HeaterFault reason);
+    float get_temp_pv() const { return _temp_pv; }
+
+    bool stats(String &cmd, String &response);
+    bool energy(String &cmd, String &response);
+    bool heater_power(String &cmd, String &response);
+
+    //HMI helpers
+    int get_pid_op_percent();
+    String get_pid_pv_t();
+    String get_pid_sp_t();
+    String get_state_txt();
+    long get_state_color();
+    String get_sleep_state_txt();
+
+
+    //state control
+    bool enable(String &cmd, String &response);
+    bool state(String &cmd, String &response);
+    bool timing(String &cmd, String &response);
+    void open_loop_start(float duty);
+    void open_loop_stop();
+
+    //temperatuere mode set
+    bool temp_set(String &cmd, String &response);
+    bool temp_measure(String &cmd, String &response);
+    bool temp_set_min(String &cmd, String &response);
+    bool temp_set_max(String &cmd, String &response);
+    bool temp_runaway_threshold(String &cmd, String &response);
+
+    //sleep
+    bool sleep_temp(String &cmd, String &response);
+    bool sleep_delay(String &cmd, String &response);
+    bool sleep_state(String &cmd, String &response);
+
+    //pid
+    bool pid_cli_gain(String &cmd, String &response);
+    bool pid_cli_ki(String &cmd, String &response);
+    bool pid_cli_kd(String &cmd, String &response);
+    bool pid_derivative_filter_t(String &cmd, String &response);
+    bool pid_output(String &cmd, String &response);
+    bool pid_voltage_setpoint(String &cmd, String &response);
+    void pid_schedule_sample(uint16_t window);
+    void sample_due(uint32_t timestamp, uint16_t window);
+
+    //thermocouple
+    bool tc_cal_table(String &cmd, String &response);
+    bool tc_read_voltage(String &cmd, String &response);
+    float tcv_to_temp(float voltage);
+    float temp_to_tcv(float temp);
+
+    //heater
+    void update();
+    void hmi_refresh();
+    void control_update();
+    bool update_output(float op_level);
+
+    // EEPROM
+    float* _eeprom_mapped_vars[10] = {
+        &_pid_TCvoltage_sp,
+        &_temp_sp_min,
+        &_temp_sp_max,
+        &_pid_kp,
+        &_pid_ki,
+        &_pid_kd,
+        &_pid_derivative_filter_tau,
+        &_sleep_delay,
+        &_sleep_TCvoltage_set,
+        &_temp_runaway_threshold,
+    };
+
+    static constexpr size_t eeprom_footprint =
+        (sizeof(float) * (sizeof(_eeprom_mapped_vars) / sizeof(_eeprom_mapped_vars[0]))) +
+        sizeof(_tc_cal_table);
+
+    // heater power and lifetime energy, kept apart from the configuration block
+    // so the lifetime counter is written only as often as it needs to be
+    static constexpr size_t energy_eeprom_footprint = 2 * sizeof(float);
+
+    bool restore_default_config(String &cmd, String &response);
+    bool storage_write(HeaterStorage block);
+#ifdef JBCLONE_CORO
+    static CoroEvent storage_requested;
+    bool storage_pending() const { return _storage_pending != 0; }
+    CoroTask<bool> storage_write_async();
+#endif
+
+    // recording and replay
+    void snapshot_save(Snapshot &snapshot) const;
+    void snapshot_load(const Snapshot &snapshot);
+};
+
+
+#endif
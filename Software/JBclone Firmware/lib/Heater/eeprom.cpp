@@ -1,130 +1,257 @@
-#include "Heater.h"
-#include "parser.h"
-
-/**
- * @brief save the current tipconfiguration and calibration to memory
- * 
- * This function saves the current configuration and calibration data to EEPROM memory.
- * It writes the values of the mapped variables and the thermocouple calibration table to the specified memory address.
- * Assignes to the passed response string the result of the operation as "OK" or "FAIL TO SAVE".
- * 
- * @return true if the operation was successful, false otherwise.
- */
-bool Heater::save(String &response)
-{
-    constexpr float epsilon = 0.0001f;
-    size_t addr = _start_address;
-    float stored;
-
-    bool good_op = true;
-
-    for (size_t i = 0; i < sizeof(_eeprom_mapped_vars) / sizeof(_eeprom_mapped_vars[0]); ++i)
-    {
-        good_op &= _memory.writeFloat(addr, *(_eeprom_mapped_vars[i]));
-        addr += sizeof(float);
-    }
-
-    for (int i = 0; i < _tc_cal_table_size; i++)
-    {
-        good_op &= _memory.writeFloat(addr, _tc_cal_table[i][0]);
-        addr += sizeof(float);
-
-        good_op &= _memory.writeFloat(addr, _tc_cal_table[i][1]);
-        addr += sizeof(float);
-    }
-
-    response = good_op ? "OK" : "FAIL TO SAVE";
-    return good_op;
-}
-
-/**
- * @brief load the current tipconfiguration and calibration from memory
- * 
- * This function loads the configuration and calibration data from EEPROM memory.
- * 
- * @return true if the operation was successful, false otherwise.
- */
-bool Heater::load_memory()
-{
-    size_t addr = _start_address;
-    bool good_op = true;
-
-    constexpr size_t num_vars = sizeof(_eeprom_mapped_vars) / sizeof(_eeprom_mapped_vars[0]);
-    for (size_t i = 0; i < num_vars; ++i)
-    {
-        good_op &= _memory.readFloat(addr, *(_eeprom_mapped_vars[i]));
-        addr += sizeof(float);
-    }
-
-    for (int i = 0; i < _tc_cal_table_size; i++)
-    {
-        good_op &= _memory.readFloat(addr, _tc_cal_table[i][0]);
-        addr += sizeof(float);
-
-        good_op &= _memory.readFloat(addr, _tc_cal_table[i][1]);
-        addr += sizeof(float);
-    }
-
-    if (good_op)
-        _temp_sp = tcv_to_temp(_pid_TCvoltage_sp);
-
-    return good_op;
-}
-
-/**
- * * @brief Restore default configuration and calibration values.
- * 
- * This function restores the default configuration and calibration values for the heater.
- * The default values are:
- * - Thermocouple S[uV/K]: 0.0 to 40.0
- * - Temperature setpoint range: 100.0 to 400.0
- * - PID gains: kp = 0.0, ti = 0.0, td = 0.0
- * - Derivative filter time constant: 0.25s
- * - Sleep delay: 30s
- * - Sleep temperature setpoint: 150.0C
- * - Thermocouple calibration table: linear interpolation between 0 and 450C
- * @param cmd The command string containing the thermocouple S[uV/K] value.
- * @param response The response string to be sent back to the caller.
- * @return true if the operation was successful, false otherwise.
- * @note The function also saves the new configuration to EEPROM memory.
- * @warning The function will overwrite the current configuration and calibration values.
- */
-bool Heater::restore_default_config(String &cmd, String &response)
-{
-    float tc_s;
-    bool valid = parseFloat(cmd, tc_s);
-    if (!valid)
-    {
-        response = "invalid thermocouple S[uV/K]";
-        return false;
-    }
-
-    if (tc_s <= 0 || tc_s > 40.0f)
-    {
-        response = "S[uV/K] outside of range";
-        return false;
-    }
-
-    _pid_TCvoltage_sp = tc_s;
-    _temp_sp_min = 100.0f;
-    _temp_sp_max = 400.0f;
-
-    _pid_kp = 0.0f;
-    _pid_ki = 0.0f;
-    _pid_kd = 0.0f;
-    _pid_derivative_filter_tau = 0.25f;
-
-    _sleep_delay = 30000.0f; // 30s
-    _sleep_TCvoltage_set = temp_to_tcv(150.0f); // 100C
-    _temp_runaway_threshold = 480.0f; // 480C
-
-
-    for (int i = 0; i < _tc_cal_table_size; i++)
-    {
-        float temp = 450.0f * i / (_tc_cal_table_size - 1);
-        _tc_cal_table[i][0] = temp * tc_s;
-        _tc_cal_table[i][1] = temp;
-    }
-
-    return save(response);
-}
+#include "Heater.h"
+#include "parser.h"
+#include "trace.h"
+#include "control.h"
+#include "rtos.h"
+
+/**
+ * @brief save the current tipconfiguration and calibration to memory
+ * 
+ * This function saves the current configuration and calibration data to EEPROM memory.
+ * Assignes to the passed response string the result of the operation as "OK" or "FAIL TO SAVE".
+ * In the coroutine build the save is only requested, the command coroutine replies once the
+ * storage coroutine wrote it.
+ * 
+ * @return true if the operation was successful, false otherwise.
+ */
+bool Heater::save(String &response)
+{
+    bool good_op = storage_request(STORAGE_CONFIG, true);
+    response = good_op ? "OK" : "FAIL TO SAVE";
+    return good_op;
+}
+
+/**
+ * @brief writes an EEPROM block, through the storage task once the RTOS scheduler runs.
+ *
+ * The control tick keeps running during the bus transfers and while waiting for the
+ * storage task, it does not write the configuration.
+ *
+ * @param block The block to write.
+ * @param wait false to only queue the write (RTOS build), true to wait for its result.
+ * @return true if the block was written (or queued), false otherwise.
+ */
+bool Heater::storage_request(HeaterStorage block, bool wait)
+{
+#ifdef JBCLONE_CORO
+    // written by the storage coroutine, see storage_write_async()
+    (void)wait;
+    _storage_pending |= 1 << block;
+    storage_requested.signal();
+    return true;
+#else
+    ControlUnlock unlock;
+#ifdef JBCLONE_RTOS
+    if (rtos_running())
+        return rtos_storage_request(this, block, wait);
+#endif
+    return storage_write(block);
+#endif
+}
+
+/**
+ * @brief writes an EEPROM block, storage task or storage_request() only.
+ *
+ * @param block The block to write.
+ * @return true if the operation was successful, false otherwise.
+ */
+bool Heater::storage_write(HeaterStorage block)
+{
+    if (block == STORAGE_ENERGY)
+        return energy_write();
+    return config_write();
+}
+
+#ifdef JBCLONE_CORO
+CoroEvent Heater::storage_requested;
+
+/**
+ * @brief writes the requested EEPROM blocks, storage coroutine only.
+ *
+ * A block is taken off the request bits before it is written, so a change while it is
+ * written requests it again.
+ *
+ * @return true if every block was written, false otherwise.
+ */
+CoroTask<bool> Heater::storage_write_async()
+{
+    bool good_op = true;
+    while (_storage_pending != 0)
+    {
+        const HeaterStorage block = (_storage_pending & (1 << STORAGE_CONFIG)) ? STORAGE_CONFIG : STORAGE_ENERGY;
+        _storage_pending &= ~(1 << block);
+
+        bool written;
+        if (block == STORAGE_CONFIG)
+            written = co_await config_write_async();
+        else
+            written = co_await energy_write_async();
+        good_op &= written;
+    }
+    co_return good_op;
+}
+
+/**
+ * @brief config_write() as a coroutine, the loop runs during the EEPROM write cycles.
+ *
+ * @return true if the operation was successful, false otherwise.
+ */
+CoroTask<bool> Heater::config_write_async()
+{
+    const uint32_t start_time = config_write_begin();
+
+    bool good_op = true;
+    for (size_t i = 0; good_op && config_slot(i) != nullptr; ++i)
+        good_op = co_await _memory.writeFloatAsync(_start_address + i * sizeof(float), *config_slot(i));
+
+    config_write_end(good_op, start_time);
+    co_return good_op;
+}
+#endif
+
+/**
+ * @brief the float stored at slot index of the configuration block.
+ *
+ * The mapped variables first, then the calibration table row by row; slot i is at
+ * _start_address + i * sizeof(float). Shared by the writes of every build and the load.
+ *
+ * @param index The slot number.
+ * @return the variable of the slot, nullptr past the end of the block.
+ */
+float *Heater::config_slot(size_t index)
+{
+    constexpr size_t num_vars = sizeof(_eeprom_mapped_vars) / sizeof(_eeprom_mapped_vars[0]);
+    if (index < num_vars)
+        return _eeprom_mapped_vars[index];
+
+    index -= num_vars;
+    if (index < 2 * _tc_cal_table_size)
+        return &_tc_cal_table[index / 2][index % 2];
+
+    return nullptr;
+}
+
+/**
+ * @brief traces the start of a configuration write.
+ *
+ * @return the start time to give to config_write_end().
+ */
+uint32_t Heater::config_write_begin()
+{
+    TRACE_EVENT(TRACE_SAVE_START, _channel, 0);
+    return micros();
+}
+
+/**
+ * @brief traces the end of a configuration write and counts it in the health counters.
+ */
+void Heater::config_write_end(bool good_op, uint32_t start_time)
+{
+    TRACE_EVENT(TRACE_SAVE_END, _channel, good_op);
+
+    _health.saves++;
+    _health.save_failures += !good_op;
+    _health.save_time_us = micros() - start_time;
+    if (_health.save_time_us > _health.save_time_us_max)
+        _health.save_time_us_max = _health.save_time_us;
+}
+
+/**
+ * @brief writes the mapped variables and the thermocouple calibration table.
+ *
+ * @return true if the operation was successful, false otherwise.
+ */
+bool Heater::config_write()
+{
+    const uint32_t start_time = config_write_begin();
+
+    // stops at the first failure, each further write would wait out the ACK polling timeout
+    bool good_op = true;
+    for (size_t i = 0; good_op && config_slot(i) != nullptr; ++i)
+        good_op = _memory.writeFloat(_start_address + i * sizeof(float), *config_slot(i));
+
+    config_write_end(good_op, start_time);
+    return good_op;
+}
+
+/**
+ * @brief load the current tipconfiguration and calibration from memory
+ * 
+ * This function loads the configuration and calibration data from EEPROM memory.
+ * 
+ * @return true if the operation was successful, false otherwise.
+ */
+bool Heater::load_memory()
+{
+    bool good_op = true;
+    for (size_t i = 0; config_slot(i) != nullptr; ++i)
+        good_op &= _memory.readFloat(_start_address + i * sizeof(float), *config_slot(i));
+
+    if (good_op)
+        _temp_sp = tcv_to_temp(_pid_TCvoltage_sp);
+
+    return good_op;
+}
+
+/**
+ * * @brief Restore default configuration and calibration values.
+ * 
+ * This function restores the default configuration and calibration values for the heater.
+ * The default values are:
+ * - Thermocouple S[uV/K]: 0.0 to 40.0
+ * - Temperature setpoint range: 100.0 to 400.0
+ * - Temperature setpoint: 100.0, the lower end of the range
+ * - PID gains: kp = 0.0, ti = 0.0, td = 0.0
+ * - Derivative filter time constant: 0.25s
+ * - Sleep delay: 30s
+ * - Sleep temperature setpoint: 150.0C
+ * - Thermocouple calibration table: linear interpolation between 0 and 450C
+ * @param cmd The command string containing the thermocouple S[uV/K] value.
+ * @param response The response string to be sent back to the caller.
+ * @return true if the operation was successful, false otherwise.
+ * @note The function also saves the new configuration to EEPROM memory.
+ * @warning The function will overwrite the current configuration and calibration values.
+ */
+bool Heater::restore_default_config(String &cmd, String &response)
+{
+    float tc_s;
+    bool valid = parseFloat(cmd, tc_s);
+    if (!valid)
+    {
+        response = "invalid thermocouple S[uV/K]";
+        return false;
+    }
+
+    if (tc_s <= 0 || tc_s > 40.0f)
+    {
+        response = "S[uV/K] outside of range";
+        return false;
+    }
+
+    _temp_sp_min = 100.0f;
+    _temp_sp_max = 400.0f;
+
+    _pid_kp = 0.0f;
+    _pid_ki = 0.0f;
+    _pid_kd = 0.0f;
+    _pid_derivative_filter_tau = 0.25f;
+
+    _sleep_delay = 30000.0f; // 30s
+    _temp_runaway_threshold = 480.0f; // 480C
+
+
+    for (int i = 0; i < _tc_cal_table_size; i++)
+    {
+        float temp = 450.0f * i / (_tc_cal_table_size - 1);
+        _tc_cal_table[i][0] = temp * tc_s;
+        _tc_cal_table[i][1] = temp;
+    }
+
+    // setpoints in uV from the new table
+    _temp_sp = _temp_sp_min;
+    _pid_TCvoltage_sp = temp_to_tcv(_temp_sp);
+    _sleep_TCvoltage_set = temp_to_tcv(150.0f); // 150C
+    setpoint_changed();
+
+    return save(response);
+}
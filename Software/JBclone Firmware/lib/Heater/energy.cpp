@@ -0,0 +1,200 @@
+#include "Heater.h"
+#include "Hardware.h"
+#include "parser.h"
+#include <math.h>
+
+constexpr float _uj_per_wh = 3.6e9f;
+
+/**
+ * @brief drains the half-cycle counters of the zero cross ISR into the energy totals.
+ *
+ * Each conducting half-cycle accounts for heater power * mains half-cycle.
+ * The lifetime total is written to EEPROM once the unsaved part exceeds _energy_save_threshold_wh.
+ */
+void Heater::energy_update()
+{
+    // 32 bit reads are atomic, the ISR only increments
+    const uint32_t on = _energy_halfcycles_on;
+    const uint32_t total = _energy_halfcycles_total;
+    const uint32_t delta_on = on - _energy_drained_on;
+    const uint32_t delta_total = total - _energy_drained_total;
+    _energy_drained_on = on;
+    _energy_drained_total = total;
+
+    if (delta_total == 0)
+        return;
+
+    _session_halfcycles_on += delta_on;
+    _session_halfcycles_total += delta_total;
+
+    // mW * us = nJ
+    const uint64_t energy_uj = (uint64_t)delta_on * (uint32_t)(_heater_power * 1000.0f) * _mains_half_cycle_us / 1000;
+    _session_energy_uj += energy_uj;
+    _lifetime_unsaved_uj += energy_uj;
+
+    if (_lifetime_unsaved_uj >= (uint64_t)(_energy_save_threshold_wh * _uj_per_wh))
+        energy_save(false);
+}
+
+/**
+ * @brief adds the unsaved energy to the lifetime total and writes the energy record.
+ *
+ * @param wait false to only queue the write in the RTOS build.
+ * @return true if the operation was successful, false otherwise.
+ */
+bool Heater::energy_save(bool wait)
+{
+    _lifetime_energy_wh += _lifetime_unsaved_uj / _uj_per_wh;
+    _lifetime_unsaved_uj = 0;
+
+    return storage_request(STORAGE_ENERGY, wait);
+}
+
+/**
+ * @brief writes heater power and lifetime energy.
+ *
+ * @return true if the operation was successful, false otherwise.
+ */
+bool Heater::energy_write()
+{
+    bool good_op = true;
+    good_op &= _memory.writeFloat(_energy_address, _heater_power);
+    good_op &= _memory.writeFloat(_energy_address + sizeof(float), _lifetime_energy_wh);
+    return good_op;
+}
+
+#ifdef JBCLONE_CORO
+/**
+ * @brief energy_write() as a coroutine, storage coroutine only.
+ *
+ * @return true if the operation was successful, false otherwise.
+ */
+CoroTask<bool> Heater::energy_write_async()
+{
+    bool good_op = co_await _memory.writeFloatAsync(_energy_address, _heater_power);
+    bool written = co_await _memory.writeFloatAsync(_energy_address + sizeof(float), _lifetime_energy_wh);
+    co_return good_op && written;
+}
+#endif
+
+/**
+ * @brief loads heater power and lifetime energy, blank or invalid records read as zero.
+ *
+ * @return true if the operation was successful, false otherwise.
+ */
+bool Heater::energy_load()
+{
+    bool good_op = true;
+    good_op &= _memory.readFloat(_energy_address, _heater_power);
+    good_op &= _memory.readFloat(_energy_address + sizeof(float), _lifetime_energy_wh);
+
+    if (!good_op || isnan(_heater_power) || _heater_power < 0.0f)
+        _heater_power = 0.0f;
+    if (!good_op || isnan(_lifetime_energy_wh) || _lifetime_energy_wh < 0.0f)
+        _lifetime_energy_wh = 0.0f;
+
+    return good_op;
+}
+
+/**
+ * @brief energy and duty accounting command handler.
+ *
+ * The command format is as follows:
+ * - To get the value: ?
+ *   on=half-cycles,total=half-cycles,duty=percent,session_wh=x,session_s=x,lifetime_wh=x
+ *   duty is over the output half-cycles, sampling half-cycles excluded
+ * - To reset the session totals: reset
+ * - To reset the lifetime total after a cartridge swap: reset_lifetime
+ * - To write the lifetime total now: save
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool Heater::energy(String &cmd, String &response)
+{
+    energy_update();
+
+    if (cmd == "?")
+    {
+        float duty = _session_halfcycles_total > 0 ? 100.0f * _session_halfcycles_on / _session_halfcycles_total : 0.0f;
+        float lifetime = _lifetime_energy_wh + _lifetime_unsaved_uj / _uj_per_wh;
+        response = "on=" + String(_session_halfcycles_on);
+        response += ",total=" + String(_session_halfcycles_total);
+        response += ",duty=" + String(duty, 1);
+        response += ",session_wh=" + String(_session_energy_uj / _uj_per_wh, 3);
+        response += ",session_s=" + String((millis() - _session_start_timestamp) / 1000);
+        response += ",lifetime_wh=" + String(lifetime, 1);
+        return true;
+    }
+
+    if (cmd == "reset")
+    {
+        _session_halfcycles_on = 0;
+        _session_halfcycles_total = 0;
+        _session_energy_uj = 0;
+        _session_start_timestamp = millis();
+        response = "OK";
+        return true;
+    }
+
+    if (cmd == "reset_lifetime")
+    {
+        _lifetime_energy_wh = 0.0f;
+        _lifetime_unsaved_uj = 0;
+    }
+    else if (cmd != "save")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    bool good_op = energy_save();
+    response = good_op ? "OK" : "FAIL TO SAVE";
+    return good_op;
+}
+
+/**
+ * @brief heater power command handler.
+ *
+ * Nominal cartridge power used to convert conducting half-cycles to energy.
+ * The command format is as follows:
+ * - To get the value: ?
+ * - To set the value: power (in W)
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool Heater::heater_power(String &cmd, String &response)
+{
+    // getter
+    if (cmd == "?")
+    {
+        response = String(_heater_power, 1);
+        return true;
+    }
+
+    // try parse
+    float new_value;
+    bool valid = parseFloat(cmd, new_value);
+    if (!valid)
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    if (new_value < 0.0f || new_value > 1000.0f)
+    {
+        response = "value outside of range 0-1000";
+        return false;
+    }
+
+    // account the past half-cycles at the old power
+    energy_update();
+    _heater_power = new_value;
+
+    bool good_op = energy_save();
+    response = good_op ? "OK" : "FAIL TO SAVE";
+    return good_op;
+}
@@ -0,0 +1,51 @@
+#ifndef __running_stats_H__
+#define __running_stats_H__
+
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * @brief streaming mean, variance, min and max (Welford), O(1) memory.
+ */
+struct RunningStats
+{
+    uint32_t n;
+    float mean;
+    float m2;
+    float min;
+    float max;
+
+    void reset()
+    {
+        n = 0;
+        mean = 0.0f;
+        m2 = 0.0f;
+        min = INFINITY;
+        max = -INFINITY;
+    }
+
+    void add(float x)
+    {
+        n++;
+        const float delta = x - mean;
+        mean += delta / n;
+        m2 += delta * (x - mean);
+
+        if (x < min)
+            min = x;
+        if (x > max)
+            max = x;
+    }
+
+    float variance() const
+    {
+        return n > 1 ? m2 / (n - 1) : 0.0f;
+    }
+
+    float stddev() const
+    {
+        return sqrtf(variance());
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "Heater.h"
+#include <string.h>
+
+static_assert(sizeof(Heater::Snapshot) == 200, "Heater::Snapshot layout is part of the recording format");
+
+/**
+ * @brief copies the control state of the heater.
+ *
+ * Everything that decides the PID output, the heater output and the state machine is
+ * captured: configuration, PID memory, pending sample and timestamps. Statistics,
+ * energy and health counters are not.
+ *
+ * @param snapshot The destination.
+ */
+void Heater::snapshot_save(Snapshot &snapshot) const
+{
+    static_assert(sizeof(snapshot.tc_cal_table) == sizeof(_tc_cal_table), "calibration table size mismatch");
+
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    snapshot.temp_sp_min = _temp_sp_min;
+    snapshot.temp_sp_max = _temp_sp_max;
+    snapshot.temp_runaway_threshold = _temp_runaway_threshold;
+    snapshot.temp_sp = _temp_sp;
+    snapshot.temp_pv = _temp_pv;
+    memcpy(snapshot.tc_cal_table, _tc_cal_table, sizeof(snapshot.tc_cal_table));
+    snapshot.tc_max_voltage_setpoint = _tc_max_voltage_setpoint;
+    snapshot.tc_gain = _tc_gain;
+
+    snapshot.pid_kp = _pid_kp;
+    snapshot.pid_ki = _pid_ki;
+    snapshot.pid_integral = _pid_integral;
+    snapshot.pid_kd = _pid_kd;
+    snapshot.pid_derivative_prev_e_t = _pid_derivative_prev_e_t;
+    snapshot.pid_derivative_filter_tau = _pid_derivative_filter_tau;
+    snapshot.pid_TCvoltage_sp = _pid_TCvoltage_sp;
+    snapshot.pid_output = _pid_output;
+    snapshot.pid_TCvoltage_pv = _pid_TCvoltage_pv;
+    snapshot.regulation_sp_temp = _regulation_sp_temp;
+    snapshot.open_loop_duty = _open_loop_duty;
+    snapshot.sleep_delay = _sleep_delay;
+    snapshot.sleep_TCvoltage_set = _sleep_TCvoltage_set;
+
+    snapshot.sample_schedule_timestamp = _sample_Schedule_timestamp;
+    snapshot.pv_old_timestamp = _pid_TCvoltsge_pv_old_timestamp;
+    snapshot.pv_timestamp = _pid_TCvoltage_pv_timestamp;
+    snapshot.state_timestamp = _state_timestamp;
+    snapshot.dip_timestamp = _dip_timestamp;
+    snapshot.sleep_delay_start_time = _sleep_delay_start_time;
+    snapshot.heating_check_timestamp = _heating_check_timestamp;
+    snapshot.heating_check_temp = _heating_check_temp;
+
+    snapshot.state = _state;
+    snapshot.sample_scheduled = _sample_scheduled;
+    snapshot.pid_update_pending = _pid_update_pending;
+    snapshot.output_state = _output_state;
+    snapshot.dip_active = _dip_active;
+    snapshot.sleep_delay_running = _sleep_delay_running;
+    snapshot.fault = _fault;
+    snapshot.heating_check_active = _heating_check_active;
+}
+
+/**
+ * @brief restores the control state saved by snapshot_save().
+ *
+ * @param snapshot The source.
+ */
+void Heater::snapshot_load(const Snapshot &snapshot)
+{
+    _temp_sp_min = snapshot.temp_sp_min;
+    _temp_sp_max = snapshot.temp_sp_max;
+    _temp_runaway_threshold = snapshot.temp_runaway_threshold;
+    _temp_sp = snapshot.temp_sp;
+    _temp_pv = snapshot.temp_pv;
+    memcpy(_tc_cal_table, snapshot.tc_cal_table, sizeof(_tc_cal_table));
+    _tc_max_voltage_setpoint = snapshot.tc_max_voltage_setpoint;
+    _tc_gain = snapshot.tc_gain;
+
+    _pid_kp = snapshot.pid_kp;
+    _pid_ki = snapshot.pid_ki;
+    _pid_integral = snapshot.pid_integral;
+    _pid_kd = snapshot.pid_kd;
+    _pid_derivative_prev_e_t = snapshot.pid_derivative_prev_e_t;
+    _pid_derivative_filter_tau = snapshot.pid_derivative_filter_tau;
+    _pid_TCvoltage_sp = snapshot.pid_TCvoltage_sp;
+    _pid_output = snapshot.pid_output;
+    _pid_TCvoltage_pv = snapshot.pid_TCvoltage_pv;
+    _regulation_sp_temp = snapshot.regulation_sp_temp;
+    _open_loop_duty = snapshot.open_loop_duty;
+    _sleep_delay = snapshot.sleep_delay;
+    _sleep_TCvoltage_set = snapshot.sleep_TCvoltage_set;
+
+    _sample_Schedule_timestamp = snapshot.sample_schedule_timestamp;
+    _pid_TCvoltsge_pv_old_timestamp = snapshot.pv_old_timestamp;
+    _pid_TCvoltage_pv_timestamp = snapshot.pv_timestamp;
+    _state_timestamp = snapshot.state_timestamp;
+    _dip_timestamp = snapshot.dip_timestamp;
+    _sleep_delay_start_time = snapshot.sleep_delay_start_time;
+    _heating_check_timestamp = snapshot.heating_check_timestamp;
+    _heating_check_temp = snapshot.heating_check_temp;
+
+    _state = (HeaterState)snapshot.state;
+    _sample_scheduled = snapshot.sample_scheduled;
+    // window numbers restart, a pending sample keeps the output held off
+    _sample_window = _sample_scheduled ? 1 : 0;
+    _sample_ack = 0;
+    _sample_request = _sample_window;
+    _pid_update_pending = snapshot.pid_update_pending;
+    _output_state = snapshot.output_state;
+    _dip_active = snapshot.dip_active;
+    _sleep_delay_running = snapshot.sleep_delay_running;
+    _fault = (HeaterFault)snapshot.fault;
+    _heating_check_active = snapshot.heating_check_active;
+}
@@ -0,0 +1,260 @@
+#include "Heater.h"
+#include "Hardware.h"
+#include "recorder.h"
+#include <math.h>
+
+static const char *state_names[] = {"OFF", "HEATING", "REGULATING", "SLEEP", "WAKING", "FAULT", "OPEN_LOOP"};
+static const char *fault_names[] = {"none", "runaway", "tc_open", "no_heating", "zero_cross"};
+
+/**
+ * @brief checks if the output is allowed to conduct.
+ *
+ * @return true in HEATING, REGULATING, SLEEP, WAKING and OPEN_LOOP states.
+ */
+bool Heater::is_enabled() const
+{
+    return _state != HEATER_OFF && _state != HEATER_FAULT;
+}
+
+/**
+ * @brief moves the state machine to a new state and timestamps the transition.
+ *
+ * @param new_state The new state.
+ */
+void Heater::state_set(HeaterState new_state)
+{
+    if (new_state == _state)
+        return;
+
+    _state = new_state;
+    _state_timestamp = millis();
+    RECORD_STATE(_channel, new_state);
+    _dip_active = false;
+}
+
+/**
+ * @brief moves the channel to FAULT and turns the output off.
+ *
+ * The first cause is kept until the channel is enabled again.
+ *
+ * @param reason The cause, reported by the state command.
+ */
+void Heater::fault(HeaterFault reason)
+{
+    if (_state != HEATER_FAULT)
+        _fault = reason;
+    state_set(HEATER_FAULT);
+    pid_reset();
+    _heating_check_active = false;
+    digitalWrite(_heater_pin, LOW);
+}
+
+/**
+ * @brief drives the output at a fixed duty, bypassing PID and stand detection.
+ *
+ * Runaway protection stays active in pid_sample() and moves the channel to FAULT.
+ *
+ * @param duty The output duty, 0-1.
+ */
+void Heater::open_loop_start(float duty)
+{
+    pid_reset();
+    _sleep_delay_running = false;
+    _open_loop_duty = constrain(duty, _pid_output_min, _pid_output_max);
+    _pid_output = _open_loop_duty;
+    state_set(HEATER_OPEN_LOOP);
+}
+
+/**
+ * @brief ends an open loop run, the channel is left OFF.
+ */
+void Heater::open_loop_stop()
+{
+    if (_state != HEATER_OPEN_LOOP)
+        return;
+
+    state_set(HEATER_OFF);
+    pid_reset();
+}
+
+/**
+ * @brief handles a change of the effective setpoint.
+ *
+ * Restarts the regulation statistics; a regulating channel has to reach the band again.
+ */
+void Heater::setpoint_changed()
+{
+    _regulation_sp_temp = NAN;
+    stats_reset();
+    if (_state == HEATER_REGULATING)
+        state_set(HEATER_HEATING);
+}
+
+/**
+ * @brief returns the regulation error SP - PV in C against the effective setpoint.
+ */
+float Heater::regulation_error()
+{
+    if (isnan(_regulation_sp_temp))
+        _regulation_sp_temp = _state == HEATER_SLEEP ? tcv_to_temp(_sleep_TCvoltage_set) : _temp_sp;
+
+    return _regulation_sp_temp - _temp_pv;
+}
+
+/**
+ * @brief band transitions of the state machine, called after each PID step.
+ *
+ * - HEATING -> REGULATING records the time to band since enable or setpoint change.
+ * - WAKING -> REGULATING records the wake time since the tip was lifted.
+ * - in REGULATING a PV below the band starts a load dip, the time back to the band is recorded.
+ *
+ * @param error The regulation error SP - PV in C.
+ */
+void Heater::state_regulation_update(float error)
+{
+    const bool in_band = fabsf(error) <= _regulation_band_temp;
+    const uint32_t now = millis();
+
+    switch (_state)
+    {
+    case HEATER_HEATING:
+        if (in_band)
+        {
+            _history_heatup.add(now - _state_timestamp);
+            state_set(HEATER_REGULATING);
+        }
+        break;
+
+    case HEATER_WAKING:
+        if (in_band)
+        {
+            _history_wake.add(now - _state_timestamp);
+            state_set(HEATER_REGULATING);
+        }
+        break;
+
+    case HEATER_REGULATING:
+        if (!_dip_active && error > _regulation_band_temp)
+        {
+            _dip_active = true;
+            _dip_timestamp = now;
+        }
+        else if (_dip_active && in_band)
+        {
+            _history_recovery.add(now - _dip_timestamp);
+            _dip_active = false;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief heating watchdog, called after each PID step.
+ *
+ * With the output saturated and the PV more than _heating_watchdog_error below the
+ * setpoint, the PV has to rise by _heating_watchdog_rise every _heating_watchdog_time,
+ * otherwise the thermocouple does not see the heater (shorted or out of the tip) and the
+ * channel goes to FAULT. The error gate keeps heavy loads while regulating out of it.
+ *
+ * @param error The regulation error SP - PV in C.
+ */
+void Heater::heating_watchdog_update(float error)
+{
+    if (_pid_output < _pid_output_max || error < _heating_watchdog_error)
+    {
+        _heating_check_active = false;
+        return;
+    }
+
+    const uint32_t now = millis();
+    if (!_heating_check_active || _temp_pv >= _heating_check_temp + _heating_watchdog_rise)
+    {
+        _heating_check_active = true;
+        _heating_check_timestamp = now;
+        _heating_check_temp = _temp_pv;
+        return;
+    }
+
+    if (now - _heating_check_timestamp > _heating_watchdog_time)
+        fault(FAULT_NO_HEATING);
+}
+
+/**
+ * @brief heater state command handler.
+ *
+ * The command format is as follows:
+ * - To get the value: ?
+ *   response STATE,ms where ms is the time spent in the current state,
+ *   FAULT,ms,cause in FAULT
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool Heater::state(String &cmd, String &response)
+{
+    if (cmd == "?")
+    {
+        response = String(state_names[_state]) + "," + String(millis() - _state_timestamp);
+        if (_state == HEATER_FAULT)
+            response += "," + String(fault_names[_fault]);
+        return true;
+    }
+    response = "command is read only";
+    return false;
+}
+
+static void timing_print(String &response, const char *name, const uint32_t *ms, uint8_t count, uint8_t next, size_t size)
+{
+    response += String(name) + "=";
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (i > 0)
+            response += "/";
+        response += String(ms[(next + size - 1 - i) % size]);
+    }
+}
+
+/**
+ * @brief transition timing command handler.
+ *
+ * Reports the last transition durations in ms, newest first:
+ * time to band after enable or setpoint change, wake time from stand lift,
+ * recovery time after a load dip while regulating.
+ * The command format is as follows:
+ * - To get the value: ?
+ *   heatup=ms/ms/...,wake=...,recovery=...
+ * - To clear the histories: clear
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool Heater::timing(String &cmd, String &response)
+{
+    if (cmd == "clear")
+    {
+        _history_heatup = {};
+        _history_wake = {};
+        _history_recovery = {};
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    response = "";
+    timing_print(response, "heatup", _history_heatup.ms, _history_heatup.count, _history_heatup.next, _timing_history_size);
+    response += ",";
+    timing_print(response, "wake", _history_wake.ms, _history_wake.count, _history_wake.next, _timing_history_size);
+    response += ",";
+    timing_print(response, "recovery", _history_recovery.ms, _history_recovery.count, _history_recovery.next, _timing_history_size);
+    return true;
+}
@@ -0,0 +1,101 @@
+#include "Heater.h"
+#include "Hardware.h"
+#include <math.h>
+
+/**
+ * @brief restarts the regulation statistics.
+ *
+ * Called on explicit reset and whenever the effective setpoint changes
+ * (setpoint commands, enable, sleep transitions).
+ */
+void Heater::stats_reset()
+{
+    _stats_transient.reset();
+    _stats_settled.reset();
+}
+
+/**
+ * @brief adds a PID step to the regulation statistics.
+ *
+ * Samples go to the settled window while the channel is REGULATING,
+ * to the transient window otherwise.
+ *
+ * @param dt The PID step interval in seconds.
+ * @param error The regulation error SP - PV in C.
+ */
+void Heater::stats_update(float dt, float error)
+{
+    const bool in_band = fabsf(error) <= _regulation_band_temp;
+
+    RegulationWindow &window = _state == HEATER_REGULATING ? _stats_settled : _stats_transient;
+    window.error.add(error);
+    window.duty.add(_pid_output);
+    window.interval.add(dt * 1000.0f);
+    window.time_total += dt;
+    if (in_band)
+        window.time_in_band += dt;
+}
+
+static void stats_print(String &response, const char *name, const RunningStats &stats)
+{
+    response += String(name) + "=";
+    if (stats.n == 0)
+    {
+        response += "nan";
+        return;
+    }
+    response += String(stats.mean, 3) + "/" + String(stats.stddev(), 3) + "/";
+    response += String(stats.min, 3) + "/" + String(stats.max, 3);
+}
+
+/**
+ * @brief regulation statistics command handler.
+ *
+ * Reports statistics of PV error [C], output duty [0-1] and sample interval [ms]
+ * since the last reset or setpoint change, split in transient (heating, waking)
+ * and settled (regulating) windows.
+ * The command format is as follows:
+ * - To get the value: ?
+ *   settled:n=x,err=mean/sd/min/max,duty=...,dt_ms=...,in_band=percent;transient:...
+ * - To reset the statistics: reset
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool Heater::stats(String &cmd, String &response)
+{
+    if (cmd == "reset")
+    {
+        stats_reset();
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    response = "";
+    const char *names[] = {"settled", "transient"};
+    const RegulationWindow *windows[] = {&_stats_settled, &_stats_transient};
+    for (int i = 0; i < 2; i++)
+    {
+        const RegulationWindow &window = *windows[i];
+        if (i > 0)
+            response += ";";
+        response += String(names[i]) + ":n=" + String(window.error.n) + ",";
+        stats_print(response, "err", window.error);
+        response += ",";
+        stats_print(response, "duty", window.duty);
+        response += ",";
+        stats_print(response, "dt_ms", window.interval);
+
+        float in_band = window.time_total > 0.0f ? 100.0f * window.time_in_band / window.time_total : 0.0f;
+        response += ",in_band=" + String(in_band, 1);
+    }
+
+    return true;
+}
@@ -0,0 +1,308 @@
+#include "control.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "rtos.h"
+#include "zc_timing.h"
+
+// TIM1 captures the zero cross edges, TIM4 has no pin in use
+#define CONTROL_TIMER TIM4
+#define CONTROL_TIMER_IRQ TIM4_IRQn
+
+constexpr size_t control_histogram_bins = 12;
+
+static HardwareTimer *control_timer = nullptr;
+
+// tick side, written by the tick only
+static uint32_t control_histogram[control_histogram_bins];
+static uint32_t control_tick_worst_cycles = 0;
+static uint32_t control_phase_worst_cycles[CONTROL_PHASE_COUNT];
+static uint32_t control_rest_worst_cycles = 0;
+static uint32_t control_ticks = 0;
+static uint32_t control_late_ticks = 0;
+static uint32_t control_overruns = 0;
+
+static uint32_t control_enter_cycles = 0;
+static uint32_t control_last_enter_cycles = 0;
+static uint32_t control_phase_cycles = 0; // phases of the running tick
+
+// loop side, in the RTOS build the lock owner task only
+static uint8_t control_lock_depth = 0;
+static uint32_t control_lock_cycles = 0;
+static uint32_t control_lock_worst_cycles = 0;
+
+static uint32_t control_cycles_to_ns(uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)cycles * 1000000000ULL / F_CPU);
+}
+
+/**
+ * @brief starts the control tick, every _control_tick_us.
+ *
+ * @note Call at the end of setup(), the tick uses the heaters.
+ *
+ * @param tick The control tick service routine.
+ */
+void control_init(void (*tick)())
+{
+    if (control_timer == nullptr)
+        control_timer = new HardwareTimer(CONTROL_TIMER);
+
+    control_lock_depth = 0;
+    control_last_enter_cycles = 0;
+#ifdef JBCLONE_RTOS
+    rtos_control_mutex_init();
+#endif
+
+    control_timer->pause();
+    control_timer->setOverflow(_control_tick_us, MICROSEC_FORMAT);
+    control_timer->attachInterrupt(tick);
+    control_timer->setInterruptPriority(_control_tick_irq_priority, 0);
+    control_timer->resume();
+}
+
+/**
+ * @brief tick start, also counts the ticks lost while it was masked or overran.
+ */
+void control_tick_enter()
+{
+    control_enter_cycles = cycle_counter_read();
+    control_phase_cycles = 0;
+
+    // a period and a half without a tick: the pending interrupt collapsed some
+    constexpr uint32_t period_cycles = (uint32_t)((uint64_t)_control_tick_us * F_CPU / 1000000ULL);
+    if (control_last_enter_cycles != 0)
+    {
+        const uint32_t since = control_enter_cycles - control_last_enter_cycles;
+        if (since > period_cycles + period_cycles / 2)
+            control_late_ticks += (since + period_cycles / 2) / period_cycles - 1;
+    }
+    control_last_enter_cycles = control_enter_cycles;
+}
+
+/**
+ * @brief tick end, execution time histogram, worst tick and worst fixed path.
+ */
+void control_tick_exit()
+{
+    constexpr uint32_t period_cycles = (uint32_t)((uint64_t)_control_tick_us * F_CPU / 1000000ULL);
+    const uint32_t cycles = cycle_counter_read() - control_enter_cycles;
+
+    size_t bin = 0;
+    uint32_t limit = 500;
+    const uint32_t ns = control_cycles_to_ns(cycles);
+    while (bin < control_histogram_bins - 1 && ns >= limit)
+    {
+        limit <<= 1;
+        bin++;
+    }
+    control_histogram[bin]++;
+
+    if (cycles > control_tick_worst_cycles)
+        control_tick_worst_cycles = cycles;
+    const uint32_t rest = cycles > control_phase_cycles ? cycles - control_phase_cycles : 0;
+    if (rest > control_rest_worst_cycles)
+        control_rest_worst_cycles = rest;
+    control_overruns += cycles >= period_cycles;
+    control_ticks++;
+}
+
+/**
+ * @brief the running tick was stretched on purpose past its measured part (scope capture),
+ * the ticks it held off are not late ones.
+ *
+ * @note Call from the control tick only, after control_tick_exit().
+ */
+void control_tick_stretched()
+{
+    control_last_enter_cycles = 0;
+}
+
+/**
+ * @brief adds one phase execution to the running tick.
+ *
+ * @note Call from the control tick only, see ControlPhaseTiming.
+ */
+void control_phase_add(ControlPhase phase, uint32_t cycles)
+{
+    control_phase_cycles += cycles;
+    if (cycles > control_phase_worst_cycles[phase])
+        control_phase_worst_cycles[phase] = cycles;
+}
+
+/**
+ * @brief masks the control tick, a tick due meanwhile runs at control_unlock().
+ *
+ * @note Call from the main loop only, calls nest. In the RTOS build any task may call it,
+ * the tasks take the control mutex first so the lock has one owner at a time.
+ */
+void control_lock()
+{
+#ifdef JBCLONE_RTOS
+    rtos_control_mutex_take();
+#endif
+    if (control_lock_depth++ == 0)
+    {
+        NVIC_DisableIRQ(CONTROL_TIMER_IRQ);
+        control_lock_cycles = cycle_counter_read();
+    }
+}
+
+/**
+ * @brief ends a control_lock(), the tick runs again when the outermost one ends.
+ */
+void control_unlock()
+{
+    if (control_lock_depth == 0)
+        return;
+
+    if (--control_lock_depth == 0)
+    {
+        const uint32_t held = cycle_counter_read() - control_lock_cycles;
+        if (held > control_lock_worst_cycles)
+            control_lock_worst_cycles = held;
+        NVIC_EnableIRQ(CONTROL_TIMER_IRQ);
+    }
+#ifdef JBCLONE_RTOS
+    rtos_control_mutex_give();
+#endif
+}
+
+/**
+ * @brief drops every lock level, for work that must not hold off the tick (bus transfers).
+ *
+ * @return the lock depth to give back to control_reacquire().
+ */
+uint8_t control_release()
+{
+#ifdef JBCLONE_RTOS
+    // the depth is the owner's, another task may hold the lock
+    if (!rtos_control_mutex_owned())
+        return 0;
+#endif
+    // level by level, every level holds the control mutex once in the RTOS build
+    const uint8_t depth = control_lock_depth;
+    for (uint8_t i = 0; i < depth; i++)
+        control_unlock();
+    return depth;
+}
+
+/**
+ * @brief takes back the lock levels dropped by control_release().
+ */
+void control_reacquire(uint8_t depth)
+{
+    for (uint8_t i = 0; i < depth; i++)
+        control_lock();
+}
+
+/**
+ * @brief response time of the tick with zero cross ISR preemption, R of control.h.
+ *
+ * Iterated to its fixed point, or until R is past the tick period: edges closer than the
+ * ISR time never converge.
+ *
+ * @param exec_ns Execution time of the tick alone.
+ * @param isr_ns Execution time of one zero cross ISR.
+ * @param spacing_ns Shortest time between two zero cross edges.
+ * @param isr_arrivals The edges counted in R.
+ * @return R in ns, above the tick period if the tick does not fit.
+ */
+uint32_t control_response_bound_ns(uint32_t exec_ns, uint32_t isr_ns, uint32_t spacing_ns, uint32_t &isr_arrivals)
+{
+    const uint32_t budget_ns = _control_tick_us * 1000;
+    isr_arrivals = 1;
+    uint32_t bound_ns = exec_ns + isr_ns;
+    while (bound_ns <= budget_ns)
+    {
+        const uint32_t arrivals = (bound_ns + spacing_ns - 1) / spacing_ns;
+        if (arrivals <= isr_arrivals)
+            break;
+        isr_arrivals = arrivals;
+        bound_ns = exec_ns + isr_arrivals * isr_ns;
+    }
+    return bound_ns;
+}
+
+/**
+ * @brief control tick command handler.
+ *
+ * The command format is as follows:
+ * - To get the statistics: ?
+ * - To clear histogram and worst case values: clear
+ *
+ * Response: exec_ns:worst=x,bins=b0/b1/...;event_ns=x;sample_ns=x;compute_ns=x;rest_ns=x;
+ * isr_ns=x;isr_arrivals=x;measured_bound_ns=x;budget_ns=x;ticks=x;late=x;overrun=x;lock_worst_ns=x
+ * event, sample and compute are the worst single execution of the phase, isr_ns the worst
+ * zero cross ISR and isr_arrivals the edges counted in the response time. The bound is
+ * R of control.h, from measured times, not a WCET. late counts ticks lost while masked or
+ * behind, overrun the ticks that took a whole period.
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool control_cli(String &cmd, String &response)
+{
+    if (cmd == "clear")
+    {
+        memset(control_histogram, 0, sizeof(control_histogram));
+        memset(control_phase_worst_cycles, 0, sizeof(control_phase_worst_cycles));
+        control_tick_worst_cycles = 0;
+        control_rest_worst_cycles = 0;
+        control_ticks = 0;
+        control_late_ticks = 0;
+        control_overruns = 0;
+        control_lock_worst_cycles = 0;
+
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    // commands run under ControlLock, the tick side values are stable here
+    const uint32_t event_ns = control_cycles_to_ns(control_phase_worst_cycles[CONTROL_PHASE_EVENT]);
+    const uint32_t sample_ns = control_cycles_to_ns(control_phase_worst_cycles[CONTROL_PHASE_SAMPLE]);
+    const uint32_t compute_ns = control_cycles_to_ns(control_phase_worst_cycles[CONTROL_PHASE_COMPUTE]);
+    const uint32_t rest_ns = control_cycles_to_ns(control_rest_worst_cycles);
+    const uint32_t exec_ns = rest_ns + _control_events_per_tick * event_ns + _heater_count * (sample_ns + compute_ns);
+    const uint32_t budget_ns = _control_tick_us * 1000;
+    const uint32_t isr_ns = zc_timing_exec_worst_ns();
+    const uint32_t period_min_ns = zc_timing_period_min_ns();
+    const uint32_t spacing_ns = period_min_ns != 0 ? period_min_ns : _mains_half_cycle_us * 1000;
+    uint32_t isr_arrivals;
+    const uint32_t bound_ns = control_response_bound_ns(exec_ns, isr_ns, spacing_ns, isr_arrivals);
+
+    response = "exec_ns:worst=" + String(control_cycles_to_ns(control_tick_worst_cycles)) + ",bins=";
+    for (size_t i = 0; i < control_histogram_bins; i++)
+    {
+        if (i > 0)
+            response += "/";
+        response += String(control_histogram[i]);
+    }
+    response += ";event_ns=" + String(event_ns);
+    response += ";sample_ns=" + String(sample_ns);
+    response += ";compute_ns=" + String(compute_ns);
+    response += ";rest_ns=" + String(rest_ns);
+    response += ";isr_ns=" + String(isr_ns);
+    response += ";isr_arrivals=" + String(isr_arrivals);
+    response += ";measured_bound_ns=" + String(bound_ns);
+    response += ";budget_ns=" + String(budget_ns);
+    response += ";ticks=" + String(control_ticks);
+    response += ";late=" + String(control_late_ticks);
+    response += ";overrun=" + String(control_overruns);
+    response += ";lock_worst_ns=" + String(control_cycles_to_ns(control_lock_worst_cycles));
+    return true;
+}
+
+/**
+ * @brief static RAM used by the control tick statistics.
+ */
+size_t control_ram_usage()
+{
+    return sizeof(control_histogram) + sizeof(control_phase_worst_cycles);
+}
@@ -0,0 +1,105 @@
+#ifndef __control_H__
+#define __control_H__
+
+#include <Arduino.h>
+#include "cycle_counter.h"
+
+/**
+ * @file control.h
+ * @brief fixed rate control context and a measured bound of its response time.
+ *
+ * A timer update interrupt every _control_tick_us runs the control work: zero cross events,
+ * zero cross watchdog, thermocouple sampling, conversion and PID of every heater. Of the
+ * firmware interrupts only the zero cross ISR preempts it, the core's own (SysTick, USB,
+ * USART, I2C) are above it too; communications, HMI and EEPROM stay in the main loop.
+ * The loop masks the tick with ControlLock while it changes control state, an EEPROM save
+ * drops the lock while the bus is busy (ControlUnlock).
+ * In the RTOS build (JBCLONE_RTOS) the loop work runs in tasks, see rtos.h; ControlLock
+ * takes the control mutex before masking the tick, so the tasks lock the control state
+ * as the loop did and a task blocked on the lock lends its priority to the owner.
+ *
+ * Every tick is measured, and so are its phases: each zero cross event, each sample, each
+ * PID compute. The rest of the tick is a fixed path. Phase counts per tick are bounded by
+ * construction, phase times are not: the execution time
+ *   C = rest + _control_events_per_tick * event + heaters * (sample + compute)
+ * takes the worst measured time of every phase, so it only covers the paths, flash wait
+ * states and data the measurements have seen. It is a measurement-based bound, not a static
+ * WCET. The zero cross ISR adds its worst measured execution I (zc_timing) for every edge
+ * that can arrive while the tick runs, with edges at least the shortest measured edge
+ * spacing T apart (the mains half cycle until one was measured):
+ *   R = C + ceil(R / T) * I
+ * iterated from R = C + I, and R is checked against the tick period. The core's interrupts
+ * are not in R, their time shows in the measured worst tick only. A scope capture (scope.h)
+ * runs after the measured part of its tick and the ticks it holds off are not counted late.
+ * Histogram bins as zc_timing: bin 0 < 0.5us, bin n < 0.5us * 2^n.
+ */
+
+enum ControlPhase
+{
+    CONTROL_PHASE_EVENT,   // one zero cross event taken and dispatched
+    CONTROL_PHASE_SAMPLE,  // one thermocouple sample and its conversion
+    CONTROL_PHASE_COMPUTE, // one PID compute
+    CONTROL_PHASE_COUNT
+};
+
+void control_init(void (*tick)());
+void control_tick_enter();
+void control_tick_exit();
+void control_tick_stretched();
+void control_phase_add(ControlPhase phase, uint32_t cycles);
+void control_lock();
+void control_unlock();
+uint8_t control_release();
+void control_reacquire(uint8_t depth);
+uint32_t control_response_bound_ns(uint32_t exec_ns, uint32_t isr_ns, uint32_t spacing_ns, uint32_t &isr_arrivals);
+bool control_cli(String &cmd, String &response);
+size_t control_ram_usage();
+
+/**
+ * @brief RAII helper placed as first statement of the control tick.
+ */
+class ControlTickTiming
+{
+public:
+    ControlTickTiming() { control_tick_enter(); }
+    ~ControlTickTiming() { control_tick_exit(); }
+};
+
+/**
+ * @brief RAII scope that adds its lifetime to a phase of the running tick.
+ */
+class ControlPhaseTiming
+{
+private:
+    ControlPhase _phase;
+    uint32_t _start;
+
+public:
+    ControlPhaseTiming(ControlPhase phase) : _phase(phase), _start(cycle_counter_read()) {}
+    ~ControlPhaseTiming() { control_phase_add(_phase, cycle_counter_read() - _start); }
+};
+
+/**
+ * @brief masks the control tick for its lifetime, main loop only. Nests.
+ */
+class ControlLock
+{
+public:
+    ControlLock() { control_lock(); }
+    ~ControlLock() { control_unlock(); }
+};
+
+/**
+ * @brief lets the control tick run for its lifetime inside a ControlLock, main loop only.
+ */
+class ControlUnlock
+{
+private:
+    uint8_t _depth;
+
+public:
+    ControlUnlock() : _depth(control_release()) {}
+    ~ControlUnlock() { control_reacquire(_depth); }
+};
+
+#endif
@@ -0,0 +1,294 @@
+#include "coro.h"
+
+#ifdef JBCLONE_CORO
+
+#include <stdlib.h>
+
+struct CoroThread
+{
+    const char *name;
+    std::coroutine_handle<> root;   // nullptr for a free slot
+    std::coroutine_handle<> resume; // innermost suspended coroutine of the thread
+    CoroWaitKind wait;
+    uint32_t arg;
+    bool timed;
+    Stream *stream;
+    const CoroEvent *event;
+    bool (*predicate)();
+    uint32_t resumes;
+    uint32_t worst_us;
+};
+
+static CoroThread coro_threads[coro_max_threads];
+static CoroThread *coro_current = nullptr;
+
+static uint32_t coro_frames = 0;
+static uint32_t coro_frame_bytes = 0;
+static uint32_t coro_frame_bytes_max = 0;
+static uint32_t coro_alloc_failures = 0;
+
+/**
+ * @brief coroutine frame allocation, counted for "s:coro:?".
+ *
+ * @return the frame, nullptr if the heap is exhausted.
+ */
+void *coro_frame_alloc(size_t size)
+{
+    void *frame = malloc(size);
+    if (frame == nullptr)
+    {
+        coro_alloc_failures++;
+        return nullptr;
+    }
+
+    coro_frames++;
+    coro_frame_bytes += size;
+    if (coro_frame_bytes > coro_frame_bytes_max)
+        coro_frame_bytes_max = coro_frame_bytes;
+    return frame;
+}
+
+void coro_frame_free(void *frame, size_t size)
+{
+    free(frame);
+    coro_frames--;
+    coro_frame_bytes -= size;
+}
+
+/**
+ * @brief records the wait of the running thread and where to resume it.
+ *
+ * @note Called by CoroAwait only, a wait outside a thread is never resumed.
+ */
+void coro_wait(std::coroutine_handle<> handle, const CoroAwait &wait)
+{
+    if (coro_current == nullptr)
+        return;
+
+    coro_current->resume = handle;
+    coro_current->wait = wait.kind;
+    coro_current->arg = wait.arg;
+    coro_current->timed = wait.timed;
+    coro_current->stream = wait.stream;
+    coro_current->event = wait.event;
+    coro_current->predicate = wait.predicate;
+}
+
+/**
+ * @brief lets the other threads run, resumed by the next coro_run().
+ */
+CoroAwait coro_yield()
+{
+    return {CORO_WAIT_NONE, false, 0, false, nullptr, nullptr, nullptr};
+}
+
+/**
+ * @brief waits at least the given time.
+ */
+CoroAwait coro_sleep_us(uint32_t us)
+{
+    return {CORO_WAIT_TIME, false, micros() + us, false, nullptr, nullptr, nullptr};
+}
+
+/**
+ * @brief waits for received bytes, does not suspend if there are some already.
+ */
+CoroAwait coro_readable(Stream &stream)
+{
+    return {CORO_WAIT_READABLE, stream.available() > 0, 0, false, &stream, nullptr, nullptr};
+}
+
+/**
+ * @brief waits for received bytes or the timeout, the caller checks which one it was.
+ */
+CoroAwait coro_readable(Stream &stream, uint32_t timeout_us)
+{
+    return {CORO_WAIT_READABLE, stream.available() > 0, micros() + timeout_us, true, &stream, nullptr, nullptr};
+}
+
+/**
+ * @brief waits for the event count to move from the count seen, see CoroEvent::count().
+ *
+ * Read the count before the work that may miss a signal, then wait with it.
+ */
+CoroAwait coro_event(const CoroEvent &event, uint32_t seen)
+{
+    return {CORO_WAIT_EVENT, event.count() != seen, seen, false, nullptr, &event, nullptr};
+}
+
+/**
+ * @brief waits for a condition, checked at every coro_run().
+ */
+CoroAwait coro_until(bool (*predicate)())
+{
+    return {CORO_WAIT_UNTIL, predicate(), 0, false, nullptr, nullptr, predicate};
+}
+
+static bool coro_ready(const CoroThread &thread)
+{
+    switch (thread.wait)
+    {
+    case CORO_WAIT_TIME:
+        return (int32_t)(micros() - thread.arg) >= 0;
+    case CORO_WAIT_READABLE:
+        return thread.stream->available() > 0 || (thread.timed && (int32_t)(micros() - thread.arg) >= 0);
+    case CORO_WAIT_EVENT:
+        return thread.event->count() != thread.arg;
+    case CORO_WAIT_UNTIL:
+        return thread.predicate();
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief starts a coroutine thread, it first runs at the next coro_run().
+ *
+ * @param name Thread name for "s:coro:?".
+ * @param task The thread body, usually an endless loop.
+ * @return false if its frame could not be allocated or all the slots are taken.
+ */
+bool coro_spawn(const char *name, CoroTask<void> task)
+{
+    if (!task.valid())
+        return false;
+
+    for (CoroThread &thread : coro_threads)
+    {
+        if (thread.root)
+            continue;
+
+        thread = CoroThread();
+        thread.name = name;
+        thread.root = task.release();
+        thread.resume = thread.root;
+        thread.wait = CORO_WAIT_NONE;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief resumes every thread whose wait is over, each until its next co_await.
+ *
+ * @note Call from loop() only.
+ */
+void coro_run()
+{
+    for (CoroThread &thread : coro_threads)
+    {
+        if (!thread.root || !coro_ready(thread))
+            continue;
+
+        thread.wait = CORO_WAIT_NONE;
+        coro_current = &thread;
+        const uint32_t start = micros();
+        thread.resume.resume();
+        const uint32_t elapsed = micros() - start;
+        coro_current = nullptr;
+
+        thread.resumes++;
+        if (elapsed > thread.worst_us)
+            thread.worst_us = elapsed;
+
+        if (thread.root.done())
+        {
+            thread.root.destroy();
+            thread.root = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief true if a thread is ready to resume, the loop must not sleep (idle_sleep()).
+ */
+bool coro_pending()
+{
+    for (const CoroThread &thread : coro_threads)
+    {
+        if (thread.root && coro_ready(thread))
+            return true;
+    }
+    return false;
+}
+
+static const char *coro_wait_name(CoroWaitKind wait)
+{
+    switch (wait)
+    {
+    case CORO_WAIT_TIME:
+        return "time";
+    case CORO_WAIT_READABLE:
+        return "readable";
+    case CORO_WAIT_EVENT:
+        return "event";
+    case CORO_WAIT_UNTIL:
+        return "until";
+    default:
+        return "ready";
+    }
+}
+
+/**
+ * @brief coroutine runtime command handler.
+ *
+ * The command format is as follows:
+ * - To get the statistics: ?
+ * - To clear resume counts and worst times: clear
+ *
+ * Response: frames=x,frame_bytes=x,frame_bytes_max=x,alloc_fail=x;name:wait=x,resumes=x,worst_us=x;...
+ * worst_us is the longest single resume of the thread, the longest it held the loop.
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool coro_cli(String &cmd, String &response)
+{
+    if (cmd == "clear")
+    {
+        for (CoroThread &thread : coro_threads)
+        {
+            thread.resumes = 0;
+            thread.worst_us = 0;
+        }
+        coro_frame_bytes_max = coro_frame_bytes;
+        coro_alloc_failures = 0;
+
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    response = "frames=" + String(coro_frames);
+    response += ",frame_bytes=" + String(coro_frame_bytes);
+    response += ",frame_bytes_max=" + String(coro_frame_bytes_max);
+    response += ",alloc_fail=" + String(coro_alloc_failures);
+
+    for (const CoroThread &thread : coro_threads)
+    {
+        if (!thread.root)
+            continue;
+        response += ";" + String(thread.name);
+        response += ":wait=" + String(coro_wait_name(thread.wait));
+        response += ",resumes=" + String(thread.resumes);
+        response += ",worst_us=" + String(thread.worst_us);
+    }
+    return true;
+}
+
+#else
+
+bool coro_cli(String &cmd, String &response)
+{
+    (void)cmd;
+    response = "coroutine build only";
+    return false;
+}
+
+#endif
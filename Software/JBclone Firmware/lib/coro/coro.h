@@ -0,0 +1,184 @@
+#ifndef __coro_H__
+#define __coro_H__
+
+#include <Arduino.h>
+
+/**
+ * @file coro.h
+ * @brief stackless coroutines run from loop() (JBCLONE_CORO build, C++20).
+ *
+ * A few coroutine threads (coro_spawn) do the slow work of the loop: EEPROM saves, HMI
+ * commands and refresh, USB commands. They read sequentially, and wherever the plain loop
+ * would busy-wait they co_await instead: a time (coro_sleep_us), bytes on a stream
+ * (coro_readable), an event (CoroEvent) or a condition (coro_until). coro_run() resumes
+ * from loop() every thread whose wait is over, each one until its next co_await, so one
+ * resume is the longest the loop is held and "s:coro:?" reports it per thread.
+ * The loop sleeps while no thread is ready (idle.h), so a time wait ends at the first
+ * interrupt after its deadline, at most one SysTick period late.
+ *
+ * Coroutines call coroutines with co_await on a CoroTask<T>, which returns the callee
+ * co_return value. Frames are on the heap, a frame that cannot be allocated makes the
+ * call return T{} (false for bool). Exceptions are not used.
+ *
+ * Without JBCLONE_CORO only coro_cli() is built and answers an error.
+ */
+
+#ifdef JBCLONE_CORO
+
+#ifdef JBCLONE_RTOS
+#error "JBCLONE_CORO and JBCLONE_RTOS are alternative builds of the loop"
+#endif
+
+#include <coroutine>
+#include <type_traits>
+
+constexpr size_t coro_max_threads = 6;
+
+enum CoroWaitKind : uint8_t
+{
+    CORO_WAIT_NONE,     // ready, resumed by the next coro_run()
+    CORO_WAIT_TIME,     // until micros() reaches the deadline
+    CORO_WAIT_READABLE, // until the stream has bytes, or the deadline if one is given
+    CORO_WAIT_EVENT,    // until the event count moves
+    CORO_WAIT_UNTIL,    // until the predicate is true
+};
+
+/**
+ * @brief event counter, signalled from code or an ISR, awaited by coroutines.
+ */
+class CoroEvent
+{
+private:
+    volatile uint32_t _count = 0;
+
+public:
+    void signal() { _count = _count + 1; }
+    uint32_t count() const { return _count; }
+};
+
+struct CoroAwait;
+
+void *coro_frame_alloc(size_t size);
+void coro_frame_free(void *frame, size_t size);
+void coro_wait(std::coroutine_handle<> handle, const CoroAwait &wait);
+
+/**
+ * @brief co_return value of a CoroTask promise, none for void.
+ */
+template <typename T>
+struct CoroPromiseReturn
+{
+    T value{};
+    void return_value(T result) { value = result; }
+};
+
+template <>
+struct CoroPromiseReturn<void>
+{
+    void return_void() {}
+};
+
+/**
+ * @brief coroutine, started by coro_spawn() or by the first co_await of its caller.
+ */
+template <typename T = void>
+class CoroTask
+{
+public:
+    struct promise_type : CoroPromiseReturn<T>
+    {
+        std::coroutine_handle<> continuation;
+
+        CoroTask get_return_object() { return CoroTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        static CoroTask get_return_object_on_allocation_failure() { return CoroTask(nullptr); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        void unhandled_exception() {}
+
+        // back to the caller, or to coro_run() for a thread
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+            {
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        static void *operator new(size_t size) noexcept { return coro_frame_alloc(size); }
+        static void operator delete(void *frame, size_t size) { coro_frame_free(frame, size); }
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit CoroTask(handle_type handle) : _handle(handle) {}
+    CoroTask(CoroTask &&other) noexcept : _handle(other._handle) { other._handle = nullptr; }
+    CoroTask(const CoroTask &) = delete;
+    CoroTask &operator=(const CoroTask &) = delete;
+    ~CoroTask()
+    {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    bool valid() const { return (bool)_handle; }
+    handle_type release()
+    {
+        handle_type handle = _handle;
+        _handle = nullptr;
+        return handle;
+    }
+
+    // co_await runs the callee until it finishes, then resumes the caller
+    bool await_ready() const noexcept { return !_handle; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+    {
+        _handle.promise().continuation = caller;
+        return _handle;
+    }
+    T await_resume()
+    {
+        if constexpr (!std::is_void<T>::value)
+            return _handle ? _handle.promise().value : T{};
+    }
+
+private:
+    handle_type _handle;
+};
+
+/**
+ * @brief awaitable of a wait of the running thread, see coro_sleep_us() and friends.
+ */
+struct CoroAwait
+{
+    CoroWaitKind kind;
+    bool ready;
+    uint32_t arg; // deadline or event count seen
+    bool timed;   // readable with a deadline
+    Stream *stream;
+    const CoroEvent *event;
+    bool (*predicate)();
+
+    bool await_ready() const noexcept { return ready; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { coro_wait(handle, *this); }
+    void await_resume() const noexcept {}
+};
+
+CoroAwait coro_yield();
+CoroAwait coro_sleep_us(uint32_t us);
+CoroAwait coro_readable(Stream &stream);
+CoroAwait coro_readable(Stream &stream, uint32_t timeout_us);
+CoroAwait coro_event(const CoroEvent &event, uint32_t seen);
+CoroAwait coro_until(bool (*predicate)());
+
+bool coro_spawn(const char *name, CoroTask<void> task);
+void coro_run();
+bool coro_pending();
+
+#endif
+
+bool coro_cli(String &cmd, String &response);
+
+#endif
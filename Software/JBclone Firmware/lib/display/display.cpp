@@ -1,100 +1,177 @@
-#include "display.h"
-
-void Display::display_command(const String command)
-{
-    if (pause_update)
-        return;
-    port.write(command.c_str());
-    port.write(terminator);
-    port.write(terminator);
-    port.write(terminator);
-}
-
-void Display::init(uint32_t baud, unsigned long timeout)
-{
-    this->port.begin(baud);
-    this->timeout = timeout;
-    this->port.setTimeout(timeout);
-}
-
-bool Display::read(String &message)
-{
-    if (port.available() == 0)
-        return false;
-
-    // data in buffer
-    String received_data = "";
-    int terminator_counter = 0;
-    bool terminator_found = false;
-    long start_time = millis();
-
-    while (millis() - start_time < timeout)
-    {
-        if (port.available() > 0)
-        {
-            char incoming = port.read();
-            received_data += incoming;
-
-            // terminator sequence counter
-            if (incoming == terminator)
-                terminator_counter++;
-            else
-                terminator_counter = 0;
-
-            // positive exit condition
-            if (terminator_counter == temrinator_legnth)
-            {
-                terminator_found = true;
-                break;
-            }
-        }
-    }
-
-    // data not parsed
-    if (!terminator_found)
-        return false;
-
-    // remove terminator
-    received_data = received_data.substring(0, received_data.length() - temrinator_legnth);
-    bool is_internal_command = received_data.startsWith(internal_command_prpeamble);
-    
-    //normal message received
-    if (!is_internal_command)
-    {
-        message = received_data;
-        return true;
-    }
-
-    received_data = received_data.substring(internal_command_prpeamble.length());
-    char command = received_data[0];
-
-    switch (command)
-    {
-    case cmd_pause_update:
-        pause_update = true;
-        break;
-    case cmd_resume_update:
-        pause_update = false;
-        break;
-    }
-
-    return false; // internal command does not trigger valid respoonse
-}
-
-void Display::text(const String target_field, String txt)
-{
-    String command = target_field + ".txt=\"" + txt + "\"";
-    display_command(command);
-}
-
-void Display::value(const String target_field, int value)
-{
-    String command = target_field + ".val=" + String(static_cast<int>(value));
-    display_command(command);
-}
-
-void Display::color(const String target_field, const long color)
-{
-    String command = target_field + ".pco=" + String(color);
-    display_command(command);
+#include "display.h"
+
+void Display::display_command(const String command)
+{
+    if (pause_update)
+        return;
+#ifdef JBCLONE_CORO
+    // written by tx_flush() as the port buffer frees up
+    tx_pending += command;
+    for (int i = 0; i < temrinator_legnth; i++)
+        tx_pending += (char)terminator;
+#else
+    port.write(command.c_str());
+    port.write(terminator);
+    port.write(terminator);
+    port.write(terminator);
+#endif
+    bytes_sent += command.length() + temrinator_legnth;
+}
+
+#ifdef JBCLONE_CORO
+/**
+ * @brief writes as much of the pending commands as the port buffer takes, without waiting.
+ *
+ * @return true once every pending command is written.
+ */
+bool Display::tx_flush()
+{
+    size_t room = port.availableForWrite();
+    size_t count = tx_pending.length() < room ? tx_pending.length() : room;
+    if (count > 0)
+    {
+        port.write((const uint8_t *)tx_pending.c_str(), count);
+        tx_pending = tx_pending.substring(count);
+    }
+    return tx_pending.length() == 0;
+}
+#endif
+
+void Display::init(uint32_t baud, unsigned long timeout)
+{
+    this->port.begin(baud);
+    this->timeout = timeout;
+    this->port.setTimeout(timeout);
+}
+
+bool Display::read(String &message)
+{
+    if (port.available() == 0)
+        return false;
+
+    // data in buffer
+    String received_data = "";
+    int terminator_counter = 0;
+    bool terminator_found = false;
+    long start_time = millis();
+
+    while (millis() - start_time < timeout)
+    {
+        if (port.available() > 0)
+        {
+            char incoming = port.read();
+            received_data += incoming;
+
+            // terminator sequence counter
+            if (incoming == terminator)
+                terminator_counter++;
+            else
+                terminator_counter = 0;
+
+            // positive exit condition
+            if (terminator_counter == temrinator_legnth)
+            {
+                terminator_found = true;
+                break;
+            }
+        }
+    }
+
+    // data not parsed
+    if (!terminator_found)
+        return false;
+
+    return parse(received_data, message);
+}
+
+/**
+ * @brief read() without waiting: takes the bytes received so far.
+ *
+ * A message not completed within the timeout is dropped, as read() drops it.
+ *
+ * @return true once a complete message that is not an internal command is received.
+ */
+bool Display::poll(String &message)
+{
+    while (port.available() > 0)
+    {
+        if (rx_data.length() > 0 && millis() - rx_start >= timeout)
+        {
+            rx_data = "";
+            rx_terminators = 0;
+        }
+        if (rx_data.length() == 0)
+            rx_start = millis();
+
+        char incoming = port.read();
+        rx_data += incoming;
+
+        // terminator sequence counter
+        if (incoming == terminator)
+            rx_terminators++;
+        else
+            rx_terminators = 0;
+
+        if (rx_terminators == temrinator_legnth)
+        {
+            String received_data = rx_data;
+            rx_data = "";
+            rx_terminators = 0;
+            if (parse(received_data, message))
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief strips the terminator of a received message and runs the internal commands.
+ *
+ * @return true for a message to evaluate, false for an internal command.
+ */
+bool Display::parse(String received_data, String &message)
+{
+    // remove terminator
+    received_data = received_data.substring(0, received_data.length() - temrinator_legnth);
+    bool is_internal_command = received_data.startsWith(internal_command_prpeamble);
+    
+    //normal message received
+    if (!is_internal_command)
+    {
+        message = received_data;
+        return true;
+    }
+
+    received_data = received_data.substring(internal_command_prpeamble.length());
+    char command = received_data[0];
+
+    switch (command)
+    {
+    case cmd_pause_update:
+        pause_update = true;
+        break;
+    case cmd_resume_update:
+        pause_update = false;
+        break;
+    }
+
+    return false; // internal command does not trigger valid respoonse
+}
+
+void Display::text(const String target_field, String txt)
+{
+    String command = target_field + ".txt=\"" + txt + "\"";
+    display_command(command);
+}
+
+void Display::value(const String target_field, int value)
+{
+    String command = target_field + ".val=" + String(static_cast<int>(value));
+    display_command(command);
+}
+
+void Display::color(const String target_field, const long color)
+{
+    String command = target_field + ".pco=" + String(color);
+    display_command(command);
 }
\ No newline at end of file
@@ -1,31 +1,49 @@
-#ifndef __display_H__
-#define __display_H__
-
-#include <Arduino.h>
-
-class Display{
-private:
-    HardwareSerial  &port;
-    unsigned long timeout;
-    
-    const byte terminator = 0xFF;
-    const int temrinator_legnth = 3;
-    
-    String internal_command_prpeamble = "xxx";
-    static constexpr char cmd_pause_update = 'P';
-    static constexpr char cmd_resume_update = 'R';
-    bool pause_update = false;
-    
-    void display_command(const String command);
-public:
-    Display(HardwareSerial &port): port(port){};
-    void init(uint32_t baud, unsigned long timeout);
-
-    bool read(String &message);
-
-    void text(const String target_field, String txt);   
-    void value(const String target_field, int value);
-    void color(const String target_field, const long color);
-
-};
+#ifndef __display_H__
+#define __display_H__
+
+#include <Arduino.h>
+
+class Display{
+private:
+    HardwareSerial  &port;
+    unsigned long timeout;
+    
+    const byte terminator = 0xFF;
+    const int temrinator_legnth = 3;
+    
+    String internal_command_prpeamble = "xxx";
+    static constexpr char cmd_pause_update = 'P';
+    static constexpr char cmd_resume_update = 'R';
+    bool pause_update = false;
+    uint32_t bytes_sent = 0;
+
+    // poll() message assembly
+    String rx_data;
+    unsigned long rx_start = 0;
+    int rx_terminators = 0;
+#ifdef JBCLONE_CORO
+    String tx_pending; // commands not written yet, see tx_flush()
+#endif
+    
+    void display_command(const String command);
+    bool parse(String received_data, String &message);
+public:
+    Display(HardwareSerial &port): port(port){};
+    void init(uint32_t baud, unsigned long timeout);
+
+    bool read(String &message);
+    bool poll(String &message);
+    Stream &input() { return port; }
+#ifdef JBCLONE_CORO
+    bool tx_flush();
+#endif
+
+    void text(const String target_field, String txt);   
+    void value(const String target_field, int value);
+    void color(const String target_field, const long color);
+
+    uint32_t get_bytes_sent() const { return bytes_sent; }
+    void clear_bytes_sent() { bytes_sent = 0; }
+
+};
 #endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "events.h"
+
+static_assert((event_queue_size & (event_queue_size - 1)) == 0, "event_queue_size must be a power of two");
+
+static IsrEvent event_buffer[event_queue_size];
+static uint32_t event_head = 0; // events published, written by the ISR only
+static uint32_t event_tail = 0; // events consumed, written by the control tick only
+
+// producer side counters, written by the ISR only
+static volatile uint32_t event_overflow[EVENT_TYPE_COUNT];
+static volatile uint32_t event_overflow_timestamp = 0;
+
+// consumer side statistics
+static uint32_t event_consumed = 0;
+static uint32_t event_max_queued = 0;
+static uint32_t event_max_latency_us = 0;
+static uint32_t event_windows = 0;
+
+/**
+ * @brief empties the queue and clears the counters.
+ *
+ * @note Call before the zero cross interrupt is attached.
+ */
+void event_queue_init()
+{
+    event_head = 0;
+    event_tail = 0;
+    for (size_t i = 0; i < EVENT_TYPE_COUNT; i++)
+        event_overflow[i] = 0;
+    event_overflow_timestamp = 0;
+    event_consumed = 0;
+    event_max_queued = 0;
+    event_max_latency_us = 0;
+    event_windows = 0;
+}
+
+/**
+ * @brief appends an event, producer side.
+ *
+ * @note Call from the zero cross ISR only.
+ *
+ * @return false if the queue was full and the event was dropped.
+ */
+bool event_push(IsrEventType type, uint8_t channel, uint16_t arg, uint32_t timestamp)
+{
+    const uint32_t head = event_head;
+    if (head - __atomic_load_n(&event_tail, __ATOMIC_ACQUIRE) >= event_queue_size)
+    {
+        event_overflow[type]++;
+        event_overflow_timestamp = timestamp;
+        return false;
+    }
+
+    IsrEvent &event = event_buffer[head & (event_queue_size - 1)];
+    event.timestamp = timestamp;
+    event.type = type;
+    event.channel = channel;
+    event.arg = arg;
+
+    // the slot is complete before the tick can see it
+    __atomic_store_n(&event_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief takes the oldest event, consumer side.
+ *
+ * @note Call from the control tick only.
+ *
+ * @return false if the queue is empty.
+ */
+bool event_pop(IsrEvent &event)
+{
+    const uint32_t tail = event_tail;
+    const uint32_t queued = __atomic_load_n(&event_head, __ATOMIC_ACQUIRE) - tail;
+    if (queued == 0)
+        return false;
+
+    event = event_buffer[tail & (event_queue_size - 1)];
+
+    // the slot is copied before the ISR can reuse it
+    __atomic_store_n(&event_tail, tail + 1, __ATOMIC_RELEASE);
+
+    event_consumed++;
+    if (queued > event_max_queued)
+        event_max_queued = queued;
+    const uint32_t latency = micros() - event.timestamp;
+    if (latency > event_max_latency_us)
+        event_max_latency_us = latency;
+    if (event.type == EVENT_WINDOW_START)
+        event_windows++;
+    return true;
+}
+
+/**
+ * @brief events dropped on a full queue since the start, all types.
+ */
+uint32_t event_overflows()
+{
+    uint32_t total = 0;
+    for (size_t i = 0; i < EVENT_TYPE_COUNT; i++)
+        total += event_overflow[i];
+    return total;
+}
+
+/**
+ * @brief timestamp of the last dropped event, the ISR was running then.
+ */
+uint32_t event_last_overflow_timestamp()
+{
+    return event_overflow_timestamp;
+}
+
+/**
+ * @brief event queue command handler.
+ *
+ * The command format is as follows:
+ * - To get the statistics: ?
+ *   response queued=x,max_queued=x,size=x,consumed=x,windows=x,latency_max_us=x,overflow=edge/window/sample
+ *   latency is from the ISR to the control tick taking the event
+ * - To clear the statistics: clear
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool events_cli(String &cmd, String &response)
+{
+    if (cmd == "clear")
+    {
+        noInterrupts();
+        for (size_t i = 0; i < EVENT_TYPE_COUNT; i++)
+            event_overflow[i] = 0;
+        interrupts();
+        event_consumed = 0;
+        event_max_queued = 0;
+        event_max_latency_us = 0;
+        event_windows = 0;
+
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    response = "queued=" + String(__atomic_load_n(&event_head, __ATOMIC_ACQUIRE) - event_tail);
+    response += ",max_queued=" + String(event_max_queued);
+    response += ",size=" + String((uint32_t)event_queue_size);
+    response += ",consumed=" + String(event_consumed);
+    response += ",windows=" + String(event_windows);
+    response += ",latency_max_us=" + String(event_max_latency_us);
+    response += ",overflow=" + String((uint32_t)event_overflow[EVENT_MAINS_EDGE]);
+    response += "/" + String((uint32_t)event_overflow[EVENT_WINDOW_START]);
+    response += "/" + String((uint32_t)event_overflow[EVENT_SAMPLE_DUE]);
+    return true;
+}
+
+/**
+ * @brief static RAM used by the event queue.
+ */
+size_t events_ram_usage()
+{
+    return sizeof(event_buffer);
+}
@@ -0,0 +1,43 @@
+#ifndef __events_H__
+#define __events_H__
+
+#include <Arduino.h>
+
+/**
+ * @file events.h
+ * @brief single producer, single consumer queue of timestamped events from the zero cross
+ * ISR to the control tick.
+ *
+ * The ISR is the only writer of the head index and of the slots it publishes, the tick the
+ * only writer of the tail index, so neither side ever blocks or disables interrupts and no
+ * event is torn. Events are consumed in the order the ISR produced them. A full queue drops
+ * the new event and counts it per type; the tick learns from the counters that it fell behind.
+ */
+
+constexpr size_t event_queue_size = 128; // events, must be a power of two
+
+enum IsrEventType : uint8_t
+{
+    EVENT_MAINS_EDGE,   // arg: zero cross counter
+    EVENT_WINDOW_START, // sampling half-cycle, outputs off, arg: window number
+    EVENT_SAMPLE_DUE,   // channel, arg: window number, sample after the amplifier recovery
+    EVENT_TYPE_COUNT,
+};
+
+struct IsrEvent
+{
+    uint32_t timestamp; // micros() in the ISR
+    uint8_t type;
+    uint8_t channel;
+    uint16_t arg;
+};
+
+void event_queue_init();
+bool event_push(IsrEventType type, uint8_t channel, uint16_t arg, uint32_t timestamp);
+bool event_pop(IsrEvent &event);
+uint32_t event_overflows();
+uint32_t event_last_overflow_timestamp();
+bool events_cli(String &cmd, String &response);
+size_t events_ram_usage();
+
+#endif
@@ -1,10 +1,10 @@
-#ifndef __hartbeat_H__
-#define __hartbeat_H__
-
-#include <Arduino.h>
-
-void hartbeat_set();
-
-void update_hartbeat();
-
+#ifndef __hartbeat_H__
+#define __hartbeat_H__
+
+#include <Arduino.h>
+
+void hartbeat_set();
+
+void update_hartbeat();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "health.h"
+#include "objects.h"
+#include "idle.h"
+
+StationHealth station_health;
+
+static uint32_t health_rate_timestamp = 0;
+static uint32_t health_last_loop_iterations = 0;
+static uint32_t health_last_zero_cross_edges = 0;
+static uint32_t health_last_idle_us = 0;
+
+/**
+ * @brief counts a main loop iteration and latches the per second rates.
+ *
+ * Must be called once per main loop iteration.
+ */
+void health_update()
+{
+    station_health.loop_iterations++;
+
+    constexpr uint32_t rate_interval = 1000; // ms
+    uint32_t now = millis();
+    if (now - health_rate_timestamp < rate_interval)
+        return;
+
+    uint32_t zero_cross_edges = station_health.zero_cross_edges;
+    uint32_t idle_us = idle_time_us();
+    uint32_t elapsed = now - health_rate_timestamp;
+
+    station_health.loop_rate = (station_health.loop_iterations - health_last_loop_iterations) * 1000UL / elapsed;
+    station_health.zero_cross_rate = (zero_cross_edges - health_last_zero_cross_edges) * 1000UL / elapsed;
+    uint32_t idle_permille = (idle_us - health_last_idle_us) / elapsed; // us per ms
+    station_health.idle_permille = idle_permille > 1000 ? 1000 : idle_permille;
+
+    health_last_loop_iterations = station_health.loop_iterations;
+    health_last_zero_cross_edges = zero_cross_edges;
+    health_last_idle_us = idle_us;
+    health_rate_timestamp = now;
+}
+
+/**
+ * @brief station health command handler.
+ *
+ * The command format is as follows:
+ * - To get the counters: ?
+ * - To clear the counters: clear
+ *
+ * Response: loop_hz=x;idle_pct=x;zc_hz=x;hmi_bytes=x;parse_err=x;ch0:sched=x,taken=x,missed=x,pid_skip=x,saves=x,save_fail=x,save_us=x,save_us_max=x;ch1:...
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool health_cli(String &cmd, String &response)
+{
+    if (cmd == "clear")
+    {
+        noInterrupts();
+        station_health.zero_cross_edges = 0;
+        interrupts();
+        station_health.loop_iterations = 0;
+        station_health.serial_parse_errors = 0;
+        health_last_loop_iterations = 0;
+        health_last_zero_cross_edges = 0;
+
+        _hmi.clear_bytes_sent();
+        for (size_t i = 0; i < _heater_count; i++)
+            heaters[i].clear_health();
+
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    response = "loop_hz=" + String(station_health.loop_rate);
+    response += ";idle_pct=" + String(station_health.idle_permille / 10.0f, 1);
+    response += ";zc_hz=" + String(station_health.zero_cross_rate);
+    response += ";hmi_bytes=" + String(_hmi.get_bytes_sent());
+    response += ";parse_err=" + String(station_health.serial_parse_errors);
+
+    for (size_t i = 0; i < _heater_count; i++)
+    {
+        const Heater::HealthCounters &counters = heaters[i].get_health();
+        response += ";ch" + String((int)i);
+        response += ":sched=" + String(counters.samples_scheduled);
+        response += ",taken=" + String(counters.samples_taken);
+        response += ",missed=" + String(counters.samples_missed);
+        response += ",pid_skip=" + String(counters.pid_skipped);
+        response += ",saves=" + String(counters.saves);
+        response += ",save_fail=" + String(counters.save_failures);
+        response += ",save_us=" + String(counters.save_time_us);
+        response += ",save_us_max=" + String(counters.save_time_us_max);
+    }
+
+    return true;
+}
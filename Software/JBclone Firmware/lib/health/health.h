@@ -0,0 +1,30 @@
+#ifndef __health_H__
+#define __health_H__
+
+#include <Arduino.h>
+
+/**
+ * @brief station wide health counters.
+ *
+ * Counters are incremented in place by the code paths they observe and never
+ * reset on read, rates are latched once per second by health_update().
+ * Per channel counters live in Heater::HealthCounters.
+ */
+struct StationHealth
+{
+    uint32_t loop_iterations;
+    volatile uint32_t zero_cross_edges;
+    uint32_t serial_parse_errors;
+
+    // latched rates
+    uint32_t loop_rate;
+    uint32_t zero_cross_rate;
+    uint32_t idle_permille; // CPU time asleep, see idle.h
+};
+
+extern StationHealth station_health;
+
+void health_update();
+bool health_cli(String &cmd, String &response);
+
+#endif
@@ -0,0 +1,131 @@
+#include "idle.h"
+#include "health.h"
+
+#ifdef JBCLONE_RTOS
+#include "rtos.h"
+#endif
+
+static IdleStats idle_stats;
+static bool idle_enabled = true;
+static uint32_t idle_total_us = 0; // time asleep, wraps
+static uint32_t idle_wake_us = 0;  // end of the last sleep
+
+/**
+ * @brief micros() for interrupts masked.
+ *
+ * A SysTick wrap not served yet leaves its interrupt pending and the millisecond count behind.
+ */
+static uint32_t idle_clock_us()
+{
+#ifdef ARDUINO_ARCH_STM32
+    const uint32_t load = SysTick->LOAD + 1;
+    uint32_t ms = HAL_GetTick();
+    uint32_t count = SysTick->VAL;
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        ms++;
+        count = SysTick->VAL;
+    }
+    return ms * 1000 + (load - count) * 1000 / load;
+#else
+    return micros();
+#endif
+}
+
+/**
+ * @brief sleeps until the next interrupt, unless work is pending.
+ *
+ * @note Call from the main loop only, once per iteration.
+ *
+ * @param pending Returns true if the loop has input waiting, called with interrupts masked.
+ */
+void idle_sleep(bool (*pending)())
+{
+    if (!idle_enabled)
+        return;
+
+    noInterrupts();
+    if (pending())
+    {
+        interrupts();
+        idle_stats.skipped++;
+        return;
+    }
+
+    const uint32_t start = idle_clock_us();
+    __WFI();
+    const uint32_t end = idle_clock_us();
+    interrupts();
+
+    const uint32_t slept = end - start;
+    idle_total_us += slept;
+    if (slept > idle_stats.sleep_us_max)
+        idle_stats.sleep_us_max = slept;
+
+    if (idle_stats.sleeps > 0 && start - idle_wake_us > idle_stats.busy_us_max)
+        idle_stats.busy_us_max = start - idle_wake_us;
+    idle_wake_us = end;
+    idle_stats.sleeps++;
+}
+
+/**
+ * @brief total idle time, wraps; differences are valid over less than ~71 minutes.
+ */
+uint32_t idle_time_us()
+{
+#ifdef JBCLONE_RTOS
+    return (uint32_t)ulTaskGetIdleRunTimeCounter();
+#else
+    return idle_total_us;
+#endif
+}
+
+/**
+ * @brief idle sleep command handler.
+ *
+ * The command format is as follows:
+ * - To get the statistics: ?
+ *   response idle_pct=x,sleeps=x,skipped=x,sleep_us_max=x,busy_us_max=x,enabled=x
+ *   idle_pct is latched once per second, see health_update()
+ * - To clear the statistics: clear
+ * - To spin the loop without sleeping, or sleep again: off, on
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool idle_cli(String &cmd, String &response)
+{
+    if (cmd == "?")
+    {
+        response = "idle_pct=" + String(station_health.idle_permille / 10.0f, 1);
+        response += ",sleeps=" + String(idle_stats.sleeps);
+        response += ",skipped=" + String(idle_stats.skipped);
+        response += ",sleep_us_max=" + String(idle_stats.sleep_us_max);
+        response += ",busy_us_max=" + String(idle_stats.busy_us_max);
+        response += ",enabled=" + String(idle_enabled ? 1 : 0);
+        return true;
+    }
+
+    if (cmd == "clear")
+    {
+        idle_stats = IdleStats();
+        response = "OK";
+        return true;
+    }
+
+    if (cmd == "on" || cmd == "off")
+    {
+#ifdef JBCLONE_RTOS
+        response = "loop builds only";
+        return false;
+#else
+        idle_enabled = cmd == "on";
+        response = "OK";
+        return true;
+#endif
+    }
+
+    response = "invalid value";
+    return false;
+}
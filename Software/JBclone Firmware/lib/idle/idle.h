@@ -0,0 +1,34 @@
+#ifndef __idle_H__
+#define __idle_H__
+
+#include <Arduino.h>
+
+/**
+ * @file idle.h
+ * @brief idle sleep of the main loop and CPU idle time.
+ *
+ * loop() starts with idle_sleep(): when no input is waiting the core sleeps with WFI until
+ * the next interrupt, which is at most one SysTick period (1ms) away. The wakeups are the
+ * zero cross (EXTI), the control tick (TIM4, it also polls the ADC, there is no ADC interrupt),
+ * SysTick, HMI (USART) and USB receive. The check and WFI run with interrupts masked, so an
+ * interrupt raised in between ends WFI at once and runs right after it; work raised by an
+ * interrupt after the loop looked at it waits for the next wakeup.
+ *
+ * Time asleep is measured with interrupts still masked and excludes the interrupt that ends
+ * it. health_update() latches it once per second as the idle percentage. In the RTOS build
+ * the loop does not run and the idle time is the run time of the kernel idle task.
+ */
+
+struct IdleStats
+{
+    uint32_t sleeps;       // WFI executed
+    uint32_t skipped;      // input waiting, no sleep
+    uint32_t sleep_us_max; // longest sleep
+    uint32_t busy_us_max;  // longest time awake between two sleeps, interrupts included
+};
+
+void idle_sleep(bool (*pending)());
+uint32_t idle_time_us();
+bool idle_cli(String &cmd, String &response);
+
+#endif
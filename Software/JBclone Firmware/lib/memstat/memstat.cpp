@@ -0,0 +1,142 @@
+#include "memstat.h"
+#include "objects.h"
+#include "profiler.h"
+#include "zc_timing.h"
+#include "trace.h"
+#include "health.h"
+#include "scope.h"
+#include "steptest.h"
+#include "recorder.h"
+#include "events.h"
+#include "control.h"
+
+#ifdef ARDUINO_ARCH_STM32
+#include <malloc.h>
+
+extern "C" char _sdata, _edata, _sbss, _ebss, _estack;
+extern "C" char *sbrk(int incr);
+
+// newlib-nano free list, weak so the build survives a libc without it
+struct memstat_free_chunk
+{
+    long size;
+    memstat_free_chunk *next;
+};
+extern "C" memstat_free_chunk *__malloc_free_list __attribute__((weak));
+
+constexpr uint32_t memstat_pattern = 0xA5A5A5A5;
+constexpr uint32_t memstat_paint_guard = 64; // bytes kept below the stack pointer while painting
+
+static uint32_t *memstat_paint_begin = nullptr;
+static uint32_t *memstat_paint_end = nullptr;
+
+static uintptr_t memstat_heap_break()
+{
+    return (uintptr_t)sbrk(0);
+}
+
+/**
+ * @brief lowest stack address ever written since memstat_paint_stack().
+ */
+static uintptr_t memstat_stack_low_water()
+{
+    uint32_t *p = memstat_paint_begin;
+    uint32_t *heap = (uint32_t *)((memstat_heap_break() + 3) & ~(uintptr_t)3);
+    if (heap > p)
+        p = heap;
+
+    while (p < memstat_paint_end && *p == memstat_pattern)
+        p++;
+
+    return (uintptr_t)p;
+}
+#endif
+
+/**
+ * @brief fills the unused RAM between heap and stack with the paint pattern.
+ *
+ * Must be the first call in setup().
+ */
+void memstat_paint_stack()
+{
+#ifdef ARDUINO_ARCH_STM32
+    memstat_paint_begin = (uint32_t *)((memstat_heap_break() + 3) & ~(uintptr_t)3);
+    memstat_paint_end = (uint32_t *)((__get_MSP() - memstat_paint_guard) & ~(uintptr_t)3);
+
+    for (uint32_t *p = memstat_paint_begin; p < memstat_paint_end; p++)
+        *p = memstat_pattern;
+#endif
+}
+
+/**
+ * @brief memory usage command handler.
+ *
+ * The command format is as follows:
+ * - To get the report: ?
+ *
+ * Response (bytes): data=x;bss=x;heap_used=x;heap_free=x;heap_break=0xaddr;stack_max=x;stack_free=x;largest_free=x;
+ * modules:heaters=x,hmi=x,eeprom=x,trace=x,prof=x,zc=x,scope=x,steptest=x,record=x,events=x,control=x,health=x
+ * the data, bss, heap and stack fields are target builds only.
+ * heap_free is the memory in freed heap chunks, stack_free the never touched gap
+ * between heap break and deepest stack, largest_free the biggest of both.
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool memstat_cli(String &cmd, String &response)
+{
+    if (cmd != "?")
+    {
+        response = "command is read only";
+        return false;
+    }
+
+    response = "";
+
+#ifdef ARDUINO_ARCH_STM32
+    struct mallinfo heap = mallinfo();
+
+    uint32_t largest_chunk = 0;
+    if (&__malloc_free_list != nullptr)
+    {
+        noInterrupts();
+        for (memstat_free_chunk *chunk = __malloc_free_list; chunk != nullptr; chunk = chunk->next)
+        {
+            uint32_t usable = chunk->size - sizeof(long);
+            if (usable > largest_chunk)
+                largest_chunk = usable;
+        }
+        interrupts();
+    }
+
+    uintptr_t heap_break = memstat_heap_break();
+    uintptr_t low_water = memstat_stack_low_water();
+    uint32_t stack_free = low_water > heap_break ? low_water - heap_break : 0;
+
+    response += "data=" + String((uint32_t)(&_edata - &_sdata));
+    response += ";bss=" + String((uint32_t)(&_ebss - &_sbss));
+    response += ";heap_used=" + String((uint32_t)heap.uordblks);
+    response += ";heap_free=" + String((uint32_t)heap.fordblks);
+    response += ";heap_break=0x" + String((uint32_t)heap_break, HEX);
+    response += ";stack_max=" + String((uint32_t)((uintptr_t)&_estack - low_water));
+    response += ";stack_free=" + String(stack_free);
+    response += ";largest_free=" + String(largest_chunk > stack_free ? largest_chunk : stack_free);
+    response += ";";
+#endif
+
+    response += "modules:heaters=" + String((uint32_t)(sizeof(Heater) * _heater_count));
+    response += ",hmi=" + String((uint32_t)sizeof(_hmi));
+    response += ",eeprom=" + String((uint32_t)(sizeof(eeprom) + sizeof(i2cBus)));
+    response += ",trace=" + String((uint32_t)trace_ram_usage());
+    response += ",prof=" + String((uint32_t)profiler_ram_usage());
+    response += ",zc=" + String((uint32_t)zc_timing_ram_usage());
+    response += ",scope=" + String((uint32_t)scope_ram_usage());
+    response += ",steptest=" + String((uint32_t)steptest_ram_usage());
+    response += ",record=" + String((uint32_t)record_ram_usage());
+    response += ",events=" + String((uint32_t)events_ram_usage());
+    response += ",control=" + String((uint32_t)control_ram_usage());
+    response += ",health=" + String((uint32_t)sizeof(station_health));
+
+    return true;
+}
@@ -0,0 +1,18 @@
+#ifndef __memstat_H__
+#define __memstat_H__
+
+#include <Arduino.h>
+
+/**
+ * @file memstat.h
+ * @brief RAM usage report: static sections, heap, stack high water mark.
+ *
+ * At boot the free RAM between the heap break and the stack pointer is painted
+ * with a known pattern, the deepest stack excursion is found later by scanning
+ * for the first overwritten word above the current heap break.
+ */
+
+void memstat_paint_stack();
+bool memstat_cli(String &cmd, String &response);
+
+#endif
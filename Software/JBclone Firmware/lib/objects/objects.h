@@ -1,49 +1,66 @@
-#ifndef __PINS_H__
-#define __PINS_H__
-
-/**
- * @file pins.h
- * @brief main configuration for the heater control system.
- * 
- * This file contains the configuration for the heater control system
- * Additionally, it defines the command handlers for the heater control system and the GPIO pin assignments.
- */
-
-#include <Arduino.h>
-#include "EEprom.h"
-#include "display.h"
-#include "Heater.h"
-
-
-// i2c interface for EEPROM
-extern TwoWire i2cBus;
-
-// EEprom object passed to Heater instances for access
-extern EEprom eeprom;
-
-// hmi instance and update functions
-extern Display _hmi;
-
-void HMI_heater1_update(Heater *heater);
-void HMI_heater2_update(Heater *heater);
-void HMI_heater3_update(Heater *heater);
-void HMI_heater4_update(Heater *heater);
-
-//Heaters instantiated
-extern Heater heaters[4];
-extern size_t _heater_count;
-
-// Serial commands
-typedef bool (Heater::*CommandFunc)(String &cmd, String &response);
-
-struct CommandHandler
-{
-	const char *name;
-	CommandFunc func;
-};
-
-//table is optimized so most common commands are parsed faster
-extern CommandHandler commandTable[18];
-extern size_t commandTableSize;
-
-#endif // __PINS_H__
+#ifndef __PINS_H__
+#define __PINS_H__
+
+/**
+ * @file pins.h
+ * @brief main configuration for the heater control system.
+ * 
+ * This file contains the configuration for the heater control system
+ * Additionally, it defines the command handlers for the heater control system and the GPIO pin assignments.
+ */
+
+#include <Arduino.h>
+#include "EEprom.h"
+#include "display.h"
+#include "Heater.h"
+
+
+// i2c interface for EEPROM
+extern TwoWire i2cBus;
+
+// EEprom object passed to Heater instances for access
+extern EEprom eeprom;
+
+// hmi instance and update functions
+extern Display _hmi;
+
+void HMI_heater1_update(Heater *heater);
+void HMI_heater2_update(Heater *heater);
+void HMI_heater3_update(Heater *heater);
+void HMI_heater4_update(Heater *heater);
+
+//Heaters instantiated
+extern Heater heaters[4];
+extern size_t _heater_count;
+
+// zero cross half-cycle counter, sampling half-cycle when it reaches _zero_cross_period
+extern int zero_cross_counter;
+// micros() of the last zero cross the control tick took from the event queue, for the zero cross watchdog
+extern uint32_t zero_cross_timestamp;
+
+// Serial commands
+typedef bool (Heater::*CommandFunc)(String &cmd, String &response);
+
+struct CommandHandler
+{
+	const char *name;
+	CommandFunc func;
+};
+
+//table is optimized so most common commands are parsed faster
+extern CommandHandler commandTable[23];
+extern size_t commandTableSize;
+
+// Station wide commands, addressed with _station_command_id instead of a heater index
+typedef bool (*StationCommandFunc)(String &cmd, String &response);
+
+struct StationCommandHandler
+{
+	const char *name;
+	StationCommandFunc func;
+};
+
+extern StationCommandHandler stationCommandTable[13];
+extern size_t stationCommandTableSize;
+
+#endif // __PINS_H__
@@ -0,0 +1,36 @@
+#ifndef __cycle_counter_H__
+#define __cycle_counter_H__
+
+#include <Arduino.h>
+
+/**
+ * @brief enables the Cortex-M3 DWT cycle counter.
+ *
+ * Must be called once at boot before any cycle_counter_read() call.
+ * The counter runs at F_CPU and wraps every ~59s at 72MHz, differences
+ * between two reads are valid as long as they are computed in uint32_t.
+ */
+inline void cycle_counter_init()
+{
+#ifdef ARDUINO_ARCH_STM32
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * @brief reads the current CPU cycle count.
+ *
+ * On targets without DWT (host builds) the value is derived from micros().
+ */
+inline uint32_t cycle_counter_read()
+{
+#ifdef ARDUINO_ARCH_STM32
+    return DWT->CYCCNT;
+#else
+    return micros() * (uint32_t)(F_CPU / 1000000L);
+#endif
+}
+
+#endif
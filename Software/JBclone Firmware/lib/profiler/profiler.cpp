@@ -0,0 +1,126 @@
+#include "profiler.h"
+
+#ifdef PROFILING
+
+static const char *const section_names[PROF_SECTION_COUNT] = {
+    "loop",
+    "heater_update",
+    "pid_compute",
+    "tcv_to_temp",
+    "zero_cross_isr",
+    "control_tick",
+};
+
+struct ProfileStats
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+};
+
+static ProfileStats profile_table[PROF_SECTION_COUNT];
+
+static void profile_stats_reset(ProfileStats &stats)
+{
+    stats.count = 0;
+    stats.min = UINT32_MAX;
+    stats.max = 0;
+    stats.total = 0;
+}
+
+/**
+ * @brief accumulates a measurement in the section statistics.
+ *
+ * @param section The measured section.
+ * @param cycles Duration of the section in CPU cycles.
+ */
+void profiler_record(ProfileSection section, uint32_t cycles)
+{
+    ProfileStats &stats = profile_table[section];
+
+    if (stats.count == 0)
+        profile_stats_reset(stats);
+
+    stats.count++;
+    stats.total += cycles;
+    if (cycles < stats.min)
+        stats.min = cycles;
+    if (cycles > stats.max)
+        stats.max = cycles;
+}
+
+/**
+ * @brief profiler dump command handler.
+ *
+ * Reports the statistics of every section and resets them.
+ * The command format is as follows:
+ * - To dump and reset the table: ?
+ *
+ * Each section is reported as name:n=count,min=cycles,max=cycles,mean=cycles, sections are separated by ';'.
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool profiler_cli(String &cmd, String &response)
+{
+    if (cmd != "?")
+    {
+        response = "command is read only";
+        return false;
+    }
+
+    // snapshot and reset, the ISR section may be updated concurrently
+    ProfileStats snapshot[PROF_SECTION_COUNT];
+    noInterrupts();
+    memcpy(snapshot, profile_table, sizeof(profile_table));
+    memset(profile_table, 0, sizeof(profile_table));
+    interrupts();
+
+    response = "";
+    for (int i = 0; i < PROF_SECTION_COUNT; i++)
+    {
+        const ProfileStats &stats = snapshot[i];
+        uint32_t mean = stats.count ? (uint32_t)(stats.total / stats.count) : 0;
+
+        if (i > 0)
+            response += ";";
+        response += String(section_names[i]) + ":n=" + String(stats.count);
+        response += ",min=" + String(stats.count ? stats.min : 0);
+        response += ",max=" + String(stats.max);
+        response += ",mean=" + String(mean);
+    }
+
+    return true;
+}
+
+/**
+ * @brief static RAM used by the profiler tables.
+ */
+size_t profiler_ram_usage()
+{
+    return sizeof(profile_table);
+}
+
+#else
+
+void profiler_record(ProfileSection section, uint32_t cycles)
+{
+    (void)section;
+    (void)cycles;
+}
+
+bool profiler_cli(String &cmd, String &response)
+{
+    (void)cmd;
+    response = "profiling disabled in this build";
+    return false;
+}
+
+size_t profiler_ram_usage()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef __profiler_H__
+#define __profiler_H__
+
+#include <Arduino.h>
+#include "cycle_counter.h"
+
+/**
+ * @brief instrumented code sections.
+ *
+ * Every section owns one accumulator, a section must be entered from a single
+ * execution context (main loop or one ISR).
+ */
+enum ProfileSection
+{
+    PROF_LOOP,
+    PROF_HEATER_UPDATE,
+    PROF_PID_COMPUTE,
+    PROF_TCV_TO_TEMP,
+    PROF_ZERO_CROSS_ISR,
+    PROF_CONTROL_TICK,
+    PROF_SECTION_COUNT
+};
+
+void profiler_record(ProfileSection section, uint32_t cycles);
+bool profiler_cli(String &cmd, String &response);
+size_t profiler_ram_usage();
+
+/**
+ * @brief RAII scope that adds its lifetime in CPU cycles to a profiler section.
+ */
+class ProfileScope
+{
+private:
+    ProfileSection _section;
+    uint32_t _start;
+
+public:
+    ProfileScope(ProfileSection section) : _section(section), _start(cycle_counter_read()) {}
+    ~ProfileScope() { profiler_record(_section, cycle_counter_read() - _start); }
+};
+
+// instrumentation is compiled only when PROFILING is defined (see platformio.ini debug env)
+#ifdef PROFILING
+#define PROFILE_SCOPE(section) ProfileScope _profile_scope(section)
+#else
+#define PROFILE_SCOPE(section) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,323 @@
+#include "recorder.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "control.h"
+#include <string.h>
+
+static_assert((record_buffer_size & (record_buffer_size - 1)) == 0, "record_buffer_size must be a power of two");
+static_assert((record_text_size & (record_text_size - 1)) == 0, "record_text_size must be a power of two");
+static_assert(sizeof(RecordEvent) == 12, "RecordEvent layout is part of the recording format");
+
+constexpr size_t record_channels = sizeof(heaters) / sizeof(heaters[0]);
+
+static RecordEvent record_buffer[record_buffer_size];
+static uint8_t record_written[record_buffer_size]; // set by the writer once the slot is filled
+static uint32_t record_head = 0; // events claimed by the writers
+static uint32_t record_tail = 0; // events sent
+
+// RC: lines, the command handlers write, record_update() sends
+static char record_text[record_text_size];
+static uint32_t record_text_head = 0; // bytes of complete lines
+static uint32_t record_text_tail = 0; // bytes sent
+static volatile bool record_active = false;
+static uint32_t record_sent = 0;
+static uint32_t record_dropped = 0;
+static uint32_t record_zero_cross_us = 0;
+
+// stand level last recorded per channel, 0xFF until the first read
+static uint8_t record_stand_level[record_channels];
+
+// control state at the start of the recording
+static Heater::Snapshot record_snapshots[record_channels];
+
+static const char record_hex[] = "0123456789ABCDEF";
+
+static void record_write_hex(Print &port, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < length; i++)
+    {
+        port.write(record_hex[bytes[i] >> 4]);
+        port.write(record_hex[bytes[i] & 0x0F]);
+    }
+}
+
+/**
+ * @brief queues an event, dropped and counted when the ring is full.
+ *
+ * Safe to call from ISR and main loop at the same time, the slot is claimed with a
+ * compare and swap and only the main loop reads the ring. A writer preempted between the
+ * claim and the write holds back the slots after its own, they are sent once it is marked
+ * written.
+ *
+ * @param type The event type.
+ * @param channel The heater channel.
+ * @param arg The event argument, see RecordEventType.
+ * @param value The event value, see RecordEventType.
+ * @param t_us The event timestamp, micros().
+ */
+void record_event(RecordEventType type, uint8_t channel, uint16_t arg, uint32_t value, uint32_t t_us)
+{
+    if (!record_active)
+        return;
+
+    uint32_t head = __atomic_load_n(&record_head, __ATOMIC_RELAXED);
+    do
+    {
+        if (head - __atomic_load_n(&record_tail, __ATOMIC_ACQUIRE) >= record_buffer_size)
+        {
+            __atomic_fetch_add(&record_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&record_head, &head, head + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    const size_t slot = head & (record_buffer_size - 1);
+    RecordEvent &event = record_buffer[slot];
+    event.t_us = t_us;
+    event.type = type;
+    event.channel = channel;
+    event.arg = arg;
+    event.value = value;
+    __atomic_store_n(&record_written[slot], 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief zero cross event, called at ISR entry.
+ *
+ * @param counter The zero cross counter before this half-cycle.
+ */
+void record_zero_cross(uint16_t counter)
+{
+    record_zero_cross_us = micros();
+    record_event(REC_ZERO_CROSS, 0, counter, 0, record_zero_cross_us);
+}
+
+/**
+ * @brief output mask of the half-cycle, stamped with its zero cross.
+ */
+void record_output_mask(uint16_t mask)
+{
+    record_event(REC_OUTPUT_MASK, 0, mask, 0, record_zero_cross_us);
+}
+
+/**
+ * @brief PID output, recorded as float bits so the replay compares it exactly.
+ *
+ * @param channel The heater channel.
+ * @param output The PID output.
+ * @param t_us The timestamp of the sample the output was computed from.
+ */
+void record_pid(uint8_t channel, float output, uint32_t t_us)
+{
+    uint32_t bits;
+    memcpy(&bits, &output, sizeof(bits));
+    record_event(REC_PID, channel, 0, bits, t_us);
+}
+
+/**
+ * @brief stand pin level read by a heater, recorded on change only.
+ */
+void record_stand(uint8_t channel, int level)
+{
+    if (!record_active || channel >= record_channels || record_stand_level[channel] == level)
+        return;
+
+    record_stand_level[channel] = level;
+    record_event(REC_STAND, channel, level, 0, micros());
+}
+
+/**
+ * @brief received command, queued as an RC: line, dropped and counted when it does not fit.
+ *
+ * Command handlers only. In the RTOS build the comms and HMI tasks both call it, the ControlLock
+ * keeps their lines whole.
+ *
+ * @param source 0 usb, 1 hmi.
+ * @param message The command as received, without terminator.
+ */
+void record_command(uint8_t source, const String &message)
+{
+    if (!record_active)
+        return;
+
+    String line = "RC:" + String(micros()) + "," + String(source) + "," + message + _serial_usb_terminator;
+
+    ControlLock lock;
+    const uint32_t head = record_text_head;
+    if (line.length() > record_text_size - (head - __atomic_load_n(&record_text_tail, __ATOMIC_ACQUIRE)))
+    {
+        __atomic_fetch_add(&record_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    for (size_t i = 0; i < line.length(); i++)
+        record_text[(head + i) & (record_text_size - 1)] = line[i];
+    __atomic_store_n(&record_text_head, head + line.length(), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief sends the queued command lines and the written events, 8 per line.
+ *
+ * Must be called once per main loop iteration, from one context only.
+ *
+ * @param port The output port.
+ */
+void record_update(Print &port)
+{
+    const uint32_t text_head = __atomic_load_n(&record_text_head, __ATOMIC_ACQUIRE);
+    uint32_t text_tail = record_text_tail;
+    while (text_tail != text_head)
+        port.write(record_text[text_tail++ & (record_text_size - 1)]);
+    __atomic_store_n(&record_text_tail, text_tail, __ATOMIC_RELEASE);
+
+    uint32_t tail = record_tail;
+    for (;;)
+    {
+        // up to the first slot claimed but not written yet
+        const uint32_t head = __atomic_load_n(&record_head, __ATOMIC_RELAXED);
+        uint32_t count = 0;
+        while (count < 8 && tail + count != head &&
+               __atomic_load_n(&record_written[(tail + count) & (record_buffer_size - 1)], __ATOMIC_ACQUIRE))
+            count++;
+        if (count == 0)
+            break;
+
+        port.print("R:");
+        for (uint32_t i = 0; i < count; i++, tail++, record_sent++)
+        {
+            const size_t slot = tail & (record_buffer_size - 1);
+            record_write_hex(port, &record_buffer[slot], sizeof(RecordEvent));
+            record_written[slot] = 0;
+        }
+        port.print(_serial_usb_terminator);
+
+        // the slots are free for the writers only once sent
+        __atomic_store_n(&record_tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief starts a recording, writes the header and the heater snapshots.
+ *
+ * The snapshots, the start time and the zero cross phase are taken with interrupts
+ * disabled and the recording is armed in the same section, so the first zero cross
+ * after it is the first event. The control tick runs while the lines are sent.
+ */
+static void record_start(Print &port)
+{
+    noInterrupts();
+    for (size_t ch = 0; ch < record_channels; ch++)
+    {
+        heaters[ch].snapshot_save(record_snapshots[ch]);
+        record_stand_level[ch] = 0xFF;
+    }
+    uint32_t start_ms = millis();
+    uint32_t start_us = micros();
+    int counter = zero_cross_counter;
+    record_head = 0;
+    record_tail = 0;
+    memset(record_written, 0, sizeof(record_written));
+    record_text_head = 0;
+    record_text_tail = 0;
+    record_sent = 0;
+    record_dropped = 0;
+    record_active = true;
+    interrupts();
+
+    ControlUnlock unlock;
+    port.print("RH:");
+    port.print(record_format_version);
+    port.print(',');
+    port.print(start_ms);
+    port.print(',');
+    port.print(start_us);
+    port.print(',');
+    port.print(counter);
+    port.print(',');
+    port.print((uint32_t)record_channels);
+    port.print(_serial_usb_terminator);
+
+    for (size_t ch = 0; ch < record_channels; ch++)
+    {
+        port.print("RS:");
+        port.print((uint32_t)ch);
+        port.print(',');
+        record_write_hex(port, &record_snapshots[ch], sizeof(Heater::Snapshot));
+        port.print(_serial_usb_terminator);
+    }
+}
+
+/**
+ * @brief recording command handler.
+ *
+ * The command format is as follows:
+ * - To start: start
+ *   header and snapshot lines are sent first, events follow until stop
+ * - To stop: stop
+ *   the remaining events and the RE: line are sent first
+ * - To get the state: ?
+ *   state=idle|recording,events=n,dropped=n
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool record_cli(String &cmd, String &response)
+{
+    if (cmd == "?")
+    {
+        response = "state=" + String(record_active ? "recording" : "idle");
+        response += ",events=" + String(record_sent);
+        response += ",dropped=" + String(__atomic_load_n(&record_dropped, __ATOMIC_RELAXED));
+        return true;
+    }
+
+    if (cmd == "start")
+    {
+#ifndef RECORDING
+        response = "built without RECORDING";
+        return false;
+#endif
+        if (record_active)
+        {
+            response = "already recording";
+            return false;
+        }
+        record_start(_serial_usb);
+        response = "OK";
+        return true;
+    }
+
+    if (cmd == "stop")
+    {
+        if (!record_active)
+        {
+            response = "not recording";
+            return false;
+        }
+        record_active = false;
+
+        // the ring is lock free, the control tick runs while it drains
+        ControlUnlock unlock;
+        record_update(_serial_usb);
+
+        _serial_usb.print("RE:events=");
+        _serial_usb.print(record_sent);
+        _serial_usb.print(",dropped=");
+        _serial_usb.print(__atomic_load_n(&record_dropped, __ATOMIC_RELAXED));
+        _serial_usb.print(_serial_usb_terminator);
+
+        response = "OK";
+        return true;
+    }
+
+    response = "invalid value";
+    return false;
+}
+
+/**
+ * @brief static RAM used by the event ring, the command lines and the start snapshots.
+ */
+size_t record_ram_usage()
+{
+    return sizeof(record_buffer) + sizeof(record_written) + sizeof(record_text) + sizeof(record_snapshots);
+}
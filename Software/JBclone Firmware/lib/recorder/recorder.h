@@ -0,0 +1,91 @@
+#ifndef __recorder_H__
+#define __recorder_H__
+
+#include <Arduino.h>
+
+/**
+ * @file recorder.h
+ * @brief streamed recording of the control loop inputs and outputs for host replay.
+ *
+ * "s:record:start" captures the control state of every heater (Heater::Snapshot) and
+ * then streams over USB, until "s:record:stop":
+ * - inputs: zero cross timestamps, raw ADC code of every thermocouple sample, stand pin
+ *   levels as seen by the heaters and the received commands
+ * - outputs: heater output mask of every half-cycle, PID output and state transitions
+ *
+ * Lines (all timestamps are micros() of the station):
+ * - RH:version,start_ms,start_us,zero_cross_counter,channels
+ * - RS:ch,snapshot as little endian hex bytes
+ * - R:up to 8 events as little endian hex bytes (u32 t_us, u8 type, u8 channel, u16 arg, u32 value)
+ * - RC:t_us,source,command text (source 0 usb, 1 hmi)
+ * - RE:events=n,dropped=n at the end
+ *
+ * Events are queued in a RAM ring from the ISRs and the main loop and written out by
+ * record_update(); a slot is sent only once its writer marked it written. Command lines
+ * are queued as text and written out there too, so only record_update() and the record
+ * command write recording lines and a line never splits another. A recording with dropped
+ * events or commands can not be replayed. The ring covers a
+ * channel save, the main loop does not write it out for ~650ms while the control tick
+ * keeps sampling.
+ * jbclone_replay (native/replay) feeds a recording through the firmware on the host and
+ * checks the outputs bit for bit.
+ */
+
+constexpr uint8_t record_format_version = 1;
+#ifdef JBCLONE_RTOS
+// the comms task writes the ring out every 1ms, EEPROM saves do not hold it off
+constexpr size_t record_buffer_size = 64; // events, must be a power of two
+#else
+constexpr size_t record_buffer_size = 256; // events, must be a power of two
+#endif
+constexpr size_t record_text_size = 128; // bytes of RC: lines not sent yet, must be a power of two
+
+enum RecordEventType : uint8_t
+{
+    REC_ZERO_CROSS = 1, // arg: zero cross counter at ISR entry
+    REC_OUTPUT_MASK,    // arg: bit n set when channel n conducts, zero cross timestamp
+    REC_SAMPLE,         // channel, arg: raw ADC code, sample timestamp
+    REC_PID,            // channel, value: output float bits, timestamp of the sample used
+    REC_STATE,          // channel, arg: HeaterState
+    REC_STAND,          // channel, arg: stand pin level, on change
+};
+
+struct RecordEvent
+{
+    uint32_t t_us;
+    uint8_t type;
+    uint8_t channel;
+    uint16_t arg;
+    uint32_t value;
+};
+
+void record_event(RecordEventType type, uint8_t channel, uint16_t arg, uint32_t value, uint32_t t_us);
+void record_zero_cross(uint16_t counter);
+void record_output_mask(uint16_t mask);
+void record_pid(uint8_t channel, float output, uint32_t t_us);
+void record_stand(uint8_t channel, int level);
+void record_command(uint8_t source, const String &message);
+void record_update(Print &port);
+bool record_cli(String &cmd, String &response);
+size_t record_ram_usage();
+
+// recording hooks are compiled only when RECORDING is defined (see platformio.ini)
+#ifdef RECORDING
+#define RECORD_ZERO_CROSS(counter) record_zero_cross(counter)
+#define RECORD_OUTPUT_MASK(mask) record_output_mask(mask)
+#define RECORD_SAMPLE(channel, code, t_us) record_event(REC_SAMPLE, channel, code, 0, t_us)
+#define RECORD_PID(channel, output, t_us) record_pid(channel, output, t_us)
+#define RECORD_STATE(channel, state) record_event(REC_STATE, channel, state, 0, micros())
+#define RECORD_STAND(channel, level) record_stand(channel, level)
+#define RECORD_COMMAND(source, message) record_command(source, message)
+#else
+#define RECORD_ZERO_CROSS(counter) ((void)0)
+#define RECORD_OUTPUT_MASK(mask) ((void)0)
+#define RECORD_SAMPLE(channel, code, t_us) ((void)0)
+#define RECORD_PID(channel, output, t_us) ((void)0)
+#define RECORD_STATE(channel, state) ((void)0)
+#define RECORD_STAND(channel, level) ((void)0)
+#define RECORD_COMMAND(source, message) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,227 @@
+#include "rtos.h"
+
+#ifdef JBCLONE_RTOS
+
+constexpr size_t rtos_storage_queue_length = 8;
+constexpr size_t rtos_max_tasks = 8; // statistics, application tasks and the kernel ones
+
+struct RtosStorageRequest
+{
+    Heater *heater;
+    HeaterStorage block;
+    TaskHandle_t requester; // notified with the result, nullptr if nobody waits
+};
+
+static SemaphoreHandle_t rtos_control_mutex = nullptr;
+static QueueHandle_t rtos_storage_queue = nullptr;
+static uint32_t rtos_storage_requests = 0;
+static uint32_t rtos_storage_dropped = 0;
+static uint32_t rtos_storage_max_queued = 0;
+
+// statistics of the previous "?", runtimes by task number
+static TaskStatus_t rtos_task_status[rtos_max_tasks];
+static uint32_t rtos_last_runtime[rtos_max_tasks];
+static uint32_t rtos_last_total_runtime = 0;
+
+#ifdef ARDUINO_ARCH_STM32
+/**
+ * @brief run time statistics clock, see STM32FreeRTOSConfig.h.
+ */
+extern "C" uint32_t rtos_run_time_us(void)
+{
+    return micros();
+}
+#endif
+
+/**
+ * @brief true once the scheduler started, the tasks then own the loop work.
+ */
+bool rtos_running()
+{
+    return xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+}
+
+/**
+ * @brief creates the control mutex, before the scheduler starts.
+ */
+void rtos_control_mutex_init()
+{
+    if (rtos_control_mutex == nullptr)
+        rtos_control_mutex = xSemaphoreCreateRecursiveMutex();
+}
+
+/**
+ * @brief takes the control mutex, one level per call. No-op before the scheduler starts.
+ */
+void rtos_control_mutex_take()
+{
+    if (rtos_control_mutex != nullptr && rtos_running())
+        xSemaphoreTakeRecursive(rtos_control_mutex, portMAX_DELAY);
+}
+
+/**
+ * @brief gives back one level of the control mutex.
+ */
+void rtos_control_mutex_give()
+{
+    if (rtos_control_mutex != nullptr && rtos_running())
+        xSemaphoreGiveRecursive(rtos_control_mutex);
+}
+
+/**
+ * @brief true if the calling task holds the control mutex, always before the scheduler starts.
+ */
+bool rtos_control_mutex_owned()
+{
+    if (rtos_control_mutex == nullptr || !rtos_running())
+        return true;
+    return xSemaphoreGetMutexHolder(rtos_control_mutex) == xTaskGetCurrentTaskHandle();
+}
+
+/**
+ * @brief creates the storage request queue, before the storage task.
+ */
+void rtos_storage_init()
+{
+    if (rtos_storage_queue == nullptr)
+        rtos_storage_queue = xQueueCreate(rtos_storage_queue_length, sizeof(RtosStorageRequest));
+}
+
+/**
+ * @brief queues an EEPROM block write for the storage task.
+ *
+ * @note Call from a task without the control lock, see Heater::storage_request().
+ *
+ * @param heater The channel to write.
+ * @param block The block to write.
+ * @param wait true to wait for the write and return its result, false to return once
+ *             queued; a full queue drops a request that does not wait.
+ * @return true if the block was written (wait) or queued, false otherwise.
+ */
+bool rtos_storage_request(Heater *heater, HeaterStorage block, bool wait)
+{
+    RtosStorageRequest request = {heater, block, wait ? xTaskGetCurrentTaskHandle() : nullptr};
+
+    if (xQueueSend(rtos_storage_queue, &request, wait ? portMAX_DELAY : 0) != pdTRUE)
+    {
+        rtos_storage_dropped++;
+        return false;
+    }
+    rtos_storage_requests++;
+
+    const uint32_t queued = uxQueueMessagesWaiting(rtos_storage_queue);
+    if (queued > rtos_storage_max_queued)
+        rtos_storage_max_queued = queued;
+
+    if (!wait)
+        return true;
+
+    uint32_t result = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &result, portMAX_DELAY);
+    return result != 0;
+}
+
+/**
+ * @brief storage task body, executes the EEPROM writes in request order.
+ */
+void rtos_storage_task(void *parameters)
+{
+    (void)parameters;
+
+    RtosStorageRequest request;
+    for (;;)
+    {
+        if (xQueueReceive(rtos_storage_queue, &request, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        const bool good_op = request.heater->storage_write(request.block);
+        if (request.requester != nullptr)
+            xTaskNotify(request.requester, good_op, eSetValueWithOverwrite);
+    }
+}
+
+static const char *rtos_state_name(eTaskState state)
+{
+    switch (state)
+    {
+    case eRunning:
+        return "run";
+    case eReady:
+        return "ready";
+    case eBlocked:
+        return "blocked";
+    case eSuspended:
+        return "suspended";
+    default:
+        return "deleted";
+    }
+}
+
+/**
+ * @brief RTOS statistics command handler.
+ *
+ * The command format is as follows:
+ * - To get the statistics: ?
+ *
+ * Response: window_us=x;heap_free=x;storage:requests=x,dropped=x,max_queued=x;
+ * name:prio=x,cpu=x,stack_free=x,state=x;...
+ * cpu is the percent of the time since the previous "?" the task ran, stack_free the
+ * least free stack it ever had in bytes. heap_free is the free kernel heap, on the target
+ * the newlib heap shared with String (see STM32FreeRTOSConfig.h), whose low water mark is
+ * the stack_free of "s:mem:?".
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool rtos_cli(String &cmd, String &response)
+{
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    uint32_t total_runtime = 0;
+    const UBaseType_t count = uxTaskGetSystemState(rtos_task_status, rtos_max_tasks, &total_runtime);
+    if (count == 0)
+    {
+        response = "too many tasks";
+        return false;
+    }
+
+    const uint32_t window = total_runtime - rtos_last_total_runtime;
+    rtos_last_total_runtime = total_runtime;
+
+    response = "window_us=" + String(window);
+    response += ";heap_free=" + String((uint32_t)xPortGetFreeHeapSize());
+    response += ";storage:requests=" + String(rtos_storage_requests);
+    response += ",dropped=" + String(rtos_storage_dropped);
+    response += ",max_queued=" + String(rtos_storage_max_queued);
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        const TaskStatus_t &task = rtos_task_status[i];
+        const size_t slot = task.xTaskNumber % rtos_max_tasks;
+        const uint32_t ran = task.ulRunTimeCounter - rtos_last_runtime[slot];
+        rtos_last_runtime[slot] = task.ulRunTimeCounter;
+
+        response += ";" + String(task.pcTaskName);
+        response += ":prio=" + String((uint32_t)task.uxCurrentPriority);
+        response += ",cpu=" + String(window > 0 ? 100.0f * ran / window : 0.0f, 1);
+        response += ",stack_free=" + String((uint32_t)(task.usStackHighWaterMark * sizeof(StackType_t)));
+        response += ",state=" + String(rtos_state_name(task.eCurrentState));
+    }
+    return true;
+}
+
+#else
+
+bool rtos_cli(String &cmd, String &response)
+{
+    (void)cmd;
+    response = "RTOS build only";
+    return false;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef __rtos_H__
+#define __rtos_H__
+
+#include <Arduino.h>
+#include "Heater.h"
+
+#ifdef JBCLONE_RTOS
+#ifdef ARDUINO_ARCH_STM32
+#include <STM32FreeRTOS.h>
+#else
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#endif
+#endif
+
+/**
+ * @file rtos.h
+ * @brief FreeRTOS build (JBCLONE_RTOS): kernel objects shared by the tasks and task statistics.
+ *
+ * The main loop is split in tasks by deadline, the task bodies are in src/tasks.h:
+ *   control  priority 4, every 1ms   health, hartbeat, energy, sleep detection, step tests
+ *   comms    priority 3, every 1ms   USB commands and recorder output
+ *   hmi      priority 2, every 10ms  display commands and refresh
+ *   storage  priority 1, on request  EEPROM writes of every channel
+ * Sampling and PID stay in the control tick interrupt, above
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY so no kernel critical section delays it; the tasks
+ * mask it with ControlLock as the loop did, behind the control mutex.
+ * The storage task owns the EEPROM: a command queues its save and waits for the result,
+ * the periodic energy record is only queued, so only the storage task waits on the bus.
+ *
+ * Without JBCLONE_RTOS only rtos_cli() is built and answers an error.
+ */
+
+bool rtos_running();
+void rtos_control_mutex_init();
+void rtos_control_mutex_take();
+void rtos_control_mutex_give();
+bool rtos_control_mutex_owned();
+void rtos_storage_init();
+bool rtos_storage_request(Heater *heater, HeaterStorage block, bool wait);
+void rtos_storage_task(void *parameters);
+bool rtos_cli(String &cmd, String &response);
+
+#endif
@@ -0,0 +1,293 @@
+#include "scope.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "parser.h"
+#include "cycle_counter.h"
+#include "control.h"
+
+#ifdef ARDUINO_ARCH_STM32
+#include "PeripheralPins.h"
+#include "pinmap.h"
+#endif
+
+enum ScopeState : uint8_t
+{
+    SCOPE_IDLE,
+    SCOPE_ARMED,
+    SCOPE_TRIGGERED,
+    SCOPE_DONE,
+};
+
+static uint16_t scope_buffer[scope_buffer_size];
+static volatile ScopeState scope_state = SCOPE_IDLE;
+static ScopeTrigger scope_trigger_event = SCOPE_TRIGGER_ZERO_CROSS;
+static uint8_t scope_channel = 0;
+static uint32_t scope_pin = 0;
+static uint32_t scope_length = 0;
+static uint32_t scope_post_delay_us = 0;
+static volatile uint32_t scope_trigger_us = 0;
+static uint32_t scope_start_us = 0; // actual start of the burst from the trigger
+static uint32_t scope_capture_cycles = 0;
+
+static const char *scope_trigger_names[] = {"zc", "off"};
+
+#ifdef ARDUINO_ARCH_STM32
+/**
+ * @brief continuous conversion of one regular channel on ADC1, polled on EOC.
+ *
+ * analogRead() initializes and releases ADC1 on every call, the capture owns it
+ * for the burst and leaves it in the same released state. Runs in the control tick only,
+ * the context of every analogRead() of the channels.
+ */
+static void scope_capture()
+{
+    uint32_t adc_channel = STM_PIN_CHANNEL(pinmap_function(digitalPinToPinName(scope_pin), PinMap_ADC));
+
+    RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+    ADC1->CR1 = 0;
+    ADC1->SMPR2 = 0; // 1.5 cycles sampling, 14 cycles per conversion
+    ADC1->SMPR1 = 0;
+    ADC1->SQR1 = 0;  // one conversion
+    ADC1->SQR3 = adc_channel;
+    ADC1->CR2 = ADC_CR2_ADON;
+    delayMicroseconds(2); // tSTAB
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_CONT | ADC_CR2_EXTSEL | ADC_CR2_EXTTRIG;
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+
+    uint32_t start = cycle_counter_read();
+    for (uint32_t i = 0; i < scope_length; i++)
+    {
+        while (!(ADC1->SR & ADC_SR_EOC))
+        {
+        }
+        scope_buffer[i] = ADC1->DR; // clears EOC
+    }
+    scope_capture_cycles = cycle_counter_read() - start;
+
+    ADC1->CR2 = 0;
+    RCC->APB2RSTR |= RCC_APB2RSTR_ADC1RST;
+    RCC->APB2RSTR &= ~RCC_APB2RSTR_ADC1RST;
+    RCC->APB2ENR &= ~RCC_APB2ENR_ADC1EN;
+}
+#else
+static void scope_capture()
+{
+    uint32_t start = cycle_counter_read();
+    for (uint32_t i = 0; i < scope_length; i++)
+        scope_buffer[i] = analogRead(scope_pin);
+    scope_capture_cycles = cycle_counter_read() - start;
+}
+#endif
+
+/**
+ * @brief trigger source hook, timestamps the armed capture when the event matches.
+ *
+ * Called from the zero cross ISR, the capture itself runs in scope_update().
+ *
+ * @param event The trigger event.
+ * @param channel The heater channel of a switch-off event.
+ */
+void scope_trigger(ScopeTrigger event, uint8_t channel)
+{
+    if (scope_state != SCOPE_ARMED || event != scope_trigger_event)
+        return;
+    if (event == SCOPE_TRIGGER_SWITCH_OFF && channel != scope_channel)
+        return;
+
+    scope_trigger_us = micros();
+    scope_state = SCOPE_TRIGGERED;
+}
+
+/**
+ * @brief runs a triggered capture once its delay ends within this tick.
+ *
+ * @note Call from the control tick, after the samples of the channels and the tick timing.
+ */
+void scope_update()
+{
+    if (scope_state != SCOPE_TRIGGERED)
+        return;
+
+    const uint32_t elapsed = micros() - scope_trigger_us;
+    if (elapsed < scope_post_delay_us)
+    {
+        // a later tick is closer to the start
+        if (scope_post_delay_us - elapsed > _control_tick_us)
+            return;
+        delayMicroseconds(scope_post_delay_us - elapsed);
+    }
+
+    scope_start_us = micros() - scope_trigger_us;
+    scope_capture();
+    scope_state = SCOPE_DONE;
+    control_tick_stretched();
+}
+
+static bool scope_parse_uint(const String &in, uint32_t max, uint32_t &result)
+{
+    float value;
+    if (!parseFloat(in, value) || value < 0.0f || value > max || value != (uint32_t)value)
+        return false;
+    result = (uint32_t)value;
+    return true;
+}
+
+static bool scope_arm(String &cmd, String &response)
+{
+    String fields[4];
+    int start = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        int comma = cmd.indexOf(',', start);
+        if ((comma < 0) != (i == 3))
+        {
+            response = "expected ch,trigger,length,post_delay_us";
+            return false;
+        }
+        fields[i] = cmd.substring(start, comma < 0 ? cmd.length() : comma);
+        start = comma + 1;
+    }
+
+    uint32_t channel, length, post_delay_us;
+    if (!scope_parse_uint(fields[0], _heater_count - 1, channel))
+    {
+        response = "invalid channel";
+        return false;
+    }
+
+    ScopeTrigger event;
+    if (fields[1] == scope_trigger_names[SCOPE_TRIGGER_ZERO_CROSS])
+        event = SCOPE_TRIGGER_ZERO_CROSS;
+    else if (fields[1] == scope_trigger_names[SCOPE_TRIGGER_SWITCH_OFF])
+        event = SCOPE_TRIGGER_SWITCH_OFF;
+    else
+    {
+        response = "invalid trigger, zc or off";
+        return false;
+    }
+
+    if (!scope_parse_uint(fields[2], scope_buffer_size, length) || length == 0)
+    {
+        response = "invalid length 1-" + String((uint32_t)scope_buffer_size);
+        return false;
+    }
+
+    if (!scope_parse_uint(fields[3], scope_max_post_delay_us, post_delay_us))
+    {
+        response = "invalid delay 0-" + String(scope_max_post_delay_us);
+        return false;
+    }
+
+    noInterrupts();
+    scope_channel = channel;
+    scope_pin = heaters[channel].get_tc_pin();
+    scope_trigger_event = event;
+    scope_length = length;
+    scope_post_delay_us = post_delay_us;
+    scope_state = SCOPE_ARMED;
+    interrupts();
+
+    response = "OK";
+    return true;
+}
+
+static void scope_print_info(String &response)
+{
+    response += ",ch=" + String(scope_channel);
+    response += ",trigger=" + String(scope_trigger_names[scope_trigger_event]);
+    response += ",post_delay_us=" + String(scope_post_delay_us);
+    response += ",start_us=" + String(scope_state == SCOPE_DONE ? scope_start_us : 0);
+    uint32_t period_ns = scope_length > 0 ? (uint32_t)((uint64_t)scope_capture_cycles * 1000000000ULL / F_CPU / scope_length) : 0;
+    response += ",period_ns=" + String(period_ns);
+}
+
+/**
+ * @brief writes the captured samples.
+ *
+ * Every line is "S:" followed by up to 32 samples as 3 digit hex ADC codes. A done capture
+ * is not written by the control tick, it runs while the lines are sent.
+ */
+static void scope_dump(Print &port)
+{
+    ControlUnlock unlock;
+    static const char hex[] = "0123456789ABCDEF";
+
+    for (uint32_t i = 0; i < scope_length; i++)
+    {
+        if (i % 32 == 0)
+            port.print("S:");
+
+        uint16_t code = scope_buffer[i];
+        port.write(hex[(code >> 8) & 0x0F]);
+        port.write(hex[(code >> 4) & 0x0F]);
+        port.write(hex[code & 0x0F]);
+
+        if (i % 32 == 31 || i == scope_length - 1)
+            port.print(_serial_usb_terminator);
+    }
+}
+
+/**
+ * @brief scope capture command handler.
+ *
+ * The command format is as follows:
+ * - To arm a capture: ch,trigger,length,post_delay_us
+ *   trigger is zc (next zero cross) or off (next switch-off of the channel output),
+ *   length 1-scope_buffer_size samples, post_delay_us 0-scope_max_post_delay_us from trigger to
+ *   first sample, no capture before the trigger
+ * - To get the state: ?
+ *   state=idle|armed|triggered|done,samples=n,ch=..,trigger=..,post_delay_us=..,start_us=..,period_ns=..
+ *   start_us is the actual start of the burst from the trigger, post_delay_us or later
+ * - To dump the capture: dump
+ *   sample lines are sent first, the response reports the capture info as ?
+ * - To disarm: cancel
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool scope_cli(String &cmd, String &response)
+{
+    static const char *state_names[] = {"idle", "armed", "triggered", "done"};
+
+    if (cmd == "?")
+    {
+        response = "state=" + String(state_names[scope_state]);
+        response += ",samples=" + String(scope_state == SCOPE_DONE ? scope_length : 0);
+        scope_print_info(response);
+        return true;
+    }
+
+    if (cmd == "cancel")
+    {
+        noInterrupts();
+        if (scope_state == SCOPE_ARMED || scope_state == SCOPE_TRIGGERED)
+            scope_state = SCOPE_IDLE;
+        interrupts();
+        response = "OK";
+        return true;
+    }
+
+    if (cmd == "dump")
+    {
+        if (scope_state != SCOPE_DONE)
+        {
+            response = "no capture";
+            return false;
+        }
+        scope_dump(_serial_usb);
+        response = "samples=" + String(scope_length);
+        scope_print_info(response);
+        return true;
+    }
+
+    return scope_arm(cmd, response);
+}
+
+/**
+ * @brief static RAM used by the capture buffer.
+ */
+size_t scope_ram_usage()
+{
+    return sizeof(scope_buffer);
+}
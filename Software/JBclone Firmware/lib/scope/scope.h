@@ -0,0 +1,38 @@
+#ifndef __scope_H__
+#define __scope_H__
+
+#include <Arduino.h>
+
+/**
+ * @file scope.h
+ * @brief burst capture of raw ADC codes from one thermocouple channel.
+ *
+ * A capture is armed with "s:scope:ch,trigger,length,post_delay_us" and fires on the next
+ * zero cross (trigger "zc") or on the next switch-off of the channel output (trigger "off").
+ * The zero cross ISR only timestamps the trigger. The burst runs in the control tick, which
+ * owns the ADC (analogRead() of the samples), at the maximum conversion rate: the first tick
+ * within one tick period of the delay waits out the rest and captures, so that tick is
+ * stretched by up to _control_tick_us + length conversions. The capture runs after the
+ * measured part of the tick, outside the control response bound and the late and overrun
+ * counters of control.h. The actual start from the trigger is reported as start_us.
+ * There is no pre-trigger capture: the burst always starts post_delay_us after the trigger.
+ * A pre-trigger ring would need the ADC converting continuously, and the channel samples
+ * share it with the capture.
+ * The buffer is sent over USB with "s:scope:dump".
+ */
+
+constexpr size_t scope_buffer_size = 512;   // samples
+constexpr uint32_t scope_max_post_delay_us = 5000; // half of a mains half-cycle
+
+enum ScopeTrigger : uint8_t
+{
+    SCOPE_TRIGGER_ZERO_CROSS,
+    SCOPE_TRIGGER_SWITCH_OFF,
+};
+
+void scope_trigger(ScopeTrigger event, uint8_t channel);
+void scope_update();
+bool scope_cli(String &cmd, String &response);
+size_t scope_ram_usage();
+
+#endif
@@ -0,0 +1,230 @@
+#include "steptest.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "parser.h"
+#include "control.h"
+
+enum StepTestResult : uint8_t
+{
+    STEPTEST_IDLE,
+    STEPTEST_RUNNING,
+    STEPTEST_DONE,
+    STEPTEST_FULL,
+    STEPTEST_FAULT,
+    STEPTEST_STOPPED,
+};
+
+// written by the control tick while running, the loop reads them under ControlLock
+static StepTestSample steptest_buffer[steptest_buffer_size];
+static volatile size_t steptest_count = 0;
+static volatile StepTestResult steptest_result = STEPTEST_IDLE;
+static uint8_t steptest_channel = 0;
+static float steptest_duty = 0.0f;
+static uint32_t steptest_duration_ms = 0;
+static uint32_t steptest_start_ms = 0;
+static uint32_t steptest_start_us = 0;
+
+static const char *steptest_result_names[] = {"idle", "running", "done", "full", "fault", "stopped"};
+
+static void steptest_finish(StepTestResult result)
+{
+    heaters[steptest_channel].open_loop_stop();
+    steptest_result = result;
+}
+
+/**
+ * @brief records a thermocouple sample of the running test, control tick only.
+ *
+ * Called by Heater::pid_sample() for every sample, so none is lost while the loop is
+ * blocked (EEPROM saves, dumps, serial timeouts). Stops recording when the buffer is full.
+ *
+ * @param channel The sampled channel.
+ * @param timestamp micros() of the sample.
+ * @param pv The sampled temperature in C.
+ */
+void steptest_sample(uint8_t channel, uint32_t timestamp, float pv)
+{
+    if (steptest_result != STEPTEST_RUNNING || channel != steptest_channel || steptest_count >= steptest_buffer_size ||
+        heaters[channel].get_state() != HEATER_OPEN_LOOP)
+        return;
+
+    pv *= 10.0f;
+
+    StepTestSample &sample = steptest_buffer[steptest_count];
+    sample.t_10us = (uint16_t)((timestamp - steptest_start_us) / 10);
+    sample.pv_dc = (uint16_t)constrain(pv, 0.0f, 65535.0f);
+    steptest_count = steptest_count + 1;
+}
+
+/**
+ * @brief ends the running test when due.
+ *
+ * Must be called once per main loop iteration, after the heaters update.
+ */
+void steptest_update()
+{
+    if (steptest_result != STEPTEST_RUNNING)
+        return;
+
+    ControlLock lock;
+    Heater &heater = heaters[steptest_channel];
+
+    // runaway or external disable
+    if (heater.get_state() != HEATER_OPEN_LOOP)
+    {
+        steptest_result = heater.get_state() == HEATER_FAULT ? STEPTEST_FAULT : STEPTEST_STOPPED;
+        return;
+    }
+
+    if (steptest_count >= steptest_buffer_size)
+        steptest_finish(STEPTEST_FULL);
+    else if (millis() - steptest_start_ms >= steptest_duration_ms)
+        steptest_finish(STEPTEST_DONE);
+}
+
+static bool steptest_start(String &cmd, String &response)
+{
+    String fields[3];
+    int start = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        int comma = cmd.indexOf(',', start);
+        if ((comma < 0) != (i == 2))
+        {
+            response = "expected ch,duty,seconds";
+            return false;
+        }
+        fields[i] = cmd.substring(start, comma < 0 ? cmd.length() : comma);
+        start = comma + 1;
+    }
+
+    float channel, duty, seconds;
+    if (!parseFloat(fields[0], channel) || channel < 0.0f || channel >= _heater_count || channel != (int)channel)
+    {
+        response = "invalid channel";
+        return false;
+    }
+
+    if (!parseFloat(fields[1], duty) || duty < 0.0f || duty > 1.0f)
+    {
+        response = "invalid duty 0-1";
+        return false;
+    }
+
+    if (!parseFloat(fields[2], seconds) || seconds <= 0.0f || seconds > 3600.0f)
+    {
+        response = "invalid time 0-3600s";
+        return false;
+    }
+
+    if (steptest_result == STEPTEST_RUNNING)
+    {
+        response = "test running";
+        return false;
+    }
+
+    // the fault latch is cleared by enabling the channel only
+    Heater &heater = heaters[(uint8_t)channel];
+    if (heater.get_state() == HEATER_FAULT)
+    {
+        response = "channel in fault";
+        return false;
+    }
+
+    steptest_channel = (uint8_t)channel;
+    steptest_duty = duty;
+    steptest_duration_ms = (uint32_t)(seconds * 1000.0f);
+    steptest_count = 0;
+
+    heater.open_loop_start(duty);
+    steptest_start_ms = millis();
+    steptest_start_us = micros();
+    steptest_result = STEPTEST_RUNNING;
+
+    response = "OK";
+    return true;
+}
+
+static void steptest_print_info(String &response)
+{
+    response = "state=" + String(steptest_result_names[steptest_result]);
+    response += ",samples=" + String((uint32_t)steptest_count);
+    response += ",ch=" + String(steptest_channel);
+    response += ",duty=" + String(steptest_duty, 3);
+}
+
+/**
+ * @brief writes the record, one "P:t_us,pv" line per sample.
+ *
+ * t_us is relative to the start of the test, pv in C. The control tick runs while the
+ * lines are sent and may append samples to a running test.
+ */
+static void steptest_dump(Print &port)
+{
+    // a running test keeps appending, the samples counted here are complete
+    const size_t count = steptest_count;
+    ControlUnlock unlock;
+    uint32_t t_10us = 0;
+    uint16_t last_10us = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        // unwraps the 16 bit time, samples are less than 655ms apart
+        t_10us += (uint16_t)(steptest_buffer[i].t_10us - last_10us);
+        last_10us = steptest_buffer[i].t_10us;
+        port.print("P:");
+        port.print(t_10us * 10UL);
+        port.print(',');
+        port.print(steptest_buffer[i].pv_dc / 10.0f, 1);
+        port.print(_serial_usb_terminator);
+    }
+}
+
+/**
+ * @brief open loop step test command handler.
+ *
+ * The command format is as follows:
+ * - To start a test: ch,duty,seconds
+ *   duty 0-1, the channel is left OFF at the end; a channel in FAULT is refused
+ * - To get the state: ?
+ *   state=idle|running|done|full|fault|stopped,samples=n,ch=x,duty=x
+ * - To dump the record: dump
+ *   sample lines are sent first, the response reports the state as ?
+ * - To abort a running test: stop
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool steptest_cli(String &cmd, String &response)
+{
+    if (cmd == "?")
+    {
+        steptest_print_info(response);
+        return true;
+    }
+
+    if (cmd == "stop")
+    {
+        if (steptest_result == STEPTEST_RUNNING)
+            steptest_finish(STEPTEST_STOPPED);
+        response = "OK";
+        return true;
+    }
+
+    if (cmd == "dump")
+    {
+        steptest_dump(_serial_usb);
+        steptest_print_info(response);
+        return true;
+    }
+
+    return steptest_start(cmd, response);
+}
+
+/**
+ * @brief static RAM used by the step test record.
+ */
+size_t steptest_ram_usage()
+{
+    return sizeof(steptest_buffer);
+}
@@ -0,0 +1,37 @@
+#ifndef __steptest_H__
+#define __steptest_H__
+
+#include <Arduino.h>
+
+/**
+ * @file steptest.h
+ * @brief open loop step test recorder for system identification.
+ *
+ * "s:steptest:ch,duty,seconds" drives one channel at a fixed duty (Heater OPEN_LOOP state)
+ * and records timestamp and PV of every thermocouple sample in RAM, from the control tick.
+ * The run ends after the requested time, when the buffer is full, on runaway (channel
+ * FAULT) or on "stop".
+ * The record is sent over USB with "s:steptest:dump".
+ */
+
+#ifdef JBCLONE_RTOS
+constexpr size_t steptest_buffer_size = 256; // samples, ~28s; the task stacks take the RAM, see tasks.h
+#else
+constexpr size_t steptest_buffer_size = 768; // samples, ~85s at the default sampling rate
+#endif
+
+// 4 bytes per sample, time since the start in 10us modulo 655.36ms: samples are one
+// sampling cycle apart (the zero cross watchdog stops the test long before 655ms without
+// one), the dump unwraps the time exactly and rounding does not add up
+struct StepTestSample
+{
+    uint16_t t_10us;
+    uint16_t pv_dc; // 0.1C
+};
+
+void steptest_sample(uint8_t channel, uint32_t timestamp, float pv);
+void steptest_update();
+bool steptest_cli(String &cmd, String &response);
+size_t steptest_ram_usage();
+
+#endif
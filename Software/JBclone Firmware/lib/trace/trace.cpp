@@ -0,0 +1,118 @@
+#include "trace.h"
+#include "Hardware.h"
+#include "cycle_counter.h"
+#include "control.h"
+
+static_assert((trace_buffer_size & (trace_buffer_size - 1)) == 0, "trace_buffer_size must be a power of two");
+
+static TraceEvent trace_buffer[trace_buffer_size];
+static uint32_t trace_head = 0; // total events written, next slot is trace_head % size
+static volatile bool trace_enabled = true;
+
+/**
+ * @brief appends an event to the trace ring, overwriting the oldest one.
+ *
+ * Safe to call from ISR and main loop at the same time.
+ *
+ * @param type The event type.
+ * @param channel The heater channel or event source.
+ * @param arg The event argument, see TraceEventType.
+ */
+void trace_event(TraceEventType type, uint8_t channel, uint16_t arg)
+{
+    if (!trace_enabled)
+        return;
+
+    uint32_t slot = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    TraceEvent &event = trace_buffer[slot & (trace_buffer_size - 1)];
+    event.cycles = cycle_counter_read();
+    event.type = type;
+    event.channel = channel;
+    event.arg = arg;
+}
+
+/**
+ * @brief writes the trace content, oldest event first.
+ *
+ * Every line is "T:" followed by up to 8 events as little endian hex bytes
+ * (u32 cycles, u8 type, u8 channel, u16 arg). Recording is paused while dumping, and the
+ * control tick runs meanwhile: a slow USB host does not hold the command lock.
+ *
+ * @param port The output port.
+ * @return the number of events written.
+ */
+uint32_t trace_dump(Print &port)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    ControlUnlock unlock;
+    trace_enabled = false;
+
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+    uint32_t count = head < trace_buffer_size ? head : trace_buffer_size;
+    uint32_t first = head - count;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i % 8 == 0)
+            port.print("T:");
+
+        const uint8_t *bytes = (const uint8_t *)&trace_buffer[(first + i) & (trace_buffer_size - 1)];
+        for (size_t b = 0; b < sizeof(TraceEvent); b++)
+        {
+            port.write(hex[bytes[b] >> 4]);
+            port.write(hex[bytes[b] & 0x0F]);
+        }
+
+        if (i % 8 == 7 || i == count - 1)
+            port.print(_serial_usb_terminator);
+    }
+
+    trace_enabled = true;
+    return count;
+}
+
+/**
+ * @brief trace buffer command handler.
+ *
+ * The command format is as follows:
+ * - To dump the buffer: ?
+ *   trace lines are sent first, the response reports events=count,f_cpu=hz
+ * - To clear the buffer: clear
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool trace_cli(String &cmd, String &response)
+{
+    if (cmd == "clear")
+    {
+        trace_enabled = false;
+        __atomic_store_n(&trace_head, 0, __ATOMIC_RELAXED);
+        trace_enabled = true;
+
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    uint32_t count = trace_dump(_serial_usb);
+
+    response = "events=" + String(count);
+    response += ",f_cpu=" + String((uint32_t)F_CPU);
+    return true;
+}
+
+/**
+ * @brief static RAM used by the trace ring.
+ */
+size_t trace_ram_usage()
+{
+    return sizeof(trace_buffer);
+}
@@ -0,0 +1,56 @@
+#ifndef __trace_H__
+#define __trace_H__
+
+#include <Arduino.h>
+
+/**
+ * @file trace.h
+ * @brief fixed size RAM ring of binary trace events.
+ *
+ * Events are 8 bytes, timestamped with the DWT cycle counter and written lock free
+ * from both the main loop and the zero cross ISR (each writer claims a slot with an
+ * atomic increment). The ring keeps the most recent trace_buffer_size events and is
+ * dumped over USB with "s:trace:?", use trace_to_chrome.py in the tuner folder to
+ * convert the dump to Chrome/Perfetto trace JSON.
+ */
+
+#ifdef JBCLONE_RTOS
+constexpr size_t trace_buffer_size = 128; // events, must be a power of two; the task stacks take the RAM, see tasks.h
+#else
+constexpr size_t trace_buffer_size = 256; // events, must be a power of two
+#endif
+
+enum TraceEventType : uint8_t
+{
+    TRACE_ZERO_CROSS = 1,   // arg: zero cross counter
+    TRACE_SAMPLE_SCHEDULED, // channel
+    TRACE_SAMPLE_TAKEN,     // channel, arg: raw ADC code
+    TRACE_PID_COMPUTE,      // channel, arg: output in 1/1000
+    TRACE_OUTPUT_MASK,      // arg: bit n set when channel n conducts
+    TRACE_COMMAND,          // channel: 0 usb 1 hmi, arg: message length
+    TRACE_SAVE_START,       // channel
+    TRACE_SAVE_END,         // channel, arg: 1 success 0 fail
+    TRACE_HMI_FLUSH,        // channel
+};
+
+struct TraceEvent
+{
+    uint32_t cycles;
+    uint8_t type;
+    uint8_t channel;
+    uint16_t arg;
+};
+
+void trace_event(TraceEventType type, uint8_t channel, uint16_t arg);
+uint32_t trace_dump(Print &port);
+bool trace_cli(String &cmd, String &response);
+size_t trace_ram_usage();
+
+// events are recorded only when TRACING is defined (see platformio.ini)
+#ifdef TRACING
+#define TRACE_EVENT(type, channel, arg) trace_event(type, channel, arg)
+#else
+#define TRACE_EVENT(type, channel, arg) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,230 @@
+#include "zc_timing.h"
+#include "Hardware.h"
+#include "cycle_counter.h"
+
+static ZcHistogram zc_latency;
+static ZcHistogram zc_execution;
+static ZcHistogram zc_jitter;
+static uint32_t zc_overcaptures = 0;
+static uint32_t zc_gaps = 0;
+
+static uint32_t zc_enter_cycles = 0;
+static bool zc_edge_valid = false;
+static uint16_t zc_last_edge = 0;
+static uint32_t zc_last_edge_us = 0;
+static uint32_t zc_last_period_ns = 0;
+static uint32_t zc_period_min_ns = 0; // shortest edge to edge time, 0 before the first
+
+// the 16 bit capture wraps every zc_capture_range_us, an edge to edge time close to it is
+// ambiguous; the slack covers the ISR latency spread between the two micros() readings
+constexpr uint32_t zc_capture_range_us = (uint32_t)(65536ULL * 1000000ULL / _zc_capture_timer_hz);
+constexpr uint32_t zc_capture_slack_us = 1000;
+
+static uint32_t zc_ticks_to_ns(uint32_t ticks)
+{
+    return (uint32_t)((uint64_t)ticks * 1000000000ULL / _zc_capture_timer_hz);
+}
+
+static void zc_histogram_add(ZcHistogram &histogram, uint32_t ns)
+{
+    size_t bin = 0;
+    uint32_t limit = 500;
+    while (bin < zc_histogram_bins - 1 && ns >= limit)
+    {
+        limit <<= 1;
+        bin++;
+    }
+
+    histogram.bins[bin]++;
+    if (ns > histogram.worst_ns)
+        histogram.worst_ns = ns;
+}
+
+/**
+ * @brief starts TIM1 as free running counter capturing the zero cross edges on channel 1.
+ *
+ * Must be called before the zero cross interrupt is attached.
+ */
+void zc_timing_init()
+{
+#ifdef ARDUINO_ARCH_STM32
+    RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+
+    TIM1->CR1 = 0;
+    TIM1->PSC = (F_CPU / _zc_capture_timer_hz) - 1;
+    TIM1->ARR = 0xFFFF;
+    TIM1->CCMR1 = TIM_CCMR1_CC1S_0; // IC1 mapped on TI1, no filter, no prescaler
+    TIM1->CCER = TIM_CCER_CC1E;     // rising edge
+    TIM1->EGR = TIM_EGR_UG;
+    TIM1->CR1 = TIM_CR1_CEN;
+#endif
+}
+
+/**
+ * @brief measures the latency from the captured edge to ISR entry.
+ *
+ * Also tracks the mains period jitter between consecutive captured edges. Edges further
+ * apart than the capture counter range (missed edges) count as a gap and give no period,
+ * the wrapped counter difference would look like a plausible short one.
+ */
+void zc_timing_isr_enter()
+{
+    zc_enter_cycles = cycle_counter_read();
+
+#ifdef ARDUINO_ARCH_STM32
+    uint16_t now = TIM1->CNT;
+    bool overcapture = TIM1->SR & TIM_SR_CC1OF;
+    uint16_t edge = TIM1->CCR1; // clears CC1IF
+    TIM1->SR = ~TIM_SR_CC1OF;
+#else
+    // no capture hardware, the edge is assumed to be serviced immediately
+    uint16_t now = (uint16_t)(micros() * (_zc_capture_timer_hz / 1000000));
+    bool overcapture = false;
+    uint16_t edge = now;
+#endif
+
+    // a second edge arrived before this ISR ran, latency and period are not reliable
+    if (overcapture)
+    {
+        zc_overcaptures++;
+        zc_edge_valid = false;
+        return;
+    }
+
+    zc_histogram_add(zc_latency, zc_ticks_to_ns((uint16_t)(now - edge)));
+
+    const uint32_t now_us = micros();
+    if (zc_edge_valid && now_us - zc_last_edge_us >= zc_capture_range_us - zc_capture_slack_us)
+    {
+        zc_gaps++;
+        zc_last_period_ns = 0;
+    }
+    else if (zc_edge_valid)
+    {
+        uint32_t period_ns = zc_ticks_to_ns((uint16_t)(edge - zc_last_edge));
+        if (zc_period_min_ns == 0 || period_ns < zc_period_min_ns)
+            zc_period_min_ns = period_ns;
+        if (zc_last_period_ns != 0)
+        {
+            uint32_t jitter = period_ns > zc_last_period_ns ? period_ns - zc_last_period_ns : zc_last_period_ns - period_ns;
+            zc_histogram_add(zc_jitter, jitter);
+        }
+        zc_last_period_ns = period_ns;
+    }
+
+    zc_last_edge = edge;
+    zc_last_edge_us = now_us;
+    zc_edge_valid = true;
+}
+
+/**
+ * @brief measures the ISR execution time since zc_timing_isr_enter().
+ */
+void zc_timing_isr_exit()
+{
+    uint32_t cycles = cycle_counter_read() - zc_enter_cycles;
+    zc_histogram_add(zc_execution, (uint32_t)((uint64_t)cycles * 1000000000ULL / F_CPU));
+}
+
+/**
+ * @brief worst measured execution time of the zero cross ISR.
+ */
+uint32_t zc_timing_exec_worst_ns()
+{
+    noInterrupts();
+    uint32_t worst_ns = zc_execution.worst_ns;
+    interrupts();
+    return worst_ns;
+}
+
+/**
+ * @brief shortest time between two captured zero cross edges, 0 if none was measured.
+ */
+uint32_t zc_timing_period_min_ns()
+{
+    noInterrupts();
+    uint32_t period_ns = zc_period_min_ns;
+    interrupts();
+    return period_ns;
+}
+
+static void zc_histogram_print(String &response, const char *name, const ZcHistogram &histogram)
+{
+    response += String(name) + ":worst=" + String(histogram.worst_ns) + ",bins=";
+    for (size_t i = 0; i < zc_histogram_bins; i++)
+    {
+        if (i > 0)
+            response += "/";
+        response += String(histogram.bins[i]);
+    }
+}
+
+/**
+ * @brief zero cross timing command handler.
+ *
+ * The command format is as follows:
+ * - To get the histograms: ?
+ * - To clear histograms and worst case values: clear
+ *
+ * Response: lat_ns:worst=x,bins=b0/b1/...;exec_ns:...;jitter_ns:...;overcapture=n;gap=n;period_min_ns=x
+ * bins limits are 0.5us * 2^n, see zc_timing.h; gap counts edge intervals beyond the
+ * capture range, left out of jitter and period_min
+ *
+ * @param cmd The command string.
+ * @param response The response string.
+ * @return true if the command was successful, false otherwise.
+ */
+bool zc_timing_cli(String &cmd, String &response)
+{
+    if (cmd == "clear")
+    {
+        noInterrupts();
+        memset(&zc_latency, 0, sizeof(zc_latency));
+        memset(&zc_execution, 0, sizeof(zc_execution));
+        memset(&zc_jitter, 0, sizeof(zc_jitter));
+        zc_overcaptures = 0;
+        zc_gaps = 0;
+        zc_last_period_ns = 0;
+        zc_period_min_ns = 0;
+        zc_edge_valid = false;
+        interrupts();
+
+        response = "OK";
+        return true;
+    }
+
+    if (cmd != "?")
+    {
+        response = "invalid value";
+        return false;
+    }
+
+    noInterrupts();
+    ZcHistogram latency = zc_latency;
+    ZcHistogram execution = zc_execution;
+    ZcHistogram jitter = zc_jitter;
+    uint32_t overcaptures = zc_overcaptures;
+    uint32_t gaps = zc_gaps;
+    uint32_t period_min_ns = zc_period_min_ns;
+    interrupts();
+
+    response = "";
+    zc_histogram_print(response, "lat_ns", latency);
+    response += ";";
+    zc_histogram_print(response, "exec_ns", execution);
+    response += ";";
+    zc_histogram_print(response, "jitter_ns", jitter);
+    response += ";overcapture=" + String(overcaptures);
+    response += ";gap=" + String(gaps);
+    response += ";period_min_ns=" + String(period_min_ns);
+
+    return true;
+}
+
+/**
+ * @brief static RAM used by the zero cross histograms.
+ */
+size_t zc_timing_ram_usage()
+{
+    return sizeof(zc_latency) + sizeof(zc_execution) + sizeof(zc_jitter);
+}
@@ -0,0 +1,44 @@
+#ifndef __zc_timing_H__
+#define __zc_timing_H__
+
+#include <Arduino.h>
+
+/**
+ * @file zc_timing.h
+ * @brief zero cross interrupt latency, execution time and mains period jitter monitor.
+ *
+ * The zero cross pin (PA8) is also TIM1_CH1, the timer captures every rising edge in
+ * hardware so the ISR can measure how long it waited before running.
+ * Measurements are accumulated in power of two histograms:
+ * bin 0 < 0.5us, bin n < 0.5us * 2^n, last bin collects everything above.
+ * Worst case values persist until cleared with "s:zc:clear", so does the shortest time
+ * between two captured edges, which bounds how often the ISR can preempt the control tick.
+ */
+
+constexpr size_t zc_histogram_bins = 12;
+
+struct ZcHistogram
+{
+    uint32_t bins[zc_histogram_bins];
+    uint32_t worst_ns;
+};
+
+void zc_timing_init();
+void zc_timing_isr_enter();
+void zc_timing_isr_exit();
+uint32_t zc_timing_exec_worst_ns();
+uint32_t zc_timing_period_min_ns();
+bool zc_timing_cli(String &cmd, String &response);
+size_t zc_timing_ram_usage();
+
+/**
+ * @brief RAII helper placed as first statement of the zero cross ISR.
+ */
+class ZcIsrTiming
+{
+public:
+    ZcIsrTiming() { zc_timing_isr_enter(); }
+    ~ZcIsrTiming() { zc_timing_isr_exit(); }
+};
+
+#endif
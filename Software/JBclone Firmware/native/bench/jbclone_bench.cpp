@@ -0,0 +1,462 @@
+/**
+ * @file jbclone_bench.cpp
+ * @brief micro-benchmarks of the firmware hot paths on the host.
+ *
+ * usage: jbclone_bench [options]
+ *   --filter TEXT     run only the cases whose name contains TEXT
+ *   --min_time S      minimum measuring time per repetition, default 0.1
+ *   --repeat N        repetitions per case, the median is reported, default 5
+ *   --json FILE       write the results as JSON, "-" for stdout
+ *   --compare FILE    JSON of an earlier run, prints the change per case
+ *
+ * Every case reports host ns/op and, where the kernel allows perf events, retired user
+ * space instructions per op. The instruction count is the stable number to compare
+ * between builds of the same compiler, ns/op depends on the machine.
+ * pid_compute is private to Heater; it is measured as Heater::control_update() with a PID
+ * update pending minus control_update() without one, both starting from the same snapshot.
+ * control_tick_worst is the tick on its worst path: a full batch of zero cross events and
+ * every channel sampling and computing in the same tick.
+ */
+
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "parser.h"
+#include "events.h"
+#include "sim_eeprom.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <linux/perf_event.h>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+// firmware entry points, src/main.cpp, src/control_tick.h and src/Serial_controls.h
+void setup();
+void control_tick();
+bool eval_serial_command(const String message, String &response);
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double instructions_per_op = NAN; // NAN when perf events are not available
+};
+
+// keeps a value alive without the compiler seeing through it
+template <typename T>
+static inline void keep(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief user space retired instruction counter of this thread, perf_event_open(2).
+ */
+class InstructionCounter
+{
+private:
+    int _fd = -1;
+
+public:
+    InstructionCounter()
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~InstructionCounter()
+    {
+        if (_fd >= 0)
+            close(_fd);
+    }
+
+    bool available() const { return _fd >= 0; }
+
+    void start()
+    {
+        if (_fd < 0)
+            return;
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t stop()
+    {
+        uint64_t count = 0;
+        if (_fd < 0)
+            return 0;
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(_fd, &count, sizeof(count)) != sizeof(count))
+            return 0;
+        return count;
+    }
+};
+
+static InstructionCounter instruction_counter;
+static double min_time_s = 0.1;
+static int repetitions = 5;
+
+/**
+ * @brief times body(), the iteration count grows until one repetition takes min_time_s.
+ */
+static BenchResult run_case(const std::string &name, const std::function<void()> &body)
+{
+    using clock = std::chrono::steady_clock;
+
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        auto start = clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+            body();
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        if (elapsed >= min_time_s || iterations >= (1ULL << 32))
+            break;
+        iterations = elapsed > 0.0 ? std::max(iterations * 2, (uint64_t)(iterations * 1.2 * min_time_s / elapsed))
+                                   : iterations * 10;
+    }
+
+    std::vector<double> ns, instructions;
+    for (int r = 0; r < repetitions; r++)
+    {
+        instruction_counter.start();
+        auto start = clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+            body();
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        uint64_t count = instruction_counter.stop();
+
+        ns.push_back(elapsed * 1e9 / iterations);
+        instructions.push_back((double)count / iterations);
+    }
+    std::sort(ns.begin(), ns.end());
+    std::sort(instructions.begin(), instructions.end());
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.ns_per_op = ns[ns.size() / 2];
+    if (instruction_counter.available())
+        result.instructions_per_op = instructions[instructions.size() / 2];
+    return result;
+}
+
+/**
+ * @brief station on the shim with channel 0 restored to a linear table and regulating.
+ */
+static void station_setup()
+{
+    static SimEeprom memory;
+    host_reset();
+    i2cBus.host_detach_all();
+    i2cBus.host_attach(&memory);
+    setup();
+    // the cases run the control tick themselves
+    host_timers_enable(false);
+
+    String response;
+    eval_serial_command("0:restore:21", response);
+    eval_serial_command("0:set_t:350", response);
+    Serial.host_tx();
+}
+
+static std::vector<BenchResult> run_all(const std::string &filter)
+{
+    std::vector<BenchResult> results;
+    auto add = [&](const std::string &name, const std::function<void()> &body) {
+        if (name.find(filter) == std::string::npos)
+            return;
+        results.push_back(run_case(name, body));
+        fprintf(stderr, ".");
+    };
+
+    // parser
+    const String float_text = "123.456";
+    const String float_negative = "-0.00125";
+    String bool_text = "1";
+    add("parseFloat", [&] {
+        float v;
+        keep(parseFloat(float_text, v));
+        keep(v);
+    });
+    add("parseFloat_negative", [&] {
+        float v;
+        keep(parseFloat(float_negative, v));
+        keep(v);
+    });
+    add("parseBool", [&] {
+        bool v;
+        keep(parseBool(bool_text, v));
+        keep(v);
+    });
+
+    // command dispatch, queries only: setters write the EEPROM through the shim
+    const struct
+    {
+        const char *name;
+        const char *message;
+    } commands[] = {
+        {"eval_serial_command_first", "0:en:?"},
+        {"eval_serial_command_mid", "0:pid_kp:?"},
+        {"eval_serial_command_last", "3:heater_w:?"},
+        {"eval_serial_command_station", "s:steptest:?"},
+        {"eval_serial_command_unknown", "0:bogus:1"},
+        {"eval_serial_command_malformed", "hello"},
+    };
+    for (const auto &c : commands)
+    {
+        const String message = c.message;
+        add(c.name, [&] {
+            String response;
+            keep(eval_serial_command(message, response));
+        });
+    }
+
+    // calibration table lookups, mid range
+    Heater &heater = heaters[0];
+    add("tcv_to_temp", [&] { keep(heater.tcv_to_temp(6300.0f)); });
+    add("temp_to_tcv", [&] { keep(heater.temp_to_tcv(300.0f)); });
+
+    // PID: one control_update() pass from a regulating snapshot with and without a pending compute
+    String response;
+    eval_serial_command("0:en:1", response);
+    Heater::Snapshot pending;
+    heater.snapshot_save(pending);
+    pending.state = HEATER_REGULATING;
+    pending.sample_scheduled = 0;
+    pending.pid_update_pending = 1;
+    pending.pid_TCvoltage_pv = 7245.0f;
+    pending.pv_old_timestamp = (uint32_t)host_clock_us() - 110000;
+    pending.pv_timestamp = (uint32_t)host_clock_us();
+    Heater::Snapshot idle = pending;
+    idle.pid_update_pending = 0;
+
+    const bool pid_selected = std::string("pid_compute").find(filter) != std::string::npos;
+    BenchResult with_pid, without_pid;
+    if (pid_selected || std::string("control_update").find(filter) != std::string::npos)
+    {
+        with_pid = run_case("control_update_pid", [&] {
+            heater.snapshot_load(pending);
+            heater.control_update();
+        });
+        without_pid = run_case("control_update_idle", [&] {
+            heater.snapshot_load(idle);
+            heater.control_update();
+        });
+        results.push_back(with_pid);
+        results.push_back(without_pid);
+
+        BenchResult pid;
+        pid.name = "pid_compute";
+        pid.iterations = with_pid.iterations;
+        pid.ns_per_op = with_pid.ns_per_op - without_pid.ns_per_op;
+        pid.instructions_per_op = with_pid.instructions_per_op - without_pid.instructions_per_op;
+        results.push_back(pid);
+        fprintf(stderr, "..");
+    }
+
+    // control tick worst path: every channel with a recovered sample, events queued
+    Heater::Snapshot due = pending;
+    due.pid_update_pending = 0;
+    due.sample_scheduled = 1;
+    due.sample_schedule_timestamp = (uint32_t)host_clock_us() - 2 * _tc_amp_recovery_time;
+    for (size_t ch = 1; ch < _heater_count; ch++)
+        eval_serial_command(String((int)ch) + ":en:1", response);
+    add("control_tick_worst", [&] {
+        for (size_t ch = 0; ch < _heater_count; ch++)
+            heaters[ch].snapshot_load(due);
+        for (uint32_t i = 0; i < _control_events_per_tick; i++)
+            event_push(EVENT_MAINS_EDGE, 0, 0, (uint32_t)host_clock_us());
+        control_tick();
+    });
+    for (size_t ch = 0; ch < _heater_count; ch++)
+        eval_serial_command(String((int)ch) + ":en:0", response);
+
+    // HMI command formatting, drained from the shim port every 1024 commands
+    uint32_t hmi_count = 0;
+    auto hmi_drain = [&] {
+        if (++hmi_count % 1024 == 0)
+            Serial1.host_tx();
+    };
+    const String field = "h1meas";
+    const String text = "350";
+    add("display_text", [&] {
+        _hmi.text(field, text);
+        hmi_drain();
+    });
+    add("display_value", [&] {
+        _hmi.value("h1op", 42);
+        hmi_drain();
+    });
+    add("display_color", [&] {
+        _hmi.color("h1en", 2016);
+        hmi_drain();
+    });
+    add("hmi_heater_update", [&] {
+        HMI_heater1_update(&heater);
+        hmi_drain();
+    });
+
+    fprintf(stderr, "\n");
+    return results;
+}
+
+static std::string json_number(double v, const char *format)
+{
+    if (isnan(v))
+        return "null";
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), format, v);
+    return buffer;
+}
+
+/**
+ * @brief one case per line, so the file can also be diffed and grepped.
+ */
+static void write_json(FILE *out, const std::vector<BenchResult> &results)
+{
+    fprintf(out, "{\n  \"tool\": \"jbclone_bench\",\n  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(out, "  \"instructions\": \"%s\",\n",
+            instruction_counter.available() ? "perf_user" : "unavailable");
+    fprintf(out, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %s, \"instructions_per_op\": %s}%s\n",
+                r.name.c_str(), (unsigned long long)r.iterations, json_number(r.ns_per_op, "%.3f").c_str(),
+                json_number(r.instructions_per_op, "%.1f").c_str(), i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static bool read_json(const char *path, std::map<std::string, BenchResult> &results)
+{
+    FILE *in = fopen(path, "r");
+    if (in == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), in))
+    {
+        char name[128];
+        const char *p = strstr(line, "{\"name\": \"");
+        if (p == nullptr || sscanf(p, "{\"name\": \"%127[^\"]\"", name) != 1)
+            continue;
+
+        BenchResult r;
+        r.name = name;
+        const char *ns = strstr(line, "\"ns_per_op\": ");
+        const char *ins = strstr(line, "\"instructions_per_op\": ");
+        r.ns_per_op = ns ? strtod(ns + 13, nullptr) : NAN;
+        r.instructions_per_op = ins && strncmp(ins + 23, "null", 4) != 0 ? strtod(ins + 23, nullptr) : NAN;
+        results[r.name] = r;
+    }
+    fclose(in);
+    return true;
+}
+
+static std::string change(double base, double now)
+{
+    if (isnan(base) || isnan(now) || base == 0.0)
+        return "-";
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%+.1f%%", (now / base - 1.0) * 100.0);
+    return buffer;
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter;
+    const char *json_path = nullptr;
+    const char *compare_path = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "usage: jbclone_bench [--filter TEXT] [--min_time S] [--repeat N] [--json FILE]\n"
+                            "                     [--compare FILE]\n");
+            return 2;
+        }
+        const char *value = argv[++i];
+        if (arg == "--filter")
+            filter = value;
+        else if (arg == "--min_time")
+            min_time_s = atof(value);
+        else if (arg == "--repeat")
+            repetitions = std::max(1, atoi(value));
+        else if (arg == "--json")
+            json_path = value;
+        else if (arg == "--compare")
+            compare_path = value;
+        else
+        {
+            fprintf(stderr, "invalid argument %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    std::map<std::string, BenchResult> baseline;
+    if (compare_path != nullptr && !read_json(compare_path, baseline))
+        return 1;
+
+    station_setup();
+    std::vector<BenchResult> results = run_all(filter);
+
+    // the table goes to stderr when the JSON is written to stdout
+    FILE *table = json_path != nullptr && strcmp(json_path, "-") == 0 ? stderr : stdout;
+    fprintf(table, "%-32s %12s %10s %12s", "case", "iterations", "ns/op", "instr/op");
+    if (compare_path != nullptr)
+        fprintf(table, " %10s %10s", "ns", "instr");
+    fprintf(table, "\n");
+    for (const BenchResult &r : results)
+    {
+        fprintf(table, "%-32s %12llu %10.2f %12s", r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op,
+               json_number(r.instructions_per_op, "%.1f").c_str());
+        if (compare_path != nullptr)
+        {
+            auto it = baseline.find(r.name);
+            if (it != baseline.end())
+                fprintf(table, " %10s %10s", change(it->second.ns_per_op, r.ns_per_op).c_str(),
+                       change(it->second.instructions_per_op, r.instructions_per_op).c_str());
+        }
+        fprintf(table, "\n");
+    }
+    if (!instruction_counter.available())
+        fprintf(table, "# instruction counts unavailable (perf_event_open denied)\n");
+
+    if (json_path != nullptr)
+    {
+        FILE *out = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+        if (out == nullptr)
+        {
+            perror(json_path);
+            return 1;
+        }
+        write_json(out, results);
+        if (out != stdout)
+            fclose(out);
+    }
+    return 0;
+}
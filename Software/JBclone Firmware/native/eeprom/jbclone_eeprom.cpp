@@ -0,0 +1,262 @@
+/**
+ * @file jbclone_eeprom.cpp
+ * @brief EEprom driver and channel persistence against the 24C16 model, checked and timed.
+ *
+ * usage: jbclone_eeprom [options]
+ *   --twr_us N          write cycle time of the model, default 5000 (datasheet maximum)
+ *   --clock HZ          I2C clock, default 100000
+ *   --ber X             bit error rate, per bit read and per bit programmed, default 0
+ *   --seed N            bit error seed
+ *
+ * Runs the on-target EEPROM self test (lib/EEprom/EEprom_self_test.txt), then checks the
+ * driver against the model: block addressing, page splitting, sequential reads across
+ * blocks, ACK polling through the write cycle. Every operation reports the simulated time
+ * it blocks the caller, the page writes it costs and the busy NACKs its polling saw; the
+ * channel save and load at the end are what a setting change costs the main loop.
+ * With --ber it counts the floats a read returns wrong without the driver noticing.
+ *
+ * Exits with 1 if a check failed.
+ */
+
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "sim_eeprom.h"
+
+#include "EEprom_self_test.txt"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// firmware entry points, src/main.cpp and src/Serial_controls.h
+void setup();
+void loop();
+bool eval_serial_command(const String message, String &response);
+
+static SimEeprom *memory = nullptr;
+static int failures = 0;
+
+static void check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * @brief runs an operation and prints what it cost.
+ */
+template <typename Op>
+static bool timed(const char *name, Op op)
+{
+    const uint64_t start = host_clock_us();
+    const uint32_t pages = memory->page_writes();
+    const uint32_t nacks = memory->busy_nacks();
+
+    bool ok = op();
+
+    printf("%-28s %-4s %9.3f ms %5u page writes %6u busy NACKs\n", name, ok ? "ok" : "fail",
+           (host_clock_us() - start) * 1e-3, memory->page_writes() - pages, memory->busy_nacks() - nacks);
+    return ok;
+}
+
+static void driver_checks()
+{
+    // block addressing: one byte at the same offset of every 256 byte block
+    bool ok = timed("writeByte x8 blocks", [] {
+        bool ok = true;
+        for (uint16_t block = 0; block < 8; block++)
+            ok &= eeprom.writeByte(block * 256 + 0x42, 0xA0 + block);
+        return ok;
+    });
+    for (uint16_t block = 0; block < 8; block++)
+        ok &= memory->peek(block * 256 + 0x42) == 0xA0 + block;
+    check(ok, "block addressing of writeByte");
+
+    uint8_t byte = 0;
+    ok = timed("readByte", [&] { return eeprom.readByte(7 * 256 + 0x42, byte); });
+    check(ok && byte == 0xA7, "readByte from block 7");
+
+    // 40 bytes from the middle of a page, across a block boundary: the driver has to split
+    // at the page ends or the model wraps the data inside the page
+    uint8_t pattern[64];
+    for (size_t i = 0; i < sizeof(pattern); i++)
+        pattern[i] = (uint8_t)(i * 7 + 1);
+    ok = timed("writeBytes 40 unaligned", [&] { return eeprom.writeBytes(0x1F8, pattern, 40); });
+    for (size_t i = 0; i < 40; i++)
+        ok &= memory->peek(0x1F8 + i) == pattern[i];
+    check(ok, "page split of writeBytes");
+
+    ok = timed("writeBytes 16 aligned", [&] { return eeprom.writeBytes(0x300, pattern, 16); });
+    check(ok, "aligned page write");
+
+    // sequential read across the block boundary
+    uint8_t readback[64];
+    ok = timed("readBytes 40", [&] { return eeprom.readBytes(0x1F8, readback, 40); });
+    check(ok && memcmp(readback, pattern, 40) == 0, "readBytes across blocks");
+
+    // back to back writes only work through the ACK polling of the write cycle
+    ok = timed("writeFloat", [] { return eeprom.writeFloat(0x400, 3.14159f); });
+    float value = 0.0f;
+    ok &= timed("readFloat", [&] { return eeprom.readFloat(0x400, value); });
+    check(ok && value == 3.14159f, "float round trip");
+
+    // model: an unsplit write wraps inside the page, no poll leaves the device busy
+    i2cBus.beginTransmission((uint8_t)(_address_eeprom | 0x05));
+    i2cBus.write(0x08);
+    i2cBus.write(pattern, 12);
+    check(i2cBus.endTransmission() == 0, "raw page write");
+    check(memory->peek(0x500) == pattern[8] && memory->peek(0x50F) == pattern[7], "page wrap of the model");
+    i2cBus.beginTransmission((uint8_t)_address_eeprom);
+    check(i2cBus.endTransmission() == 2, "address NACK during the write cycle");
+    delay(10);
+}
+
+#ifdef JBCLONE_CORO
+/**
+ * @brief a command on the USB port, loop() runs until the reply.
+ */
+static String usb_command_reply(const char *line)
+{
+    Serial.host_tx();
+    Serial.host_rx(std::string(line) + _serial_usb_terminator);
+
+    std::string out;
+    const uint64_t deadline_us = host_clock_us() + 2000000;
+    while (out.find(_serial_usb_terminator) == std::string::npos && host_clock_us() < deadline_us)
+    {
+        loop();
+        host_clock_advance_us(20);
+        out += Serial.host_tx();
+    }
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r'))
+        out.pop_back();
+    return String(out.c_str());
+}
+#endif
+
+static void persistence()
+{
+    String response;
+    Heater &heater = heaters[0];
+
+    // a setting change saves the whole channel
+#ifdef JBCLONE_CORO
+    // written by the storage coroutine while loop() runs, the reply follows the write
+    timed("channel save (0:pid_kp)", [&] {
+        response = usb_command_reply("0:pid_kp:20");
+        return true;
+    });
+    check(response == "OK", "channel save");
+
+    String threads;
+    eval_serial_command("s:coro:?", threads);
+    printf("coroutines: %s\n", threads.c_str());
+#else
+    timed("channel save (0:pid_kp)", [&] { return eval_serial_command("0:pid_kp:20", response); });
+    check(response == "OK", "channel save");
+#endif
+
+    Heater::Snapshot before, after;
+    heater.snapshot_save(before);
+    timed("channel init (load)", [&] {
+        heater.init(0);
+        return true;
+    });
+    heater.snapshot_save(after);
+    check(memcmp(before.tc_cal_table, after.tc_cal_table, sizeof(before.tc_cal_table)) == 0 &&
+              before.pid_kp == after.pid_kp && before.temp_sp == after.temp_sp,
+          "channel configuration round trip");
+
+    printf("most written byte: %u writes\n", memory->max_cell_writes());
+}
+
+/**
+ * @brief floats read back wrong, split into rejected by readFloat and silently accepted.
+ */
+static void bit_errors()
+{
+    const int count = 256;
+    for (int i = 0; i < count; i++)
+        eeprom.writeFloat(i * 4, 100.0f + i);
+
+    int rejected = 0, accepted_wrong = 0;
+    for (int i = 0; i < count; i++)
+    {
+        float value = 0.0f;
+        if (!eeprom.readFloat(i * 4, value))
+            rejected++;
+        else if (value != 100.0f + i)
+            accepted_wrong++;
+    }
+    printf("bit errors: %u flipped bits, %d of %d floats rejected, %d accepted with a wrong value\n",
+           memory->bit_errors(), rejected, count, accepted_wrong);
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: jbclone_eeprom [--twr_us N] [--clock HZ] [--ber X] [--seed N]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t twr_us = 5000;
+    uint32_t clock_hz = 100000;
+    double ber = 0.0;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            usage();
+        const char *value = argv[++i];
+
+        if (arg == "--twr_us")
+            twr_us = atoi(value);
+        else if (arg == "--clock")
+            clock_hz = atoi(value);
+        else if (arg == "--ber")
+            ber = atof(value);
+        else if (arg == "--seed")
+            seed = atoi(value);
+        else
+            usage();
+    }
+
+    host_reset();
+    memory = new SimEeprom(seed);
+    memory->set_write_cycle_us(twr_us);
+    i2cBus.host_detach_all();
+    i2cBus.host_attach(memory);
+    setup();
+    i2cBus.setClock(clock_hz);
+    Serial.host_tx();
+
+    String tc_uv = "21", response;
+    heaters[0].restore_default_config(tc_uv, response);
+    Serial.host_tx();
+
+    EEprom_test(Serial, eeprom);
+    std::string report = Serial.host_tx();
+    fputs(report.c_str(), stdout);
+    check(report.find("FAIL") == std::string::npos, "on-target self test");
+
+    driver_checks();
+    persistence();
+
+    if (ber > 0.0)
+    {
+        memory->set_bit_errors(ber, ber);
+        bit_errors();
+    }
+
+    printf("%d checks failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,653 @@
+/**
+ * @file jbclone_faults.cpp
+ * @brief fault injection scenarios on the simulated station, with the firmware reaction
+ * and its detection latency checked against limits.
+ *
+ * usage: jbclone_faults [--json FILE] [--list] [scenario]...
+ *
+ * Every scenario starts a fresh StationSim, brings a channel to regulation at 300C and
+ * injects one fault on the simulated hardware: ADC codes of an open or shorted thermocouple,
+ * missing zero cross edges, EEPROM NACKs or a write cycle that never ends, a stand pin stuck
+ * on the stand, garbage on the USB and HMI ports, an event queue overflow cleared by
+ * "s:events:clear", scope captures on a regulating channel, a step test on a channel in
+ * fault or while EEPROM saves block the loop. It then checks the reaction (state, fault
+ * reason, error reply, configuration untouched) and that the output stays low once the fault
+ * is detected. Latencies are in mains half cycles from the injection.
+ *
+ * Prints one line per scenario, exits with 1 if any scenario failed.
+ */
+
+#include "station_sim.h"
+#include "sim_eeprom.h"
+
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "Heater.h"
+#include "objects.h"
+#include "events.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static constexpr float fault_setpoint = 300.0f;
+static constexpr double fault_settle_s = 15.0;   // heat-up limit before the injection
+static constexpr double fault_hold_s = 1.0;      // output watched after the detection
+
+struct FaultResult
+{
+    std::string name;
+    bool passed = true;
+    double latency = -1.0; // half cycles, negative when the scenario has none
+    double limit = -1.0;
+    std::string detail;
+};
+
+/**
+ * @brief records a failed check, keeps the first reason.
+ */
+static bool check(FaultResult &result, bool condition, const std::string &reason)
+{
+    if (!condition && result.passed)
+    {
+        result.passed = false;
+        result.detail = reason;
+    }
+    return condition;
+}
+
+/**
+ * @brief runs the station in 0.1ms slices until the condition holds.
+ *
+ * @return the time it took in half cycles, negative if it did not hold within max_s.
+ */
+static double run_until(StationSim &sim, const std::function<bool()> &condition, double max_s)
+{
+    const double start = sim.time();
+    const double half_cycle_s = sim.half_cycle_us() * 1e-6;
+    while (!condition())
+    {
+        if (sim.time() - start > max_s)
+            return -1.0;
+        sim.run(0.0001);
+    }
+    return (sim.time() - start) / half_cycle_s;
+}
+
+/**
+ * @brief restored channel, default gains, regulating at the fault setpoint.
+ */
+static bool regulate(StationSim &sim, int ch, FaultResult &result)
+{
+    const std::string id = std::to_string(ch) + ":";
+    if (!check(result, sim.setup_channel(ch, 20.0f, 0.5f, 0.0f, 0.25f), "channel setup rejected") ||
+        !check(result, sim.command(id + "set_t:" + std::to_string(fault_setpoint)) == "OK", "set_t rejected") ||
+        !check(result, sim.command(id + "en:1") == "OK", "enable rejected"))
+        return false;
+
+    double t = run_until(sim, [ch] { return heaters[ch].get_state() == HEATER_REGULATING; }, fault_settle_s);
+    return check(result, t >= 0.0, "channel did not reach regulation");
+}
+
+/**
+ * @brief checks that the output does not conduct any more after a detection.
+ */
+static void check_output_low(StationSim &sim, int ch, FaultResult &result)
+{
+    const uint64_t conducting = sim.conducting_half_cycles(ch);
+    sim.run(fault_hold_s);
+    check(result, !sim.plant(ch).heater_on() && sim.conducting_half_cycles(ch) == conducting,
+          "output conducted after the detection");
+}
+
+/**
+ * @brief fault state with the expected reason, in the firmware and in the state reply.
+ */
+static void check_fault(StationSim &sim, int ch, HeaterFault reason, const char *name, FaultResult &result)
+{
+    check(result, heaters[ch].get_state() == HEATER_FAULT && heaters[ch].get_fault() == reason,
+          std::string("no ") + name + " fault");
+
+    const std::string reply = sim.command(std::to_string(ch) + ":state:?");
+    check(result, reply.compare(0, 6, "FAULT,") == 0 && reply.size() > strlen(name) &&
+                      reply.compare(reply.size() - strlen(name), std::string::npos, name) == 0,
+          "state reply \"" + reply + "\"");
+}
+
+/**
+ * @brief fixed ADC code on a regulating channel, expected to end in a fault.
+ */
+static FaultResult adc_fault(const char *name, int ch, int code, HeaterFault reason, const char *reason_name)
+{
+    FaultResult result;
+    result.name = name;
+    // detected on the next sample: one sampling cycle of _zero_cross_period + 1 half cycles
+    // and the amplifier recovery wait at most
+    result.limit = _zero_cross_period + 1 + (double)_tc_amp_recovery_time / _mains_half_cycle_us;
+
+    StationSim sim;
+    if (!regulate(sim, ch, result))
+        return result;
+
+    sim.set_adc_fault(ch, code);
+    result.latency = run_until(sim, [ch] { return heaters[ch].get_state() == HEATER_FAULT; }, 1.0);
+    if (!check(result, result.latency >= 0.0, "not detected"))
+        return result;
+
+    check_fault(sim, ch, reason, reason_name, result);
+    check_output_low(sim, ch, result);
+    return result;
+}
+
+static FaultResult tc_open_ch0() { return adc_fault("tc_open_ch0", 0, (1 << ADC_BITS) - 1, FAULT_TC_OPEN, "tc_open"); }
+static FaultResult tc_open_ch2() { return adc_fault("tc_open_ch2", 2, (1 << ADC_BITS) - 1, FAULT_TC_OPEN, "tc_open"); }
+
+// about 700C on the 200x amplifier, short of full scale
+static FaultResult tc_overrange() { return adc_fault("tc_overrange", 0, 3500, FAULT_RUNAWAY, "runaway"); }
+
+/**
+ * @brief shorted thermocouple: reads cold while the heater runs at full power.
+ */
+static FaultResult tc_short()
+{
+    FaultResult result;
+    result.name = "tc_short";
+    result.limit = (_heating_watchdog_time * 1000.0) / _mains_half_cycle_us + 2 * (_zero_cross_period + 1);
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    sim.set_adc_fault(0, 0);
+    result.latency = run_until(sim, [] { return heaters[0].get_state() == HEATER_FAULT; }, 10.0);
+    if (!check(result, result.latency >= 0.0, "not detected"))
+        return result;
+
+    check_fault(sim, 0, FAULT_NO_HEATING, "no_heating", result);
+    check_output_low(sim, 0, result);
+    return result;
+}
+
+/**
+ * @brief mains zero cross detector silent, on two enabled channels.
+ */
+static FaultResult zero_cross_missing()
+{
+    FaultResult result;
+    result.name = "zero_cross_missing";
+    result.limit = (double)_zero_cross_timeout_us / _mains_half_cycle_us + 1;
+
+    StationSim sim;
+    if (!regulate(sim, 0, result) || !regulate(sim, 1, result))
+        return result;
+
+    sim.set_zero_cross(false);
+    result.latency = run_until(sim, [] {
+        return heaters[0].get_state() == HEATER_FAULT && heaters[1].get_state() == HEATER_FAULT;
+    }, 1.0);
+    if (!check(result, result.latency >= 0.0, "not detected"))
+        return result;
+
+    check_fault(sim, 0, FAULT_ZERO_CROSS, "zero_cross", result);
+    check_fault(sim, 1, FAULT_ZERO_CROSS, "zero_cross", result);
+    check(result, !sim.plant(0).heater_on() && !sim.plant(1).heater_on(), "output left on");
+
+    // edges back: the channels stay in fault until enabled again
+    sim.set_zero_cross(true);
+    check_output_low(sim, 0, result);
+    check(result, heaters[0].get_state() == HEATER_FAULT, "fault cleared without a command");
+    check(result, sim.command("0:en:1") == "OK" &&
+                      run_until(sim, [] { return heaters[0].get_state() == HEATER_REGULATING; }, fault_settle_s) >= 0.0,
+          "channel did not recover after en:1");
+    return result;
+}
+
+/**
+ * @brief control tick held until the zero cross event queue overflows, then the overflow
+ * counters cleared long after: the edges keep coming, the channel must keep regulating.
+ */
+static FaultResult events_clear()
+{
+    FaultResult result;
+    result.name = "events_clear";
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    host_timers_enable(false);
+    sim.run(1.0);
+    host_timers_enable(true);
+    if (!check(result, event_overflows() > 0, "event queue did not overflow"))
+        return result;
+
+    sim.run(0.5);
+    check(result, heaters[0].get_state() == HEATER_REGULATING, "state reply \"" + sim.command("0:state:?") + "\" after the overflow");
+    check(result, sim.command("s:events:clear") == "OK", "s:events:clear rejected");
+    sim.run(0.5);
+    check(result, heaters[0].get_state() == HEATER_REGULATING, "state reply \"" + sim.command("0:state:?") + "\" after clear");
+    return result;
+}
+
+/**
+ * @brief scope captures on every trigger of a regulating channel: each one completes no
+ * earlier than its delay, and the samples of the channels around it stay good.
+ */
+static FaultResult scope_capture()
+{
+    FaultResult result;
+    result.name = "scope_capture";
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    static const char *const captures[] = {"0,off,512,0", "0,off,512,300", "0,zc,512,2500", "0,zc,64,5000"};
+    for (const char *capture : captures)
+    {
+        if (!check(result, sim.command(std::string("s:scope:") + capture) == "OK", std::string("arm ") + capture + " rejected"))
+            return result;
+        run_until(sim, [&] { return sim.command("s:scope:?").compare(0, 10, "state=done") == 0; }, 2.0);
+
+        const std::string info = sim.command("s:scope:?");
+        const size_t delay = info.find("post_delay_us=");
+        const size_t start = info.find("start_us=");
+        if (!check(result, info.compare(0, 10, "state=done") == 0 && delay != std::string::npos && start != std::string::npos,
+                   std::string("no capture for ") + capture + ": " + info))
+            return result;
+        check(result, atol(info.c_str() + start + 9) >= atol(info.c_str() + delay + 14), "capture before its delay: " + info);
+    }
+
+    sim.run(1.0);
+    check(result, heaters[0].get_state() == HEATER_REGULATING, "state reply \"" + sim.command("0:state:?") + "\" after the captures");
+    return result;
+}
+
+/**
+ * @brief open loop step test on a channel latched in fault: refused, the fault stays.
+ */
+static FaultResult steptest_fault()
+{
+    FaultResult result;
+    result.name = "steptest_fault";
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    sim.set_adc_fault(0, (1 << ADC_BITS) - 1);
+    if (!check(result, run_until(sim, [] { return heaters[0].get_state() == HEATER_FAULT; }, 1.0) >= 0.0, "not detected"))
+        return result;
+
+    const std::string reply = sim.command("s:steptest:0,0.5,2");
+    check(result, reply == "ERROR channel in fault", "reply \"" + reply + "\"");
+    check_fault(sim, 0, FAULT_TC_OPEN, "tc_open", result);
+    check_output_low(sim, 0, result);
+    return result;
+}
+
+/**
+ * @brief "P:t_us,pv" lines of a step test dump, the sample times.
+ */
+static std::vector<uint32_t> steptest_times(const std::string &dump)
+{
+    std::vector<uint32_t> times;
+    size_t start = 0;
+    while ((start = dump.find("P:", start)) != std::string::npos)
+    {
+        times.push_back(strtoul(dump.c_str() + start + 2, nullptr, 10));
+        start += 2;
+    }
+    return times;
+}
+
+/**
+ * @brief step test while EEPROM saves block the loop: no sample is lost.
+ *
+ * The samples are one sampling cycle (_zero_cross_period half cycles) apart, a sample
+ * missed while the loop was blocked would leave a gap of the save time.
+ */
+static FaultResult steptest_blocked_loop()
+{
+    FaultResult result;
+    result.name = "steptest_blocked_loop";
+
+    StationSim sim;
+    // en:0 leaves a fault of an earlier scenario
+    if (!check(result, sim.setup_channel(0, 20.0f, 0.5f, 0.0f, 0.25f) && sim.setup_channel(1, 20.0f, 0.5f, 0.0f, 0.25f),
+               "channel setup rejected") ||
+        !check(result, sim.command("0:en:0") == "OK", "disable rejected"))
+        return result;
+
+    const std::string start_reply = sim.command("s:steptest:0,0.3,3");
+    if (!check(result, start_reply == "OK", "step test start reply \"" + start_reply + "\""))
+        return result;
+    for (int i = 0; i < 4; i++)
+    {
+        sim.command("1:pid_kp:" + std::to_string(20 + i));
+        sim.run(0.2);
+    }
+    run_until(sim, [&] { return sim.command("s:steptest:?").compare(0, 10, "state=done") == 0; }, 5.0);
+
+    const std::vector<uint32_t> times = steptest_times(sim.command("s:steptest:dump"));
+    const double period_us = _zero_cross_period * (double)sim.half_cycle_us();
+    uint32_t gap_max = 0;
+    for (size_t i = 1; i < times.size(); i++)
+        gap_max = std::max(gap_max, times[i] - times[i - 1]);
+
+    check(result, times.size() + 2 >= 3e6 / period_us, "samples=" + std::to_string(times.size()));
+    check(result, gap_max < 1.5 * period_us, "sample gap of " + std::to_string(gap_max) + "us");
+    // times since the start, unwrapped past 655ms; the loop ends the test, late when blocked
+    check(result, !times.empty() && times.back() + 2 * period_us >= 3e6 && times.back() < 4e6,
+          "last sample at " + std::to_string(times.empty() ? 0 : times.back()) + "us");
+    return result;
+}
+
+/**
+ * @brief a setting saved while the EEPROM misbehaves: error reply, bounded stall, still
+ * regulating, and a good save once the memory is back.
+ *
+ * The latency is the time the save command blocked the loop.
+ */
+static FaultResult eeprom_fault(const char *name, SimEepromFault fault, double limit)
+{
+    FaultResult result;
+    result.name = name;
+    result.limit = limit;
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    sim.eeprom().set_fault(fault);
+    const double start = sim.time();
+    const std::string reply = sim.command("0:pid_kp:20");
+    result.latency = (sim.time() - start) / (sim.half_cycle_us() * 1e-6);
+
+    check(result, reply == "ERROR FAIL TO SAVE", "reply \"" + reply + "\"");
+    check(result, heaters[0].get_state() == HEATER_REGULATING, "channel left regulation during the save");
+
+    sim.eeprom().set_fault(SIM_EEPROM_OK);
+    check(result, sim.command("0:pid_kp:20") == "OK", "save failed with the memory back");
+    return result;
+}
+
+static FaultResult eeprom_nack() { return eeprom_fault("eeprom_nack", SIM_EEPROM_NACK, 2); }
+
+// one ACK polling timeout, 7ms
+static FaultResult eeprom_write_timeout() { return eeprom_fault("eeprom_write_timeout", SIM_EEPROM_WRITE_TIMEOUT, 2); }
+
+/**
+ * @brief stand switch stuck closed: indistinguishable from a parked tool, the channel
+ * drops to the sleep setpoint after the sleep delay and stays enabled.
+ */
+static FaultResult stand_stuck()
+{
+    FaultResult result;
+    result.name = "stand_stuck";
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    const double sleep_delay_ms = atof(sim.command("0:sleep_delay:?").c_str());
+    result.limit = sleep_delay_ms * 1000.0 / _mains_half_cycle_us + 2 * (_zero_cross_period + 1);
+
+    sim.set_stand(0, true);
+    result.latency = run_until(sim, [] { return heaters[0].get_state() == HEATER_SLEEP; }, sleep_delay_ms * 1e-3 + 5.0);
+    if (!check(result, result.latency >= 0.0, "did not go to sleep"))
+        return result;
+
+    check(result, sim.command("0:sleep_state:?") == "1", "sleep state reply");
+    sim.run(fault_hold_s);
+    check(result, heaters[0].get_state() == HEATER_SLEEP, "left sleep with the stand stuck");
+    return result;
+}
+
+/**
+ * @brief configuration part of the channel as the commands report it.
+ */
+static std::string channel_config(StationSim &sim, int ch)
+{
+    static const char *const queries[] = {"set_t", "set_min_t", "set_max_t", "runaway_t", "pid_kp", "pid_ki",
+                                          "pid_kd", "pid_d_tau", "sleep_set_t", "sleep_delay", "tc_cal_table"};
+    std::string config;
+    for (const char *query : queries)
+        config += sim.command(std::to_string(ch) + ":" + query + ":?") + "\n";
+    return config;
+}
+
+static std::string garbage_line(std::mt19937 &rng, size_t max_length)
+{
+    std::string line;
+    size_t length = 1 + rng() % max_length;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = (char)(rng() % 256);
+        line += c == '\n' ? ' ' : c;
+    }
+    return line;
+}
+
+/**
+ * @brief random bytes, broken command framing and overlong lines on the USB port: every line
+ * gets an error reply, nothing changes.
+ */
+static FaultResult usb_garbage()
+{
+    FaultResult result;
+    result.name = "usb_garbage";
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    const std::string before = channel_config(sim, 0);
+    std::mt19937 rng(69);
+    std::vector<std::string> lines = {
+        ":", "::", "0:", "0::", ":set_t:300", "9:set_t:300", "00:set_t:300", "a:set_t:300", "0:set_t:",
+        "0:set_t:3e2", "0:set_t:--300", "0:SET_T:300", "0:set_t :300", std::string("0:set_t:3\0" "00", 10),
+        "s:unknown:1", std::string(300, 'x'), "0:" + std::string(200, ':'),
+    };
+    for (int i = 0; i < 200; i++)
+        lines.push_back(garbage_line(rng, 80));
+
+    int errors = 0;
+    for (const std::string &line : lines)
+    {
+        const std::string reply = sim.command(line);
+        errors += reply.compare(0, 6, "ERROR ") == 0;
+    }
+    check(result, errors == (int)lines.size(),
+          std::to_string(lines.size() - errors) + " of " + std::to_string(lines.size()) + " lines not rejected");
+
+    // no terminator at all: evaluated after the serial timeout
+    sim.usb_write("0:set_t");
+    sim.run(_serial_usb_timeout * 2e-3);
+    check(result, sim.drain_usb().compare(0, 6, "ERROR ") == 0, "unterminated line not rejected");
+
+    check(result, channel_config(sim, 0) == before, "configuration changed");
+    check(result, heaters[0].get_state() == HEATER_REGULATING, "channel left regulation");
+    return result;
+}
+
+/**
+ * @brief random bytes and terminated frames on the HMI port: no reply path, the channel
+ * configuration and regulation must survive.
+ */
+static FaultResult hmi_garbage()
+{
+    FaultResult result;
+    result.name = "hmi_garbage";
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    const std::string before = channel_config(sim, 0);
+    std::mt19937 rng(70);
+    const std::string terminator(3, '\xFF');
+    for (int i = 0; i < 100; i++)
+    {
+        std::string frame = garbage_line(rng, 40);
+        Serial1.host_rx(i % 2 ? frame + terminator : frame);
+        sim.run(0.05);
+    }
+    Serial1.host_rx("0:set_t:" + terminator + "0:en:" + terminator + "0:" + terminator);
+    sim.run(0.1);
+
+    check(result, channel_config(sim, 0) == before, "configuration changed");
+    check(result, heaters[0].get_state() == HEATER_REGULATING, "channel left regulation");
+    return result;
+}
+
+/**
+ * @brief no fault at all: a regulating channel must not trip any detection.
+ */
+static FaultResult baseline()
+{
+    FaultResult result;
+    result.name = "baseline";
+
+    StationSim sim;
+    if (!regulate(sim, 0, result))
+        return result;
+
+    sim.command("0:pid_kp:20");
+    sim.set_stand(0, true);
+    sim.run(2.0);
+    sim.set_stand(0, false);
+    sim.run(10.0);
+    check(result, heaters[0].get_state() == HEATER_REGULATING, "state " + std::to_string(heaters[0].get_state()));
+    return result;
+}
+
+struct FaultScenario
+{
+    const char *name;
+    FaultResult (*run)();
+};
+
+static const FaultScenario scenarios[] = {
+    {"baseline", &baseline},
+    {"tc_open_ch0", &tc_open_ch0},
+    {"tc_open_ch2", &tc_open_ch2},
+    {"tc_overrange", &tc_overrange},
+    {"tc_short", &tc_short},
+    {"zero_cross_missing", &zero_cross_missing},
+    {"eeprom_nack", &eeprom_nack},
+    {"eeprom_write_timeout", &eeprom_write_timeout},
+    {"stand_stuck", &stand_stuck},
+    {"usb_garbage", &usb_garbage},
+    {"hmi_garbage", &hmi_garbage},
+    {"events_clear", &events_clear},
+    {"scope_capture", &scope_capture},
+    {"steptest_fault", &steptest_fault},
+    {"steptest_blocked_loop", &steptest_blocked_loop},
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: jbclone_faults [--json FILE] [--list] [scenario]...\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_path = nullptr;
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc)
+            json_path = argv[++i];
+        else if (arg == "--list")
+        {
+            for (const FaultScenario &s : scenarios)
+                printf("%s\n", s.name);
+            return 0;
+        }
+        else if (arg[0] == '-')
+            usage();
+        else
+            selected.push_back(arg);
+    }
+
+    for (const std::string &name : selected)
+    {
+        bool known = false;
+        for (const FaultScenario &s : scenarios)
+            known |= name == s.name;
+        if (!known)
+        {
+            fprintf(stderr, "unknown scenario %s, see --list\n", name.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<FaultResult> results;
+    for (const FaultScenario &s : scenarios)
+    {
+        bool wanted = selected.empty();
+        for (const std::string &name : selected)
+            wanted |= name == s.name;
+        if (!wanted)
+            continue;
+
+        FaultResult r = s.run();
+        if (r.latency >= 0.0 && r.limit >= 0.0)
+            check(r, r.latency <= r.limit, "latency above the limit");
+        results.push_back(r);
+
+        printf("%-22s %s", r.name.c_str(), r.passed ? "PASS" : "FAIL");
+        if (r.latency >= 0.0)
+            printf("  latency=%.1f", r.latency);
+        if (r.limit >= 0.0)
+            printf(" limit=%.1f", r.limit);
+        if (!r.detail.empty())
+            printf("  (%s)", r.detail.c_str());
+        printf("\n");
+    }
+
+    int failed = 0;
+    for (const FaultResult &r : results)
+        failed += !r.passed;
+
+    if (json_path != nullptr)
+    {
+        FILE *f = fopen(json_path, "w");
+        if (f == nullptr)
+        {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            return 2;
+        }
+        fprintf(f, "{\"half_cycle_us\": %u, \"scenarios\": [\n", (unsigned)_mains_half_cycle_us);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const FaultResult &r = results[i];
+            fprintf(f, "  {\"name\": \"%s\", \"passed\": %s, \"latency_half_cycles\": ", r.name.c_str(),
+                    r.passed ? "true" : "false");
+            if (r.latency >= 0.0)
+                fprintf(f, "%.1f", r.latency);
+            else
+                fprintf(f, "null");
+            fprintf(f, ", \"limit_half_cycles\": ");
+            if (r.limit >= 0.0)
+                fprintf(f, "%.1f", r.limit);
+            else
+                fprintf(f, "null");
+            fprintf(f, "}%s\n", i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "]}\n");
+        fclose(f);
+    }
+
+    printf("%zu scenarios, %d failed\n", results.size(), failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file fuzz_commands.cpp
+ * @brief fuzz target of the command interface: eval_serial_command, parseFloat, parseBool
+ * and the Heater command handlers behind them (tc_cal_table, setpoints, limits, gains).
+ *
+ * An input is a text of commands, one per line, as they arrive from the USB port or the HMI.
+ * Every input starts from the same station: four restored channels regulating at 300C,
+ * blank EEPROM, clocks at zero. After each command the invariants below are checked and
+ * a violation aborts, so libFuzzer, AFL and the standalone driver all report it as a crash.
+ * After the last command the station runs a few mains half cycles with an ADC code taken
+ * from the input, to check the PID output with the configuration the commands left.
+ *
+ * Invariants:
+ * - parseFloat accepts [+-]digits[.digits] with 1..10 digits per side and at least one
+ *   digit, the result is finite and matches strtod; parseBool accepts exactly "0" and "1"
+ * - a rejected command has a reason in the response and leaves the configuration untouched
+ * - an accepted tc_cal_table set changes exactly the addressed row
+ * - 0 <= temp_sp_min <= temp_sp_max, and the temperature setpoint lies inside them unless
+ *   it was last given in uV (set_uv, the raw setpoint used while calibrating)
+ * - PID gains are finite and not negative, the PID output is finite and inside 0..1,
+ *   the heater state is one of HeaterState
+ */
+
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "Heater.h"
+#include "objects.h"
+#include "parser.h"
+#include "sim_eeprom.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// firmware entry points, src/main.cpp and src/Serial_controls.h
+void setup();
+void loop();
+bool eval_serial_command(const String message, String &response);
+
+// bounds that keep one input in the millisecond range
+static constexpr size_t _fuzz_max_commands = 64;
+static constexpr size_t _fuzz_max_line = 128;
+static constexpr int _fuzz_half_cycles = 12;
+static constexpr int _fuzz_channels = sizeof(heaters) / sizeof(heaters[0]);
+
+static SimEeprom *memory = nullptr;
+static Heater::Snapshot initial[_fuzz_channels];
+static bool raw_setpoint[_fuzz_channels];
+
+#define FUZZ_CHECK(cond, ...)                                             \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "invariant failed: %s\n  ", #cond);           \
+            fprintf(stderr, __VA_ARGS__);                                 \
+            fprintf(stderr, "\n");                                        \
+            abort();                                                      \
+        }                                                                 \
+    } while (0)
+
+/**
+ * @brief configuration part of a heater snapshot, what a command is allowed to change.
+ */
+struct HeaterConfig
+{
+    float temp_sp_min;
+    float temp_sp_max;
+    float temp_runaway_threshold;
+    float temp_sp;
+    float tc_cal_table[10][2];
+    float pid_kp;
+    float pid_ki;
+    float pid_kd;
+    float pid_derivative_filter_tau;
+    float pid_TCvoltage_sp;
+    float sleep_delay;
+    float sleep_TCvoltage_set;
+};
+
+static HeaterConfig config_of(Heater &heater)
+{
+    Heater::Snapshot s;
+    heater.snapshot_save(s);
+
+    HeaterConfig c;
+    c.temp_sp_min = s.temp_sp_min;
+    c.temp_sp_max = s.temp_sp_max;
+    c.temp_runaway_threshold = s.temp_runaway_threshold;
+    c.temp_sp = s.temp_sp;
+    memcpy(c.tc_cal_table, s.tc_cal_table, sizeof(c.tc_cal_table));
+    c.pid_kp = s.pid_kp;
+    c.pid_ki = s.pid_ki;
+    c.pid_kd = s.pid_kd;
+    c.pid_derivative_filter_tau = s.pid_derivative_filter_tau;
+    c.pid_TCvoltage_sp = s.pid_TCvoltage_sp;
+    c.sleep_delay = s.sleep_delay;
+    c.sleep_TCvoltage_set = s.sleep_TCvoltage_set;
+    return c;
+}
+
+// bitwise, NAN == NAN
+static bool config_equal(const HeaterConfig &a, const HeaterConfig &b)
+{
+    return memcmp(&a, &b, sizeof(HeaterConfig)) == 0;
+}
+
+/**
+ * @brief reference grammar of parseFloat.
+ */
+static bool float_grammar(const char *s)
+{
+    if (*s == '+' || *s == '-')
+        s++;
+
+    int before = 0, after = 0;
+    while (isdigit((unsigned char)*s))
+        before++, s++;
+    if (*s == '.')
+    {
+        s++;
+        while (isdigit((unsigned char)*s))
+            after++, s++;
+    }
+    return *s == '\0' && before + after > 0 && before <= 10 && after <= 10;
+}
+
+static void check_parsers(const String &value)
+{
+    float f = 12345.0f;
+    bool accepted = parseFloat(value, f);
+    bool expected = float_grammar(value.c_str());
+    FUZZ_CHECK(accepted == expected, "parseFloat(\"%s\") returned %d", value.c_str(), accepted);
+    if (accepted)
+    {
+        // the firmware accumulates in float, 10 digits are well past its precision
+        double reference = strtod(value.c_str(), nullptr);
+        FUZZ_CHECK(isfinite(f) && fabs(f - reference) <= 1e-5 * fabs(reference) + 1e-6,
+                   "parseFloat(\"%s\") = %.9g, strtod = %.9g", value.c_str(), f, reference);
+    }
+
+    String copy = value;
+    bool b = false;
+    bool bool_accepted = parseBool(copy, b);
+    FUZZ_CHECK(bool_accepted == (value == "0" || value == "1"), "parseBool(\"%s\") returned %d", value.c_str(), bool_accepted);
+    FUZZ_CHECK(!bool_accepted || b == (value == "1"), "parseBool(\"%s\") = %d", value.c_str(), b);
+    FUZZ_CHECK(copy == value, "parseBool modified its input");
+}
+
+static void check_heater(int ch)
+{
+    Heater::Snapshot s;
+    heaters[ch].snapshot_save(s);
+
+    FUZZ_CHECK(s.temp_sp_min >= 0.0f && s.temp_sp_min <= s.temp_sp_max,
+               "ch%d setpoint range %g..%g", ch, s.temp_sp_min, s.temp_sp_max);
+    FUZZ_CHECK(raw_setpoint[ch] || (s.temp_sp >= s.temp_sp_min && s.temp_sp <= s.temp_sp_max),
+               "ch%d setpoint %g outside %g..%g", ch, s.temp_sp, s.temp_sp_min, s.temp_sp_max);
+    FUZZ_CHECK(isfinite(s.pid_kp) && isfinite(s.pid_ki) && isfinite(s.pid_kd) &&
+                   s.pid_kp >= 0.0f && s.pid_ki >= 0.0f && s.pid_kd >= 0.0f,
+               "ch%d gains kp=%g ki=%g kd=%g", ch, s.pid_kp, s.pid_ki, s.pid_kd);
+    FUZZ_CHECK(isfinite(s.pid_output) && s.pid_output >= 0.0f && s.pid_output <= 1.0f,
+               "ch%d pid output %g", ch, s.pid_output);
+    FUZZ_CHECK(s.state <= HEATER_OPEN_LOOP, "ch%d state %d", ch, s.state);
+}
+
+/**
+ * @brief heater channel a command line addresses, -1 for station commands and garbage.
+ */
+static int command_channel(const String &line)
+{
+    if (line.length() < 2 || line[1] != ':' || !isdigit((unsigned char)line[0]))
+        return -1;
+    int ch = line[0] - '0';
+    return ch < _fuzz_channels ? ch : -1;
+}
+
+static void run_command(const String &line)
+{
+    int c1 = line.indexOf(':');
+    int c2 = line.indexOf(':', c1 + 1);
+    String command = c1 >= 0 && c2 >= 0 ? line.substring(c1 + 1, c2) : String();
+    String value = c2 >= 0 ? line.substring(c2 + 1) : line;
+
+    check_parsers(value);
+
+    int ch = command_channel(line);
+    HeaterConfig before{};
+    if (ch >= 0)
+        before = config_of(heaters[ch]);
+
+    String response;
+    bool accepted = eval_serial_command(line, response);
+
+    FUZZ_CHECK(accepted || response.length() > 0, "\"%s\" rejected without a reason", line.c_str());
+
+    if (ch >= 0)
+    {
+        HeaterConfig after = config_of(heaters[ch]);
+
+        FUZZ_CHECK(accepted || config_equal(before, after),
+                   "\"%s\" rejected (%s) but changed the configuration", line.c_str(), response.c_str());
+
+        if (accepted && command == "tc_cal_table" && value.indexOf('[') >= 0)
+        {
+            int changed = 0;
+            for (int i = 0; i < 10; i++)
+                changed += memcmp(before.tc_cal_table[i], after.tc_cal_table[i], sizeof(before.tc_cal_table[i])) != 0;
+            FUZZ_CHECK(changed <= 1, "\"%s\" changed %d calibration rows", line.c_str(), changed);
+        }
+
+        if (accepted && command == "set_uv" && value != "?")
+            raw_setpoint[ch] = true;
+        if (accepted && (command == "set_t" || command == "restore") && value != "?")
+            raw_setpoint[ch] = false;
+    }
+
+    for (int i = 0; i < _fuzz_channels; i++)
+        check_heater(i);
+}
+
+/**
+ * @brief mains half cycles with a constant ADC code, zero cross, samples, PID updates.
+ */
+static void run_control(int adc_code)
+{
+    host_on_analog_read([adc_code](uint32_t pin) {
+        (void)pin;
+        return adc_code;
+    });
+
+    for (int cycle = 0; cycle < _fuzz_half_cycles; cycle++)
+    {
+        host_trigger_interrupt(_pin_zero_cross);
+        for (int i = 0; i < 40; i++)
+        {
+            host_clock_advance_us(250);
+            loop();
+        }
+        for (int ch = 0; ch < _fuzz_channels; ch++)
+            check_heater(ch);
+    }
+}
+
+/**
+ * @brief power on, default configuration and setpoint on every channel, kept as snapshots.
+ */
+static void station_init()
+{
+    memory = new SimEeprom();
+    host_reset();
+    i2cBus.host_detach_all();
+    i2cBus.host_attach(memory);
+    setup();
+
+    String response;
+    for (int ch = 0; ch < _fuzz_channels; ch++)
+    {
+        String id(ch);
+        eval_serial_command(id + ":restore:21", response);
+        eval_serial_command(id + ":set_t:300", response);
+        eval_serial_command(id + ":pid_kp:20", response);
+        eval_serial_command(id + ":pid_ki:0.5", response);
+        heaters[ch].snapshot_save(initial[ch]);
+    }
+}
+
+/**
+ * @brief back to the state after station_init, station diagnostics stopped and cleared.
+ */
+static void station_reset()
+{
+    delete memory;
+    memory = new SimEeprom();
+    host_reset();
+    i2cBus.host_detach_all();
+    i2cBus.host_attach(memory);
+    setup();
+
+    static const char *const station_reset_commands[] = {
+        "s:record:stop", "s:steptest:stop", "s:scope:cancel", "s:trace:clear",
+        "s:health:clear", "s:zc:clear",
+    };
+    String response;
+    for (const char *command : station_reset_commands)
+        eval_serial_command(command, response);
+
+    for (int ch = 0; ch < _fuzz_channels; ch++)
+    {
+        heaters[ch].snapshot_load(initial[ch]);
+        raw_setpoint[ch] = false;
+    }
+
+    Serial.host_tx();
+    Serial1.host_tx();
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    station_init();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    station_reset();
+
+    // mixes every byte, the ADC code of the control pass
+    uint32_t hash = 2166136261u;
+
+    size_t commands = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= size && commands < _fuzz_max_commands; i++)
+    {
+        if (i < size)
+            hash = (hash ^ data[i]) * 16777619u;
+        if (i < size && data[i] != '\n')
+            continue;
+
+        size_t length = i - start;
+        if (length > _fuzz_max_line)
+            length = _fuzz_max_line;
+        // as readStringUntil hands it over, embedded NULs included
+        String line(std::string((const char *)data + start, length));
+        start = i + 1;
+
+        if (line.length() == 0)
+            continue;
+        run_command(line);
+        commands++;
+    }
+
+    run_control(hash % (1 << ADC_BITS));
+
+    Serial.host_tx();
+    Serial1.host_tx();
+    return 0;
+}
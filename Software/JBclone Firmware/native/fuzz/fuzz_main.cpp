@@ -0,0 +1,382 @@
+/**
+ * @file fuzz_main.cpp
+ * @brief standalone driver of the fuzz targets, for compilers without libFuzzer.
+ *
+ * usage: jbclone_fuzz [options] [FILE|DIR]...
+ *   -runs=N           mutate the loaded inputs N times, 0 (default) only runs them once
+ *   -seed=N           random seed, default from the clock
+ *   -dict=FILE        libFuzzer/AFL dictionary, "name"="token" or "token" per line
+ *   -max_len=N        maximum input length, default 1024
+ *   -artifact_prefix=P  crashing input written to P<hash>, default "crash-"
+ *   -corpus_out=DIR   inputs that reached new coverage are written there
+ *
+ * Without -runs every FILE and every file in DIR is executed once, which replays a corpus
+ * or a crash under the sanitizers. The same binary accepts a single file from AFL
+ * (afl-fuzz ... -- jbclone_fuzz @@). With -runs the driver fuzzes on its own: byte and
+ * token mutations, splices between inputs. When the firmware is compiled with
+ * -fsanitize-coverage=trace-pc (JBCLONE_FUZZ=ON with GCC) the callbacks below keep an
+ * edge map and inputs reaching new edges join the corpus, otherwise mutations are blind.
+ */
+
+#include <algorithm>
+#include <dirent.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+extern "C" void __sanitizer_set_death_callback(void (*callback)(void)) __attribute__((weak));
+
+// edge coverage, AFL style hashed (previous pc, pc) pairs
+static constexpr size_t _coverage_map_size = 1 << 16;
+static uint8_t coverage_map[_coverage_map_size];
+static uint8_t coverage_seen[_coverage_map_size];
+static uintptr_t coverage_previous = 0;
+static bool coverage_active = false;
+
+extern "C" void __sanitizer_cov_trace_pc()
+{
+    uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+    pc = (pc >> 4) ^ (pc << 8);
+    coverage_map[(pc ^ coverage_previous) & (_coverage_map_size - 1)] = 1;
+    coverage_previous = pc >> 1;
+    coverage_active = true;
+}
+
+// input being executed, written out from the crash handlers
+static const std::string *current_input = nullptr;
+static std::string artifact_prefix = "crash-";
+
+static uint64_t fnv1a(const std::string &data)
+{
+    uint64_t hash = 1469598103934665603ull;
+    for (unsigned char c : data)
+        hash = (hash ^ c) * 1099511628211ull;
+    return hash;
+}
+
+static void write_file(const std::string &path, const std::string &data)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == nullptr)
+        return;
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static void save_crash()
+{
+    if (current_input == nullptr)
+        return;
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)fnv1a(*current_input));
+    std::string path = artifact_prefix + name;
+    write_file(path, *current_input);
+    fprintf(stderr, "crashing input written to %s\n", path.c_str());
+    current_input = nullptr;
+}
+
+static void crash_signal(int sig)
+{
+    save_crash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static bool read_file(const std::string &path, std::string &data)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+    data.clear();
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        data.append(buffer, n);
+    fclose(f);
+    return true;
+}
+
+static void load_inputs(const std::string &path, std::vector<std::string> &inputs)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        exit(1);
+    }
+
+    if (!S_ISDIR(st.st_mode))
+    {
+        std::string data;
+        if (read_file(path, data))
+            inputs.push_back(data);
+        return;
+    }
+
+    DIR *dir = opendir(path.c_str());
+    std::vector<std::string> names;
+    while (dirent *entry = readdir(dir))
+    {
+        if (entry->d_name[0] != '.')
+            names.push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    for (const std::string &name : names)
+    {
+        std::string data;
+        if (read_file(path + "/" + name, data))
+            inputs.push_back(data);
+    }
+}
+
+/**
+ * @brief dictionary entries, "token" or name="token" with \\, \" and \xNN escapes.
+ */
+static void load_dictionary(const std::string &path, std::vector<std::string> &tokens)
+{
+    std::string text;
+    if (!read_file(path, text))
+    {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        exit(1);
+    }
+
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos)
+            end = text.size();
+        std::string line = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t open = line.find('"');
+        size_t close = line.rfind('"');
+        if (line.empty() || line[0] == '#' || open == std::string::npos || close <= open)
+            continue;
+
+        std::string token;
+        for (size_t i = open + 1; i < close; i++)
+        {
+            if (line[i] == '\\' && i + 1 < close)
+            {
+                i++;
+                if (line[i] == 'x' && i + 2 < close)
+                {
+                    token += (char)strtol(line.substr(i + 1, 2).c_str(), nullptr, 16);
+                    i += 2;
+                    continue;
+                }
+            }
+            token += line[i];
+        }
+        tokens.push_back(token);
+    }
+}
+
+static uint64_t rng_state;
+
+static uint32_t rng()
+{
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 2685821657736338717ull) >> 32);
+}
+
+static size_t rng_below(size_t n)
+{
+    return n ? rng() % n : 0;
+}
+
+static void mutate(std::string &data, const std::vector<std::string> &inputs,
+                   const std::vector<std::string> &tokens, size_t max_len)
+{
+    static const char *const interesting[] = {
+        "0", "1", "-1", "?", ".", "-", "+", "", "9999999999", "0.0000000001", "1e3",
+        "-0", "65535", "4294967296", "[", "]", ",", ":", "\n", "nan", "inf",
+    };
+
+    int count = 1 + rng_below(4);
+    for (int m = 0; m < count; m++)
+    {
+        size_t pos = rng_below(data.size() + 1);
+        switch (rng_below(8))
+        {
+        case 0: // bit flip
+            if (!data.empty())
+                data[rng_below(data.size())] ^= (char)(1 << rng_below(8));
+            break;
+        case 1: // random byte
+            if (!data.empty())
+                data[rng_below(data.size())] = (char)rng();
+            break;
+        case 2: // insert a byte
+            data.insert(pos, 1, (char)(rng_below(3) ? 32 + rng_below(95) : rng()));
+            break;
+        case 3: // erase a range
+            if (!data.empty())
+                data.erase(rng_below(data.size()), 1 + rng_below(8));
+            break;
+        case 4: // duplicate a range
+            if (!data.empty())
+            {
+                size_t from = rng_below(data.size());
+                data.insert(pos, data.substr(from, 1 + rng_below(16)));
+            }
+            break;
+        case 5: // dictionary token
+            if (!tokens.empty())
+                data.insert(pos, tokens[rng_below(tokens.size())]);
+            break;
+        case 6: // interesting value
+            data.insert(pos, interesting[rng_below(sizeof(interesting) / sizeof(interesting[0]))]);
+            break;
+        case 7: // splice with another input
+            if (!inputs.empty())
+            {
+                const std::string &other = inputs[rng_below(inputs.size())];
+                size_t from = rng_below(other.size() + 1);
+                data = data.substr(0, pos) + other.substr(from);
+            }
+            break;
+        }
+    }
+
+    if (data.size() > max_len)
+        data.resize(max_len);
+}
+
+/**
+ * @brief runs one input, true when it reached edges no earlier input did.
+ */
+static bool execute(const std::string &data)
+{
+    memset(coverage_map, 0, sizeof(coverage_map));
+    coverage_previous = 0;
+
+    current_input = &data;
+    LLVMFuzzerTestOneInput((const uint8_t *)data.data(), data.size());
+    current_input = nullptr;
+
+    bool new_edges = false;
+    for (size_t i = 0; i < _coverage_map_size; i++)
+    {
+        if (coverage_map[i] && !coverage_seen[i])
+        {
+            coverage_seen[i] = 1;
+            new_edges = true;
+        }
+    }
+    return new_edges;
+}
+
+static size_t edges()
+{
+    size_t n = 0;
+    for (uint8_t seen : coverage_seen)
+        n += seen;
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t runs = 0;
+    uint64_t seed = (uint64_t)time(nullptr);
+    size_t max_len = 1024;
+    std::string corpus_out;
+    std::vector<std::string> tokens;
+    std::vector<std::string> inputs;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("-runs=", 0) == 0)
+            runs = strtoull(arg.c_str() + 6, nullptr, 10);
+        else if (arg.rfind("-seed=", 0) == 0)
+            seed = strtoull(arg.c_str() + 6, nullptr, 10);
+        else if (arg.rfind("-dict=", 0) == 0)
+            load_dictionary(arg.substr(6), tokens);
+        else if (arg.rfind("-max_len=", 0) == 0)
+            max_len = strtoul(arg.c_str() + 9, nullptr, 10);
+        else if (arg.rfind("-artifact_prefix=", 0) == 0)
+            artifact_prefix = arg.substr(17);
+        else if (arg.rfind("-corpus_out=", 0) == 0)
+            corpus_out = arg.substr(12);
+        else if (arg[0] == '-')
+        {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return 2;
+        }
+        else
+            paths.push_back(arg);
+    }
+
+    signal(SIGABRT, crash_signal);
+    signal(SIGSEGV, crash_signal);
+    signal(SIGFPE, crash_signal);
+    signal(SIGILL, crash_signal);
+    if (__sanitizer_set_death_callback)
+        __sanitizer_set_death_callback(save_crash);
+
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    for (const std::string &path : paths)
+        load_inputs(path, inputs);
+    if (inputs.empty())
+        inputs.push_back(std::string());
+
+    // every loaded input once, their coverage is the starting point
+    for (const std::string &input : inputs)
+        execute(input);
+    printf("executed %zu inputs, %zu edges%s\n", inputs.size(), edges(),
+           coverage_active ? "" : " (no coverage instrumentation)");
+
+    if (runs == 0)
+        return 0;
+
+    rng_state = seed * 2654435761ull + 1;
+    printf("fuzzing %llu runs, seed %llu\n", (unsigned long long)runs, (unsigned long long)seed);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t run = 1; run <= runs; run++)
+    {
+        std::string data = inputs[rng_below(inputs.size())];
+        mutate(data, inputs, tokens, max_len);
+
+        if (execute(data))
+        {
+            inputs.push_back(data);
+            if (!corpus_out.empty())
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "/%016llx", (unsigned long long)fnv1a(data));
+                write_file(corpus_out + name, data);
+            }
+        }
+
+        if ((run & (run - 1)) == 0 || run == runs)
+        {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+            printf("#%llu corpus %zu edges %zu exec/s %.0f\n", (unsigned long long)run, inputs.size(),
+                   edges(), elapsed > 0 ? run / elapsed : 0.0);
+        }
+    }
+    return 0;
+}
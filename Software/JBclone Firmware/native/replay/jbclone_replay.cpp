@@ -0,0 +1,450 @@
+/**
+ * @file jbclone_replay.cpp
+ * @brief replays a station recording through the firmware and checks the outputs bit for bit.
+ *
+ * usage: jbclone_replay [--verbose] FILE
+ *   FILE       USB capture containing a "s:record" recording (other lines are ignored),
+ *              "-" reads stdin
+ *   --verbose  list every mismatching event instead of the first per stream
+ *
+ * The heaters are restored from the recorded snapshots, the zero cross phase and the clock
+ * are set to the recording start. Inputs are then applied at their recorded time:
+ * zero crosses fire zero_cross_isr(), ADC codes and stand levels are served to a heater
+ * control_update() and update() pass, commands go to eval_serial_command(). The control
+ * timer does not run, the replay makes its ticks: between inputs the heaters are updated
+ * every millisecond (timers, sleep delay), except a channel waiting for its recorded sample
+ * after the amplifier recovery time.
+ *
+ * The firmware records the replay with the same recorder; every (type, channel) event
+ * stream must match the recording exactly, state transitions by state only.
+ * Exit code 0 when identical, 1 on mismatch, 2 on unusable input.
+ */
+
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "recorder.h"
+#include "steptest.h"
+#include "sim_eeprom.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// firmware entry points, src/main.cpp and src/zero_cross.h
+void setup();
+void zero_cross_events();
+void zero_cross_watchdog();
+bool eval_serial_command(const String message, String &response);
+
+constexpr size_t replay_channels = sizeof(heaters) / sizeof(heaters[0]);
+
+struct Recording
+{
+    bool header = false;
+    uint32_t start_ms = 0;
+    uint32_t start_us = 0;
+    int zero_cross_counter = 0;
+    std::vector<std::string> snapshots; // hex, per channel
+    std::vector<RecordEvent> events;
+    struct Command
+    {
+        uint32_t t_us;
+        int source;
+        std::string text;
+    };
+    std::vector<Command> commands;
+    bool ended = false;
+    uint32_t dropped = 0;
+};
+
+// one input applied by the replay, in time order
+struct ReplayInput
+{
+    uint32_t rel_us; // since the recording start
+    const RecordEvent *event;
+    const Recording::Command *command;
+};
+
+static bool hex_decode(const std::string &hex, std::vector<uint8_t> &bytes)
+{
+    if (hex.size() % 2)
+        return false;
+    bytes.clear();
+    for (size_t i = 0; i < hex.size(); i += 2)
+    {
+        char pair[3] = {hex[i], hex[i + 1], 0};
+        char *end;
+        bytes.push_back((uint8_t)strtoul(pair, &end, 16));
+        if (*end != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief parses the recording lines, the first recording in the capture is used.
+ */
+static bool parse_recording(std::istream &in, Recording &rec)
+{
+    std::string line;
+    std::vector<uint8_t> bytes;
+    while (std::getline(in, line))
+    {
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+            line.pop_back();
+
+        if (line.compare(0, 3, "RH:") == 0)
+        {
+            if (rec.header)
+                break;
+            int version, channels;
+            if (sscanf(line.c_str() + 3, "%d,%u,%u,%d,%d", &version, &rec.start_ms, &rec.start_us,
+                       &rec.zero_cross_counter, &channels) != 5)
+                return false;
+            if (version != record_format_version || channels != (int)replay_channels)
+            {
+                fprintf(stderr, "recording version %d with %d channels, expected %d with %d\n", version, channels,
+                        record_format_version, (int)replay_channels);
+                return false;
+            }
+            rec.header = true;
+            rec.snapshots.assign(replay_channels, "");
+        }
+        else if (!rec.header)
+            continue;
+        else if (line.compare(0, 3, "RS:") == 0)
+        {
+            size_t comma = line.find(',');
+            unsigned ch = atoi(line.c_str() + 3);
+            if (comma == std::string::npos || ch >= replay_channels)
+                return false;
+            rec.snapshots[ch] = line.substr(comma + 1);
+        }
+        else if (line.compare(0, 2, "R:") == 0)
+        {
+            if (!hex_decode(line.substr(2), bytes) || bytes.size() % sizeof(RecordEvent))
+                return false;
+            for (size_t i = 0; i < bytes.size(); i += sizeof(RecordEvent))
+            {
+                RecordEvent event;
+                memcpy(&event, &bytes[i], sizeof(event));
+                rec.events.push_back(event);
+            }
+        }
+        else if (line.compare(0, 3, "RC:") == 0)
+        {
+            size_t c1 = line.find(',', 3);
+            size_t c2 = c1 == std::string::npos ? c1 : line.find(',', c1 + 1);
+            if (c2 == std::string::npos)
+                return false;
+            rec.commands.push_back({(uint32_t)strtoul(line.c_str() + 3, nullptr, 10), atoi(line.c_str() + c1 + 1),
+                                    line.substr(c2 + 1)});
+        }
+        else if (line.compare(0, 3, "RE:") == 0)
+        {
+            const char *dropped = strstr(line.c_str(), "dropped=");
+            rec.dropped = dropped ? strtoul(dropped + 8, nullptr, 10) : 0;
+            rec.ended = true;
+            break;
+        }
+    }
+    return rec.header;
+}
+
+/**
+ * @brief collects the R:/RS:/RH: lines the firmware wrote since the last call.
+ */
+static void drain_station(Recording &replayed)
+{
+    std::string out = Serial.host_tx();
+    size_t start = 0;
+    while (start < out.size())
+    {
+        size_t end = out.find('\n', start);
+        std::string line = out.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        start = end == std::string::npos ? out.size() : end + 1;
+
+        std::vector<uint8_t> bytes;
+        if (line.compare(0, 2, "R:") == 0 && hex_decode(line.substr(2), bytes))
+        {
+            for (size_t i = 0; i + sizeof(RecordEvent) <= bytes.size(); i += sizeof(RecordEvent))
+            {
+                RecordEvent event;
+                memcpy(&event, &bytes[i], sizeof(event));
+                replayed.events.push_back(event);
+            }
+        }
+        else if (line.compare(0, 3, "RS:") == 0)
+        {
+            size_t comma = line.find(',');
+            unsigned ch = atoi(line.c_str() + 3);
+            if (comma != std::string::npos && ch < replay_channels)
+                replayed.snapshots[ch] = line.substr(comma + 1);
+        }
+        else if (line.compare(0, 3, "RH:") == 0)
+        {
+            int version, channels;
+            replayed.header = sscanf(line.c_str() + 3, "%d,%u,%u,%d,%d", &version, &replayed.start_ms,
+                                     &replayed.start_us, &replayed.zero_cross_counter, &channels) == 5;
+        }
+    }
+}
+
+static const char *event_name(uint8_t type)
+{
+    static const char *names[] = {"?", "zero_cross", "output_mask", "sample", "pid", "state", "stand"};
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "?";
+}
+
+static bool same_event(const RecordEvent &a, const RecordEvent &b)
+{
+    // transitions from timer checks are replayed on the 1ms grid, the state is compared only
+    if (a.type == REC_STATE)
+        return a.arg == b.arg;
+    return a.t_us == b.t_us && a.arg == b.arg && a.value == b.value;
+}
+
+static void print_event(const char *label, const RecordEvent &e, uint32_t start_us)
+{
+    printf("  %s t=%.6fs arg=%u value=0x%08X", label, (uint32_t)(e.t_us - start_us) * 1e-6, e.arg, e.value);
+    if (e.type == REC_PID)
+    {
+        float output;
+        memcpy(&output, &e.value, sizeof(output));
+        printf(" (%.9g)", output);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief compares every (type, channel) event stream.
+ *
+ * @return the number of mismatching streams.
+ */
+static int compare(const Recording &recorded, const Recording &replayed, bool verbose)
+{
+    std::map<uint16_t, std::vector<RecordEvent>> expected, actual;
+    for (const RecordEvent &e : recorded.events)
+        expected[e.type << 8 | e.channel].push_back(e);
+    for (const RecordEvent &e : replayed.events)
+        actual[e.type << 8 | e.channel].push_back(e);
+    for (auto &entry : actual)
+        expected[entry.first];
+
+    int failed = 0;
+    for (auto &entry : expected)
+    {
+        const std::vector<RecordEvent> &exp = entry.second;
+        const std::vector<RecordEvent> &act = actual[entry.first];
+        const char *name = event_name(entry.first >> 8);
+        const int ch = entry.first & 0xFF;
+
+        size_t n = std::min(exp.size(), act.size());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (same_event(exp[i], act[i]))
+                continue;
+            if (mismatches++ == 0 || verbose)
+            {
+                printf("%s ch%d event %zu differs\n", name, ch, i);
+                print_event("recorded", exp[i], recorded.start_us);
+                print_event("replayed", act[i], recorded.start_us);
+            }
+        }
+
+        bool ok = mismatches == 0 && exp.size() == act.size();
+        if (exp.size() != act.size())
+            printf("%s ch%d: %zu events recorded, %zu replayed\n", name, ch, exp.size(), act.size());
+        printf("%-12s ch%d events=%zu %s\n", name, ch, exp.size(), ok ? "match" : "MISMATCH");
+        failed += !ok;
+    }
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else if (path == nullptr)
+            path = argv[i];
+        else
+            path = nullptr, i = argc;
+    }
+    if (path == nullptr)
+    {
+        fprintf(stderr, "usage: jbclone_replay [--verbose] FILE\n");
+        return 2;
+    }
+
+    Recording recorded;
+    bool parsed;
+    if (strcmp(path, "-") == 0)
+        parsed = parse_recording(std::cin, recorded);
+    else
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            perror(path);
+            return 2;
+        }
+        parsed = parse_recording(file, recorded);
+    }
+    if (!parsed)
+    {
+        fprintf(stderr, "%s: no recording found\n", path);
+        return 2;
+    }
+    if (recorded.dropped > 0)
+    {
+        fprintf(stderr, "recording dropped %u events, it can not be replayed\n", recorded.dropped);
+        return 2;
+    }
+    if (!recorded.ended)
+        fprintf(stderr, "warning: recording has no end line, replaying what was captured\n");
+
+    std::vector<Heater::Snapshot> snapshots(replay_channels);
+    for (size_t ch = 0; ch < replay_channels; ch++)
+    {
+        std::vector<uint8_t> bytes;
+        if (!hex_decode(recorded.snapshots[ch], bytes) || bytes.size() != sizeof(Heater::Snapshot))
+        {
+            fprintf(stderr, "snapshot of channel %zu missing or of the wrong size\n", ch);
+            return 2;
+        }
+        memcpy(&snapshots[ch], bytes.data(), bytes.size());
+    }
+
+    // station with a blank EEPROM, ADC codes and stand levels served from the recording
+    uint16_t adc_codes[replay_channels] = {};
+    SimEeprom memory;
+    host_reset();
+    i2cBus.host_detach_all();
+    i2cBus.host_attach(&memory);
+    host_on_analog_read([&](uint32_t pin) {
+        for (size_t ch = 0; ch < replay_channels; ch++)
+            if ((int)pin == heaters[ch].get_tc_pin())
+                return (int)adc_codes[ch];
+        return 0;
+    });
+    setup();
+    host_timers_enable(false);
+    Serial.host_tx();
+
+    // micros() and millis() both as at the start of the recording
+    const uint64_t base_ms_us = (uint64_t)recorded.start_ms * 1000;
+    const uint64_t start_clock = base_ms_us + (int32_t)(recorded.start_us - (uint32_t)base_ms_us);
+    host_clock_set_us(start_clock);
+    zero_cross_counter = recorded.zero_cross_counter;
+    zero_cross_timestamp = (uint32_t)start_clock;
+    for (size_t ch = 0; ch < replay_channels; ch++)
+        heaters[ch].snapshot_load(snapshots[ch]);
+
+    Recording replayed;
+    replayed.snapshots.assign(replay_channels, "");
+    String cmd = "start", response;
+    if (!record_cli(cmd, response))
+    {
+        fprintf(stderr, "replay recording failed to start: %s\n", response.c_str());
+        return 2;
+    }
+    drain_station(replayed);
+    if (replayed.start_us != recorded.start_us || replayed.zero_cross_counter != recorded.zero_cross_counter ||
+        replayed.snapshots != recorded.snapshots)
+    {
+        fprintf(stderr, "restored state differs from the recorded snapshot\n");
+        return 2;
+    }
+
+    // inputs in time order, the ring order breaks ties
+    std::vector<ReplayInput> inputs;
+    for (const RecordEvent &e : recorded.events)
+        if (e.type == REC_ZERO_CROSS || e.type == REC_SAMPLE || e.type == REC_STAND)
+            inputs.push_back({e.t_us - recorded.start_us, &e, nullptr});
+    for (const Recording::Command &c : recorded.commands)
+        if (c.text.rfind("s:record:", 0) != 0)
+            inputs.push_back({c.t_us - recorded.start_us, nullptr, &c});
+    std::stable_sort(inputs.begin(), inputs.end(),
+                     [](const ReplayInput &a, const ReplayInput &b) { return a.rel_us < b.rel_us; });
+
+    uint64_t last_sampling_zero_cross = start_clock;
+    uint64_t next_tick = (start_clock / 1000 + 1) * 1000;
+
+    // one control tick and main loop pass: heaters not waiting for a recorded sample
+    auto timer_pass = [&](uint64_t now) {
+        host_clock_set_us(now);
+        zero_cross_events();
+        zero_cross_watchdog();
+        for (size_t ch = 0; ch < replay_channels; ch++)
+        {
+            if (heaters[ch].sample_pending() && now - last_sampling_zero_cross > _tc_amp_recovery_time)
+                continue;
+            heaters[ch].control_update();
+            heaters[ch].update();
+        }
+        steptest_update();
+        record_update(Serial);
+        drain_station(replayed);
+    };
+
+    for (const ReplayInput &input : inputs)
+    {
+        const uint64_t t = start_clock + input.rel_us;
+        while (next_tick < t)
+        {
+            timer_pass(next_tick);
+            next_tick += 1000;
+        }
+        host_clock_set_us(t);
+
+        if (input.command != nullptr)
+        {
+            String message = input.command->text.c_str();
+            String reply;
+            eval_serial_command(message, reply);
+        }
+        else if (input.event->type == REC_ZERO_CROSS)
+        {
+            if (input.event->arg >= _zero_cross_period)
+                last_sampling_zero_cross = t;
+            host_trigger_interrupt(_pin_zero_cross);
+            zero_cross_events();
+        }
+        else if (input.event->channel < replay_channels)
+        {
+            const uint8_t ch = input.event->channel;
+            if (input.event->type == REC_SAMPLE)
+                adc_codes[ch] = input.event->arg;
+            else
+                host_pin_drive(heaters[ch].get_stand_pin(), input.event->arg);
+            heaters[ch].control_update();
+            heaters[ch].update();
+            steptest_update();
+        }
+
+        record_update(Serial);
+        drain_station(replayed);
+    }
+
+    cmd = "stop";
+    record_cli(cmd, response);
+    drain_station(replayed);
+
+    double duration = inputs.empty() ? 0.0 : inputs.back().rel_us * 1e-6;
+    printf("# %zu events, %zu commands, %.3f s\n", recorded.events.size(), recorded.commands.size(), duration);
+    int failed = compare(recorded, replayed, verbose);
+    printf("%s\n", failed ? "replay differs from the recording" : "replay matches the recording");
+    return failed ? 1 : 0;
+}
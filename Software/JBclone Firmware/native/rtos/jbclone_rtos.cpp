@@ -0,0 +1,215 @@
+/**
+ * @file jbclone_rtos.cpp
+ * @brief the RTOS build of the firmware (JBCLONE_RTOS) on the FreeRTOS POSIX port.
+ *
+ * usage: jbclone_rtos [options]
+ *   --time S       run S seconds, then print the task, control tick and health statistics
+ *                  and exit; 0 runs until interrupted (default 10)
+ *   --cmd LINE     command sent to the USB port at start, repeatable
+ *   --mains HZ     mains frequency, default 50
+ *
+ * setup() creates the firmware tasks of src/tasks.h and starts the scheduler, as on the
+ * target. The host interrupt task, above every firmware task, stands in for the hardware:
+ * every kernel tick it integrates the simulated tips, raises the zero cross interrupt at each
+ * half-cycle and the control tick timer when due on the real time shim clock, and moves bytes
+ * between the USB port and stdin/stdout. Commands typed on stdin are answered on stdout:
+ *
+ *   jbclone_rtos --time 20 --cmd 0:heater_w:100 --cmd 0:set_t:300 --cmd 0:en:1
+ */
+
+#include "Arduino.h"
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "tip_plant.h"
+#include "sim_eeprom.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <chrono>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// firmware entry point, src/main.cpp built with JBCLONE_RTOS
+void setup();
+
+static const int rtos_tc_pins[4] = {_board1_temp, _board2_temp, _board3_temp, _board4_temp};
+static const int rtos_heater_pins[4] = {_board1_heater, _board2_heater, _board3_heater, _board4_heater};
+static const int rtos_stand_pins[4] = {_board1_stand, _board2_stand, _board3_stand, _board4_stand};
+static const float rtos_tc_gains[4] = {_board1_tc_gain, _board2_tc_gain, _board3_tc_gain, _board4_tc_gain};
+
+struct RtosHostOptions
+{
+    double time_s = 10.0;
+    float mains_hz = 50.0f;
+    std::vector<std::string> commands;
+};
+
+static RtosHostOptions options;
+static std::vector<TipPlant> plants;
+static SimEeprom eeprom_model;
+static volatile sig_atomic_t rtos_stop = 0;
+
+static const auto rtos_origin = std::chrono::steady_clock::now();
+
+/**
+ * @brief run time statistics clock, see rtos/posix/FreeRTOSConfig.h.
+ */
+extern "C" uint32_t rtos_run_time_us(void)
+{
+    auto elapsed = std::chrono::steady_clock::now() - rtos_origin;
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+extern "C" void vAssertCalled(const char *file, unsigned long line)
+{
+    fprintf(stderr, "jbclone_rtos: kernel assert %s:%lu\n", file, line);
+    abort();
+}
+
+static void rtos_signal(int)
+{
+    rtos_stop = 1;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: jbclone_rtos [--time S] [--cmd LINE]... [--mains HZ]\n");
+    exit(2);
+}
+
+static void rtos_write_stdout(const std::string &data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        const ssize_t n = write(STDOUT_FILENO, data.data() + done, data.size() - done);
+        if (n <= 0)
+            return;
+        done += n;
+    }
+}
+
+/**
+ * @brief host interrupt task: tips, zero cross, timers and the USB port every kernel tick.
+ */
+static void rtos_interrupt_task(void *parameters)
+{
+    (void)parameters;
+
+    const uint64_t half_cycle_us = (uint64_t)(500000.0f / options.mains_hz);
+    const uint64_t start_us = host_clock_us();
+    uint64_t last_us = start_us;
+    uint64_t next_zero_cross_us = start_us + half_cycle_us;
+    uint64_t stop_us = 0;
+
+    for (const std::string &line : options.commands)
+        Serial.host_rx(line + _serial_usb_terminator);
+
+    TickType_t wake = xTaskGetTickCount();
+    for (;;)
+    {
+        const uint64_t now = host_clock_us();
+
+        // tips in slices short against the amplifier recovery
+        while (last_us < now)
+        {
+            const uint64_t slice = now - last_us < 100 ? now - last_us : 100;
+            for (TipPlant &plant : plants)
+                plant.step(slice * 1e-6);
+            last_us += slice;
+        }
+
+        while (next_zero_cross_us <= now)
+        {
+            host_trigger_interrupt(_pin_zero_cross);
+            next_zero_cross_us += half_cycle_us;
+        }
+        host_timers_poll();
+
+        char buffer[256];
+        const ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (n > 0)
+            Serial.host_rx(buffer, n);
+        rtos_write_stdout(Serial.host_tx());
+        Serial1.host_tx(); // nobody listens to the display
+
+        // statistics through the USB port, then a few ticks for the replies
+        const bool timed_out = options.time_s > 0 && now - start_us >= (uint64_t)(options.time_s * 1e6);
+        if (stop_us == 0 && (timed_out || rtos_stop))
+        {
+            Serial.host_rx(std::string("s:rtos:?") + _serial_usb_terminator + "s:ctl:?" + _serial_usb_terminator +
+                           "s:health:?" + _serial_usb_terminator);
+            stop_us = now;
+        }
+        if (stop_us != 0 && now - stop_us > 200000)
+            exit(0);
+
+        vTaskDelayUntil(&wake, 1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+            usage();
+        if (arg == "--time")
+            options.time_s = atof(argv[++i]);
+        else if (arg == "--cmd")
+            options.commands.push_back(argv[++i]);
+        else if (arg == "--mains")
+            options.mains_hz = atof(argv[++i]);
+        else
+            usage();
+    }
+    if (options.mains_hz <= 0.0f)
+        usage();
+
+    signal(SIGINT, rtos_signal);
+    signal(SIGTERM, rtos_signal);
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+
+    for (int i = 0; i < 4; i++)
+        plants.emplace_back(TipModel(), 1 + i);
+
+    host_reset();
+    host_clock_realtime(true);
+    i2cBus.host_attach(&eeprom_model);
+
+    host_on_analog_read([](uint32_t pin) {
+        for (int i = 0; i < 4; i++)
+        {
+            if ((int)pin == rtos_tc_pins[i])
+                return plants[i].adc_code(rtos_tc_gains[i], host_adc_bits(), ADC_VREF);
+        }
+        return 0;
+    });
+
+    host_on_digital_write([](uint32_t pin, int level) {
+        for (int i = 0; i < 4; i++)
+        {
+            if ((int)pin == rtos_heater_pins[i])
+                plants[i].set_heater(level == HIGH);
+        }
+    });
+
+    // tips lifted from the stand
+    for (int pin : rtos_stand_pins)
+        host_pin_drive(pin, HIGH);
+
+    xTaskCreate(rtos_interrupt_task, "irq", configMINIMAL_STACK_SIZE, nullptr, configMAX_PRIORITIES - 1, nullptr);
+
+    // does not return, the tasks run from here on
+    setup();
+    return 1;
+}
@@ -0,0 +1,510 @@
+#include "Arduino.h"
+#include "arduino_host.h"
+
+#include <chrono>
+
+// clock
+static bool realtime_clock = false;
+static uint64_t simulated_us = 0;
+static std::function<void(uint64_t, uint64_t)> clock_advance_callback;
+static bool clock_advance_running = false;
+static std::chrono::steady_clock::time_point realtime_origin = std::chrono::steady_clock::now();
+
+// gpio
+struct HostPin
+{
+    int mode = INPUT;
+    int output = LOW;
+    int input = LOW;
+    callback_function_t isr = nullptr;
+    uint32_t isr_mode = 0;
+};
+static HostPin pins[HOST_PIN_COUNT];
+static std::function<void(uint32_t, int)> digital_write_callback;
+static std::function<int(uint32_t)> analog_read_callback;
+static int adc_bits = 10;
+static int interrupt_disable_depth = 0;
+
+// timers, index from the TIMx instance
+struct HostTimer
+{
+    callback_function_t isr = nullptr;
+    uint64_t period_us = 0;
+    uint64_t next_due_us = 0;
+    bool running = false;
+    bool irq_enabled = true;
+    bool pending = false;
+};
+static constexpr int host_timer_count = 5;
+static HostTimer timers[host_timer_count];
+static bool timers_enabled = true;
+static bool timer_isr_running = false;
+
+static void timer_interrupt(HostTimer &timer)
+{
+    if (!timer.irq_enabled || interrupt_disable_depth > 0 || timer_isr_running || timer.isr == nullptr)
+    {
+        timer.pending = timer.isr != nullptr;
+        return;
+    }
+    timer.pending = false;
+    timer_isr_running = true;
+    timer.isr();
+    timer_isr_running = false;
+}
+
+// pending interrupts of the timers unmasked meanwhile
+static void timer_run_pending()
+{
+    for (HostTimer &timer : timers)
+    {
+        if (timer.pending)
+            timer_interrupt(timer);
+    }
+}
+
+// earliest timer due up to the given time
+static HostTimer *timer_next_due(uint64_t to_us)
+{
+    HostTimer *next = nullptr;
+    for (HostTimer &timer : timers)
+    {
+        if (!timer.running || timer.period_us == 0)
+            continue;
+        // the clock was set past the due time, keep the phase
+        if (timer.next_due_us < simulated_us)
+            timer.next_due_us += (simulated_us - timer.next_due_us + timer.period_us - 1) / timer.period_us * timer.period_us;
+        if (timer.next_due_us <= to_us && (next == nullptr || timer.next_due_us < next->next_due_us))
+            next = &timer;
+    }
+    return next;
+}
+
+void host_clock_realtime(bool enable)
+{
+    if (enable && !realtime_clock)
+        realtime_origin = std::chrono::steady_clock::now() - std::chrono::microseconds(simulated_us);
+    realtime_clock = enable;
+}
+
+uint64_t host_clock_us()
+{
+    if (!realtime_clock)
+        return simulated_us;
+
+    auto elapsed = std::chrono::steady_clock::now() - realtime_origin;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void host_clock_set_us(uint64_t us)
+{
+    simulated_us = us;
+}
+
+static void clock_advance_to(uint64_t to_us)
+{
+    const uint64_t from = simulated_us;
+    simulated_us = to_us;
+    if (clock_advance_callback)
+        clock_advance_callback(from, to_us);
+}
+
+void host_clock_advance_us(uint64_t us)
+{
+    const uint64_t to = simulated_us + us;
+
+    // not reentrant, time the callback and the timer interrupts spend is their own business
+    if (clock_advance_running)
+    {
+        simulated_us = to;
+        return;
+    }
+
+    clock_advance_running = true;
+    HostTimer *timer;
+    while (timers_enabled && (timer = timer_next_due(to)) != nullptr)
+    {
+        const uint64_t due = timer->next_due_us;
+        timer->next_due_us += timer->period_us;
+        clock_advance_to(due);
+        timer_interrupt(*timer);
+    }
+    clock_advance_to(to);
+    clock_advance_running = false;
+}
+
+void host_on_clock_advance(std::function<void(uint64_t from_us, uint64_t to_us)> callback)
+{
+    clock_advance_callback = callback;
+}
+
+int host_pin_mode(uint32_t pin)
+{
+    return pin < HOST_PIN_COUNT ? pins[pin].mode : INPUT;
+}
+
+int host_pin_level(uint32_t pin)
+{
+    if (pin >= HOST_PIN_COUNT)
+        return LOW;
+    return pins[pin].mode == OUTPUT ? pins[pin].output : pins[pin].input;
+}
+
+void host_pin_drive(uint32_t pin, int level)
+{
+    if (pin < HOST_PIN_COUNT)
+        pins[pin].input = level ? HIGH : LOW;
+}
+
+void host_on_digital_write(std::function<void(uint32_t, int)> callback)
+{
+    digital_write_callback = callback;
+}
+
+void host_on_analog_read(std::function<int(uint32_t)> callback)
+{
+    analog_read_callback = callback;
+}
+
+int host_adc_bits()
+{
+    return adc_bits;
+}
+
+bool host_interrupts_enabled()
+{
+    return interrupt_disable_depth == 0;
+}
+
+bool host_trigger_interrupt(uint32_t pin)
+{
+    if (pin >= HOST_PIN_COUNT || pins[pin].isr == nullptr || !host_interrupts_enabled())
+        return false;
+    pins[pin].isr();
+    return true;
+}
+
+void host_timers_enable(bool enable)
+{
+    timers_enabled = enable;
+}
+
+void host_timers_poll()
+{
+    if (!timers_enabled)
+        return;
+
+    const uint64_t now = host_clock_us();
+    for (HostTimer &timer : timers)
+    {
+        if (!timer.running || timer.period_us == 0 || timer.next_due_us > now)
+            continue;
+        // periods missed by the host collapse into one interrupt, as the pending bit does
+        timer.next_due_us += ((now - timer.next_due_us) / timer.period_us + 1) * timer.period_us;
+        timer_interrupt(timer);
+    }
+}
+
+void host_reset()
+{
+    for (HostPin &pin : pins)
+        pin = HostPin();
+    for (HostTimer &timer : timers)
+        timer = HostTimer();
+    timers_enabled = true;
+    digital_write_callback = nullptr;
+    analog_read_callback = nullptr;
+    clock_advance_callback = nullptr;
+    adc_bits = 10;
+    interrupt_disable_depth = 0;
+    realtime_clock = false;
+    simulated_us = 0;
+}
+
+// Arduino API
+uint32_t millis()
+{
+    return (uint32_t)(host_clock_us() / 1000);
+}
+
+uint32_t micros()
+{
+    return (uint32_t)host_clock_us();
+}
+
+void delay(uint32_t ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    if (!realtime_clock)
+    {
+        host_clock_advance_us(us);
+        return;
+    }
+    uint64_t start = host_clock_us();
+    while (host_clock_us() - start < us)
+    {
+    }
+}
+
+void pinMode(uint32_t pin, uint32_t mode)
+{
+    if (pin < HOST_PIN_COUNT)
+        pins[pin].mode = mode;
+}
+
+void digitalWrite(uint32_t pin, uint32_t value)
+{
+    if (pin >= HOST_PIN_COUNT)
+        return;
+    pins[pin].output = value ? HIGH : LOW;
+    if (digital_write_callback)
+        digital_write_callback(pin, pins[pin].output);
+}
+
+int digitalRead(uint32_t pin)
+{
+    return host_pin_level(pin);
+}
+
+int analogRead(uint32_t pin)
+{
+    if (!analog_read_callback)
+        return 0;
+    int code = analog_read_callback(pin);
+    return constrain(code, 0, (1 << adc_bits) - 1);
+}
+
+void analogReadResolution(int bits)
+{
+    adc_bits = bits;
+}
+
+void attachInterrupt(uint32_t pin, callback_function_t callback, uint32_t mode)
+{
+    if (pin >= HOST_PIN_COUNT)
+        return;
+    pins[pin].isr = callback;
+    pins[pin].isr_mode = mode;
+}
+
+void detachInterrupt(uint32_t pin)
+{
+    if (pin < HOST_PIN_COUNT)
+        pins[pin].isr = nullptr;
+}
+
+void noInterrupts()
+{
+    interrupt_disable_depth = 1;
+}
+
+void interrupts()
+{
+    interrupt_disable_depth = 0;
+    if (timers_enabled)
+        timer_run_pending();
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    const int index = irq - TIM2_IRQn + 2;
+    if (index < 0 || index >= host_timer_count)
+        return;
+    timers[index].irq_enabled = true;
+    if (timers_enabled && timers[index].pending)
+        timer_interrupt(timers[index]);
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    const int index = irq - TIM2_IRQn + 2;
+    if (index >= 0 && index < host_timer_count)
+        timers[index].irq_enabled = false;
+}
+
+void __WFI()
+{
+    if (realtime_clock)
+        return;
+
+    // a pending interrupt ends the sleep at once
+    for (HostTimer &timer : timers)
+    {
+        if (timer.pending && timer.irq_enabled)
+            return;
+    }
+
+    uint64_t wake_us = (simulated_us / 1000 + 1) * 1000; // SysTick
+    HostTimer *timer = timers_enabled ? timer_next_due(wake_us) : nullptr;
+    if (timer != nullptr)
+        wake_us = timer->next_due_us;
+
+    // the interrupts of the sleep run at their time, on the target they would run right
+    // after the unmask; pin interrupts in between do not end it, the loop has no work for them
+    const int depth = interrupt_disable_depth;
+    interrupt_disable_depth = 0;
+    host_clock_advance_us(wake_us - simulated_us);
+    interrupt_disable_depth = depth;
+}
+
+// HardwareTimer
+HardwareTimer::HardwareTimer(TIM_TypeDef *instance) : _index((int)(uintptr_t)instance % host_timer_count)
+{
+}
+
+void HardwareTimer::setOverflow(uint32_t value, TimerFormat_t format)
+{
+    HostTimer &timer = timers[_index];
+    if (format == MICROSEC_FORMAT)
+        timer.period_us = value;
+    else if (format == HERTZ_FORMAT)
+        timer.period_us = value ? 1000000 / value : 0;
+    else
+        timer.period_us = value / (F_CPU / 1000000L);
+}
+
+void HardwareTimer::attachInterrupt(callback_function_t callback)
+{
+    timers[_index].isr = callback;
+}
+
+void HardwareTimer::setInterruptPriority(uint32_t preempt_priority, uint32_t sub_priority)
+{
+    // the host runs one interrupt at a time, in time order
+    (void)preempt_priority;
+    (void)sub_priority;
+}
+
+void HardwareTimer::pause()
+{
+    timers[_index].running = false;
+    timers[_index].pending = false;
+}
+
+void HardwareTimer::resume()
+{
+    HostTimer &timer = timers[_index];
+    if (timer.running)
+        return;
+    timer.running = true;
+    timer.next_due_us = host_clock_us() + timer.period_us;
+    // resume() enables the update interrupt in the NVIC
+    timer.irq_enabled = true;
+}
+
+// Print
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+        n += write(*buffer++);
+    return n;
+}
+
+// Stream
+int Stream::timedRead()
+{
+    uint32_t start = millis();
+    do
+    {
+        if (available() > 0)
+            return read();
+        // nothing to poll on the simulated clock, let time run out
+        if (!realtime_clock)
+            host_clock_advance_us(10);
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+String Stream::readString()
+{
+    String ret;
+    int c = timedRead();
+    while (c >= 0)
+    {
+        ret += (char)c;
+        c = timedRead();
+    }
+    return ret;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String ret;
+    int c = timedRead();
+    while (c >= 0 && c != terminator)
+    {
+        ret += (char)c;
+        c = timedRead();
+    }
+    return ret;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length)
+    {
+        int c = timedRead();
+        if (c < 0)
+            break;
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+// HardwareSerial
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+
+int HardwareSerial::available()
+{
+    // polling an empty port takes time on the real target as well
+    if (_rx.empty() && !realtime_clock)
+        host_clock_advance_us(1);
+    return (int)_rx.size();
+}
+
+int HardwareSerial::read()
+{
+    if (_rx.empty())
+        return -1;
+    uint8_t c = _rx.front();
+    _rx.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    return _rx.empty() ? -1 : _rx.front();
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    _tx.push_back((char)c);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    _tx.append((const char *)buffer, size);
+    return size;
+}
+
+void HardwareSerial::host_rx(const char *data, size_t length)
+{
+    _rx.insert(_rx.end(), data, data + length);
+}
+
+std::string HardwareSerial::host_tx()
+{
+    std::string out;
+    out.swap(_tx);
+    return out;
+}
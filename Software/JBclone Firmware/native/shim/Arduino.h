@@ -0,0 +1,119 @@
+#ifndef __SHIM_ARDUINO_H__
+#define __SHIM_ARDUINO_H__
+
+/**
+ * @file Arduino.h
+ * @brief minimal Arduino core replacement used to build the firmware libraries on Linux.
+ *
+ * Only the API surface used by the firmware is provided. Time, pins, ADC and interrupts
+ * are driven by the host through arduino_host.h.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+#ifndef F_CPU
+#define F_CPU 72000000L
+#endif
+
+using std::isinf;
+using std::isnan;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define INPUT_PULLDOWN 0x3
+#define INPUT_ANALOG 0x4
+
+#define CHANGE 0x2
+#define FALLING 0x3
+#define RISING 0x4
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// generic STM32F103C8 pin numbering, port A then port B then port C
+enum
+{
+    PA0, PA1, PA2, PA3, PA4, PA5, PA6, PA7, PA8, PA9, PA10, PA11, PA12, PA13, PA14, PA15,
+    PB0, PB1, PB2, PB3, PB4, PB5, PB6, PB7, PB8, PB9, PB10, PB11, PB12, PB13, PB14, PB15,
+    PC13 = 45, PC14, PC15,
+    HOST_PIN_COUNT
+};
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+int analogRead(uint32_t pin);
+void analogReadResolution(int bits);
+
+typedef void (*callback_function_t)(void);
+#define digitalPinToInterrupt(p) (p)
+void attachInterrupt(uint32_t pin, callback_function_t callback, uint32_t mode);
+void detachInterrupt(uint32_t pin);
+void noInterrupts();
+void interrupts();
+
+// STM32duino HardwareTimer subset: one periodic update interrupt per timer, fired while the
+// host advances the simulated clock, masked by noInterrupts() and NVIC_DisableIRQ()
+struct TIM_TypeDef;
+#define TIM2 ((TIM_TypeDef *)2)
+#define TIM3 ((TIM_TypeDef *)3)
+#define TIM4 ((TIM_TypeDef *)4)
+
+enum IRQn_Type
+{
+    TIM2_IRQn = 28,
+    TIM3_IRQn = 29,
+    TIM4_IRQn = 30,
+};
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+
+// CMSIS wait for interrupt: the host advances the simulated clock to the next timer
+// interrupt or SysTick (every ms), also with interrupts masked
+void __WFI();
+
+enum TimerFormat_t
+{
+    TICK_FORMAT,
+    MICROSEC_FORMAT,
+    HERTZ_FORMAT,
+};
+
+class HardwareTimer
+{
+private:
+    int _index;
+
+public:
+    explicit HardwareTimer(TIM_TypeDef *instance);
+    void setOverflow(uint32_t value, TimerFormat_t format = TICK_FORMAT);
+    void attachInterrupt(callback_function_t callback);
+    void setInterruptPriority(uint32_t preempt_priority, uint32_t sub_priority);
+    void pause();
+    void resume();
+};
+
+#endif
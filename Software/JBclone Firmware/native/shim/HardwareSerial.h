@@ -0,0 +1,49 @@
+#ifndef __SHIM_HARDWARE_SERIAL_H__
+#define __SHIM_HARDWARE_SERIAL_H__
+
+#include <deque>
+#include <string>
+#include "Stream.h"
+
+/**
+ * @brief host replacement of the Arduino HardwareSerial class.
+ *
+ * Received bytes are injected by the host with host_rx(), transmitted bytes are
+ * collected and drained with host_tx().
+ */
+class HardwareSerial : public Stream
+{
+private:
+    std::deque<uint8_t> _rx;
+    std::string _tx;
+    uint32_t _baud = 0;
+
+public:
+    void begin(uint32_t baud) { _baud = baud; }
+    void end() {}
+    uint32_t baud() const { return _baud; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() {}
+    int availableForWrite() { return 64; } // sent at once, the target buffer is always free
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    operator bool() const { return true; }
+
+    // host side
+    void host_rx(const char *data, size_t length);
+    void host_rx(const std::string &data) { host_rx(data.data(), data.size()); }
+    size_t host_rx_pending() const { return _rx.size(); }
+    std::string host_tx();
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef __SHIM_STREAM_H__
+#define __SHIM_STREAM_H__
+
+#include "Print.h"
+
+/**
+ * @brief host replacement of the Arduino Stream class.
+ *
+ * Timed reads use millis(). On the simulated clock a read waiting for data advances
+ * the clock itself, so a missing terminator still times out.
+ */
+class Stream : public Print
+{
+protected:
+    unsigned long _timeout = 1000;
+    int timedRead();
+
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    String readString();
+    String readStringUntil(char terminator);
+    size_t readBytes(char *buffer, size_t length);
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static std::string format_integer(unsigned long value, bool negative, unsigned char base)
+{
+    if (base < 2 || base > 36)
+        base = 10;
+
+    char buffer[72];
+    int pos = sizeof(buffer) - 1;
+    buffer[pos] = '\0';
+    do
+    {
+        int digit = value % base;
+        buffer[--pos] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value != 0 && pos > 1);
+
+    if (negative)
+        buffer[--pos] = '-';
+
+    return std::string(&buffer[pos]);
+}
+
+String::String(unsigned char value, unsigned char base) : _s(format_integer(value, false, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(format_integer(value, false, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(format_integer(value, false, base)) {}
+
+String::String(int value, unsigned char base) : String(long(value), base) {}
+
+String::String(long value, unsigned char base)
+{
+    // Arduino only prints a sign for base 10, other bases show the two's complement
+    if (base == 10 && value < 0)
+        _s = format_integer(0UL - (unsigned long)value, true, base);
+    else
+        _s = format_integer((unsigned long)value, false, base);
+}
+
+String::String(float value, unsigned char decimals) : String(double(value), decimals) {}
+
+String::String(double value, unsigned char decimals)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    _s = buffer;
+}
+
+bool String::reserve(unsigned int size)
+{
+    _s.reserve(size);
+    return true;
+}
+
+char String::charAt(unsigned int index) const
+{
+    if (index >= _s.length())
+        return 0;
+    return _s[index];
+}
+
+char &String::operator[](unsigned int index)
+{
+    static char dummy_writable_char;
+    if (index >= _s.length())
+    {
+        dummy_writable_char = 0;
+        return dummy_writable_char;
+    }
+    return _s[index];
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+    if (fromIndex >= _s.length())
+        return -1;
+    size_t pos = _s.find(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const
+{
+    if (fromIndex >= _s.length())
+        return -1;
+    size_t pos = _s.find(str._s, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const
+{
+    size_t pos = _s.rfind(ch);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const
+{
+    return substring(beginIndex, length());
+}
+
+String String::substring(unsigned int left, unsigned int right) const
+{
+    if (left > right)
+    {
+        unsigned int temp = right;
+        right = left;
+        left = temp;
+    }
+    if (left >= _s.length())
+        return String();
+    if (right > _s.length())
+        right = _s.length();
+    return String(_s.substr(left, right - left));
+}
+
+bool String::startsWith(const String &prefix) const
+{
+    return _s.compare(0, prefix._s.length(), prefix._s) == 0 && _s.length() >= prefix._s.length();
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    if (suffix._s.length() > _s.length())
+        return false;
+    return _s.compare(_s.length() - suffix._s.length(), suffix._s.length(), suffix._s) == 0;
+}
+
+void String::trim()
+{
+    size_t begin = 0;
+    while (begin < _s.length() && isspace((unsigned char)_s[begin]))
+        begin++;
+    size_t end = _s.length();
+    while (end > begin && isspace((unsigned char)_s[end - 1]))
+        end--;
+    _s = _s.substr(begin, end - begin);
+}
+
+void String::toLowerCase()
+{
+    for (char &c : _s)
+        c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase()
+{
+    for (char &c : _s)
+        c = (char)toupper((unsigned char)c);
+}
+
+long String::toInt() const
+{
+    return atol(_s.c_str());
+}
+
+float String::toFloat() const
+{
+    return (float)atof(_s.c_str());
+}
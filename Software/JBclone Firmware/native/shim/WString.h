@@ -0,0 +1,78 @@
+#ifndef __SHIM_WSTRING_H__
+#define __SHIM_WSTRING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * @brief host replacement of the Arduino String class.
+ *
+ * Backed by std::string, implements the subset of the Arduino API used by the firmware
+ * with the same semantics (float formatting, substring bounds, toInt on garbage, etc).
+ */
+class String
+{
+private:
+    std::string _s;
+
+public:
+    String() = default;
+    String(const char *cstr) : _s(cstr ? cstr : "") {}
+    String(const std::string &s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+
+    unsigned int length() const { return (unsigned int)_s.length(); }
+    const char *c_str() const { return _s.c_str(); }
+    bool reserve(unsigned int size);
+
+    char charAt(unsigned int index) const;
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index);
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String &str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    bool startsWith(const String &prefix) const;
+    bool endsWith(const String &suffix) const;
+    bool equals(const String &other) const { return _s == other._s; }
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+
+    long toInt() const;
+    float toFloat() const;
+
+    bool concat(const String &str) { _s += str._s; return true; }
+    bool concat(const char *cstr) { _s += cstr ? cstr : ""; return true; }
+    bool concat(char c) { _s += c; return true; }
+
+    String &operator+=(const String &rhs) { concat(rhs); return *this; }
+    String &operator+=(const char *rhs) { concat(rhs); return *this; }
+    String &operator+=(char rhs) { concat(rhs); return *this; }
+
+    friend String operator+(const String &lhs, const String &rhs) { return String(lhs._s + rhs._s); }
+    friend String operator+(const String &lhs, const char *rhs) { return String(lhs._s + (rhs ? rhs : "")); }
+    friend String operator+(const char *lhs, const String &rhs) { return String((lhs ? lhs : "") + rhs._s); }
+    friend String operator+(const String &lhs, char rhs) { return String(lhs._s + rhs); }
+
+    bool operator==(const String &rhs) const { return _s == rhs._s; }
+    bool operator==(const char *rhs) const { return _s == (rhs ? rhs : ""); }
+    bool operator!=(const String &rhs) const { return _s != rhs._s; }
+    bool operator!=(const char *rhs) const { return !(*this == rhs); }
+    bool operator<(const String &rhs) const { return _s < rhs._s; }
+
+    const std::string &str() const { return _s; }
+};
+
+#endif
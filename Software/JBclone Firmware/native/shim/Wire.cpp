@@ -0,0 +1,90 @@
+#include "Wire.h"
+#include "arduino_host.h"
+
+TwoWire Wire;
+
+I2cDevice *TwoWire::find(uint8_t address, bool read)
+{
+    for (I2cDevice *device : _devices)
+    {
+        if (device->i2c_address(address, read))
+            return device;
+    }
+    return nullptr;
+}
+
+void TwoWire::bus_time(size_t bytes)
+{
+    // start + address + payload, 9 clocks per byte, stop
+    uint64_t clocks = 2 + 9 * (bytes + 1);
+    host_clock_advance_us((clocks * 1000000ULL + _clock_hz - 1) / _clock_hz);
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _tx_address = address;
+    _tx_buffer.clear();
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    // same limit as the STM32duino transmit buffer
+    if (_tx_buffer.size() >= 32)
+        return 0;
+    _tx_buffer.push_back(data);
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t length)
+{
+    size_t n = 0;
+    while (length--)
+        n += write(*data++);
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    I2cDevice *device = find(_tx_address, false);
+    if (device == nullptr)
+    {
+        bus_time(0);
+        return 2; // NACK on address
+    }
+
+    bus_time(_tx_buffer.size());
+    bool ack = device->i2c_write(_tx_address, _tx_buffer.data(), _tx_buffer.size(), sendStop);
+    _tx_buffer.clear();
+    return ack ? 0 : 3; // 3 = NACK on data
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity)
+{
+    _rx_buffer.clear();
+    _rx_index = 0;
+
+    I2cDevice *device = find(address, true);
+    if (device == nullptr)
+    {
+        bus_time(0);
+        return 0;
+    }
+
+    _rx_buffer.resize(quantity);
+    size_t received = device->i2c_read(address, _rx_buffer.data(), quantity);
+    _rx_buffer.resize(received);
+    bus_time(received);
+    return (uint8_t)received;
+}
+
+int TwoWire::available()
+{
+    return (int)(_rx_buffer.size() - _rx_index);
+}
+
+int TwoWire::read()
+{
+    if (_rx_index >= _rx_buffer.size())
+        return -1;
+    return _rx_buffer[_rx_index++];
+}
@@ -0,0 +1,80 @@
+#ifndef __SHIM_WIRE_H__
+#define __SHIM_WIRE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief device model attached to the host TwoWire bus.
+ *
+ * Addresses are 7 bit. A device claims every address it answers to, so a 24C16 can
+ * respond on the whole 0x50-0x57 block.
+ */
+class I2cDevice
+{
+public:
+    virtual ~I2cDevice() = default;
+
+    /**
+     * @brief address phase, returns true when the device acknowledges its address.
+     */
+    virtual bool i2c_address(uint8_t address, bool read) = 0;
+
+    /**
+     * @brief write transaction payload, returns true if every byte was acknowledged.
+     */
+    virtual bool i2c_write(uint8_t address, const uint8_t *data, size_t length, bool stop) = 0;
+
+    /**
+     * @brief read transaction, fills data and returns the number of bytes delivered.
+     */
+    virtual size_t i2c_read(uint8_t address, uint8_t *data, size_t length) = 0;
+};
+
+/**
+ * @brief host replacement of the STM32duino TwoWire class.
+ *
+ * Transactions are forwarded to the attached I2cDevice models and advance the host
+ * clock by the time the transfer takes on a 100 kHz bus.
+ */
+class TwoWire
+{
+private:
+    std::vector<I2cDevice *> _devices;
+    uint8_t _tx_address = 0;
+    std::vector<uint8_t> _tx_buffer;
+    std::vector<uint8_t> _rx_buffer;
+    size_t _rx_index = 0;
+    uint32_t _clock_hz = 100000;
+
+    I2cDevice *find(uint8_t address, bool read);
+    void bus_time(size_t bytes);
+
+public:
+    TwoWire() = default;
+    TwoWire(uint32_t sda, uint32_t scl) { (void)sda; (void)scl; }
+
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t hz) { _clock_hz = hz; }
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t length);
+    uint8_t endTransmission(bool sendStop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+    int available();
+    int read();
+
+    // host side
+    void host_attach(I2cDevice *device) { _devices.push_back(device); }
+    void host_detach_all() { _devices.clear(); }
+};
+
+extern TwoWire Wire;
+
+#endif
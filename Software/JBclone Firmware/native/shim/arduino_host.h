@@ -0,0 +1,52 @@
+#ifndef __SHIM_ARDUINO_HOST_H__
+#define __SHIM_ARDUINO_HOST_H__
+
+/**
+ * @file arduino_host.h
+ * @brief host side controls of the Arduino shim.
+ *
+ * The shim has a single global clock. In simulated mode time only moves when the host
+ * advances it (or when a peripheral model spends bus time), which makes runs
+ * deterministic and faster than real time. A clock advance callback sees every step of
+ * the simulated clock, also those spent inside blocking firmware calls, which is where a
+ * host model delivers the interrupts that would have preempted them. In real time mode millis()/micros() follow
+ * the monotonic clock of the machine.
+ * Timer update interrupts run at their due time while the simulated clock advances, after
+ * the clock advance callback caught up to it. A masked timer keeps one pending interrupt,
+ * as the NVIC does, and runs it when unmasked. In real time mode the host polls the timers.
+ */
+
+#include <stdint.h>
+#include <functional>
+
+#include "Arduino.h"
+
+// clock
+void host_clock_realtime(bool enable);
+uint64_t host_clock_us();
+void host_clock_set_us(uint64_t us);
+void host_clock_advance_us(uint64_t us);
+void host_on_clock_advance(std::function<void(uint64_t from_us, uint64_t to_us)> callback);
+
+// gpio
+int host_pin_mode(uint32_t pin);
+int host_pin_level(uint32_t pin);
+void host_pin_drive(uint32_t pin, int level); // external level seen by digitalRead on inputs
+void host_on_digital_write(std::function<void(uint32_t pin, int level)> callback);
+
+// adc, callback returns the raw code for the requested pin
+void host_on_analog_read(std::function<int(uint32_t pin)> callback);
+int host_adc_bits();
+
+// interrupts
+bool host_interrupts_enabled();
+bool host_trigger_interrupt(uint32_t pin);
+
+// HardwareTimer interrupts, on by default; off, only the host calls the firmware
+void host_timers_enable(bool enable);
+void host_timers_poll(); // real time mode, runs the timers due by now
+
+// reset every pin, callback and the clock to power on state
+void host_reset();
+
+#endif
@@ -0,0 +1,330 @@
+/**
+ * @file jbclone_pidsweep.cpp
+ * @brief PID gain grid sweep and compass search over simulated tips, on all cores.
+ *
+ * usage: jbclone_pidsweep [options]
+ *   --model NAME[:name=value,...]  tip model to tune (see TipModel::set), repeatable,
+ *                                  default one model with the TipModel defaults
+ *   --kp/--ki/--kd/--d_tau LIST    grid values, comma separated
+ *   --refine N                     compass search rounds around the best grid point, default 20
+ *   --ch N                         channel used for the run and the output commands, default 0
+ *   --sp C --time S --load G@T     scenario, as jbclone_sim (default 350, 20, 0.1@12)
+ *   --jobs N                       parallel runs, default all cores
+ *   --top N                        best runs listed per model, default 5
+ *
+ * Every run is a fresh station process scored with StepMetrics::score(). For each model
+ * the best gains are printed as station commands.
+ */
+
+#include "scenario.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct Candidate
+{
+    PidGains gains;
+    bool ok = false;
+    double score = 0.0;
+    StepMetrics metrics;
+};
+
+struct TipModelSet
+{
+    std::string name;
+    TipModel model;
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: jbclone_pidsweep [--model NAME[:name=value,...]]... [--kp LIST] [--ki LIST] [--kd LIST]\n"
+                    "                        [--d_tau LIST] [--refine N] [--ch N] [--sp C] [--time S] [--load G@T]\n"
+                    "                        [--jobs N] [--top N]\n");
+    exit(2);
+}
+
+static bool parse_list(const char *text, std::vector<float> &values)
+{
+    values.clear();
+    std::string s = text;
+    size_t start = 0;
+    while (start <= s.size())
+    {
+        size_t comma = s.find(',', start);
+        std::string item = s.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        char *end;
+        float v = strtof(item.c_str(), &end);
+        if (item.empty() || *end != '\0' || v < 0.0f)
+            return false;
+        values.push_back(v);
+        if (comma == std::string::npos)
+            break;
+        start = comma + 1;
+    }
+    return !values.empty();
+}
+
+static bool parse_model(const char *text, TipModelSet &set)
+{
+    std::string s = text;
+    size_t colon = s.find(':');
+    set.name = s.substr(0, colon);
+    if (colon == std::string::npos)
+        return true;
+
+    size_t start = colon + 1;
+    while (start < s.size())
+    {
+        size_t comma = s.find(',', start);
+        std::string item = s.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t eq = item.find('=');
+        if (eq == std::string::npos || !set.model.set(item.substr(0, eq).c_str(), atof(item.c_str() + eq + 1)))
+            return false;
+        if (comma == std::string::npos)
+            break;
+        start = comma + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief runs every candidate in its own process, at most jobs at a time.
+ *
+ * The firmware state is global, a forked child runs one station and reports its
+ * metrics through a pipe.
+ */
+static void evaluate(const TipModel &model, const Scenario &base, std::vector<Candidate> &candidates, int jobs)
+{
+    struct Running
+    {
+        pid_t pid;
+        int fd;
+        size_t index;
+    };
+    std::vector<Running> running;
+    size_t next = 0;
+
+    SimConfig config;
+    for (TipModel &tip : config.tips)
+        tip = model;
+
+    auto collect = [&](const Running &r) {
+        struct
+        {
+            bool ok;
+            StepMetrics metrics;
+        } result;
+        Candidate &c = candidates[r.index];
+        c.ok = read(r.fd, &result, sizeof(result)) == (ssize_t)sizeof(result) && result.ok;
+        c.metrics = result.metrics;
+        c.score = c.ok ? c.metrics.score(base.time_s) : INFINITY;
+        close(r.fd);
+    };
+
+    while (next < candidates.size() || !running.empty())
+    {
+        while (next < candidates.size() && (int)running.size() < jobs)
+        {
+            int fds[2];
+            if (pipe(fds) != 0)
+            {
+                perror("pipe");
+                exit(1);
+            }
+
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                close(fds[0]);
+                Scenario scenario = base;
+                scenario.gains = candidates[next].gains;
+                struct
+                {
+                    bool ok;
+                    StepMetrics metrics;
+                } result;
+                result.ok = run_scenario(config, scenario, result.metrics);
+                ssize_t written = write(fds[1], &result, sizeof(result));
+                _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+            }
+            if (pid < 0)
+            {
+                perror("fork");
+                exit(1);
+            }
+
+            close(fds[1]);
+            running.push_back({pid, fds[0], next++});
+        }
+
+        int status;
+        pid_t done = wait(&status);
+        for (size_t i = 0; i < running.size(); i++)
+        {
+            if (running[i].pid == done)
+            {
+                collect(running[i]);
+                running.erase(running.begin() + i);
+                break;
+            }
+        }
+    }
+}
+
+static void print_candidate(const Candidate &c)
+{
+    const StepMetrics &m = c.metrics;
+    printf("kp=%.3f ki=%.4f kd=%.4f d_tau=%.3f score=%.3f heatup_s=%.2f overshoot_c=%.2f settling_s=%.2f "
+           "load_dip_c=%.2f load_recovery_s=%.2f\n",
+           c.gains.kp, c.gains.ki, c.gains.kd, c.gains.d_tau, c.score, m.heatup_s, m.overshoot_c, m.settling_s,
+           m.load_dip_c, m.load_recovery_s);
+}
+
+/**
+ * @brief compass search in log space around the best candidate.
+ *
+ * Each round evaluates a step up and down on every non zero gain in parallel, moves to the
+ * best improvement or halves the step. Gains at zero stay at zero.
+ */
+static Candidate refine(const TipModel &model, const Scenario &base, Candidate best, int rounds, int jobs,
+                        std::vector<Candidate> &history)
+{
+    double step = 0.5; // log2
+    for (int round = 0; round < rounds && step > 0.02; round++)
+    {
+        std::vector<Candidate> batch;
+        float PidGains::*fields[] = {&PidGains::kp, &PidGains::ki, &PidGains::kd, &PidGains::d_tau};
+        for (float PidGains::*field : fields)
+        {
+            if (best.gains.*field <= 0.0f)
+                continue;
+            // the derivative filter has no effect without derivative action
+            if (field == &PidGains::d_tau && best.gains.kd <= 0.0f)
+                continue;
+            for (int dir = -1; dir <= 1; dir += 2)
+            {
+                Candidate c;
+                c.gains = best.gains;
+                c.gains.*field = best.gains.*field * (float)exp2(dir * step);
+                batch.push_back(c);
+            }
+        }
+
+        evaluate(model, base, batch, jobs);
+        history.insert(history.end(), batch.begin(), batch.end());
+
+        auto it = std::min_element(batch.begin(), batch.end(),
+                                   [](const Candidate &a, const Candidate &b) { return a.score < b.score; });
+        if (it != batch.end() && it->score < best.score)
+            best = *it;
+        else
+            step *= 0.5;
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<TipModelSet> models;
+    std::vector<float> kp_values = {5, 10, 20, 40, 80};
+    std::vector<float> ki_values = {0, 0.25f, 0.5f, 1, 2};
+    std::vector<float> kd_values = {0, 0.05f, 0.1f};
+    std::vector<float> d_tau_values = {0.25f};
+    int rounds = 20;
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    int top = 5;
+
+    Scenario scenario;
+    scenario.load = 0.1;
+    scenario.t_load = 12.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            usage();
+        const char *value = argv[++i];
+
+        bool ok = true;
+        if (arg == "--model")
+        {
+            TipModelSet set;
+            ok = parse_model(value, set);
+            models.push_back(set);
+        }
+        else if (arg == "--kp")
+            ok = parse_list(value, kp_values);
+        else if (arg == "--ki")
+            ok = parse_list(value, ki_values);
+        else if (arg == "--kd")
+            ok = parse_list(value, kd_values);
+        else if (arg == "--d_tau")
+            ok = parse_list(value, d_tau_values);
+        else if (arg == "--refine")
+            rounds = atoi(value);
+        else if (arg == "--ch")
+            scenario.channel = atoi(value);
+        else if (arg == "--sp")
+            scenario.setpoint = atof(value);
+        else if (arg == "--time")
+            scenario.time_s = atof(value);
+        else if (arg == "--load")
+            ok = sscanf(value, "%lf@%lf", &scenario.load, &scenario.t_load) == 2;
+        else if (arg == "--jobs")
+            jobs = atoi(value);
+        else if (arg == "--top")
+            top = atoi(value);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            fprintf(stderr, "invalid argument %s %s\n", arg.c_str(), value);
+            usage();
+        }
+    }
+
+    if (models.empty())
+        models.push_back({"default", TipModel()});
+    if (scenario.channel < 0 || scenario.channel > 3 || jobs < 1)
+        usage();
+
+    for (const TipModelSet &set : models)
+    {
+        std::vector<Candidate> candidates;
+        for (float kp : kp_values)
+            for (float ki : ki_values)
+                for (float kd : kd_values)
+                    for (float d_tau : d_tau_values)
+                    {
+                        Candidate c;
+                        c.gains = {kp, ki, kd, d_tau};
+                        candidates.push_back(c);
+                    }
+
+        evaluate(set.model, scenario, candidates, jobs);
+        auto by_score = [](const Candidate &a, const Candidate &b) { return a.score < b.score; };
+        Candidate best = *std::min_element(candidates.begin(), candidates.end(), by_score);
+        best = refine(set.model, scenario, best, rounds, jobs, candidates);
+
+        std::sort(candidates.begin(), candidates.end(), by_score);
+        printf("# model %s, %zu runs\n", set.name.c_str(), candidates.size());
+        for (int i = 0; i < top && i < (int)candidates.size(); i++)
+            print_candidate(candidates[i]);
+
+        const int ch = scenario.channel;
+        printf("%d:pid_kp:%.5f\n", ch, best.gains.kp);
+        printf("%d:pid_ki:%.5f\n", ch, best.gains.ki);
+        printf("%d:pid_kd:%.5f\n", ch, best.gains.kd);
+        printf("%d:pid_d_tau:%.5f\n", ch, best.gains.d_tau);
+    }
+    return 0;
+}
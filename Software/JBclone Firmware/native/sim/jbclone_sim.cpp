@@ -0,0 +1,152 @@
+/**
+ * @file jbclone_sim.cpp
+ * @brief closed loop simulation of one channel: heat-up, regulation and a load step.
+ *
+ * usage: jbclone_sim [options]
+ *   --ch N              channel, default 0
+ *   --sp C              setpoint, default 350
+ *   --time S            simulated time, default 20
+ *   --kp/--ki/--kd/--d_tau X   PID settings as sent to the station
+ *   --tip name=value    tip model parameter (see TipModel::set), repeatable
+ *   --load G@T          extra tip loss of G W/K from time T (e.g. 0.1@12)
+ *   --csv FILE          10ms record: t,tip_c,tc_c,measured_c,heater_on
+ *   --record FILE       station recording of the run, for jbclone_replay
+ *   --seed N            noise seed
+ *   --loop_us N         simulated duration of one loop() pass, default 20
+ *
+ * Prints the response figures of StepMetrics as key=value lines, then the CPU idle
+ * percentage of the last second of the run (idle.h).
+ */
+
+#include "scenario.h"
+#include "health.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static void usage()
+{
+    fprintf(stderr, "usage: jbclone_sim [--ch N] [--sp C] [--time S] [--kp X] [--ki X] [--kd X] [--d_tau X]\n"
+                    "                   [--tip name=value]... [--load G@T] [--csv FILE]\n"
+                    "                   [--record FILE] [--seed N] [--loop_us N]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    Scenario scenario;
+    const char *csv_path = nullptr;
+    const char *record_path = nullptr;
+    SimConfig config;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            usage();
+        const char *value = argv[++i];
+
+        if (arg == "--ch")
+            scenario.channel = atoi(value);
+        else if (arg == "--sp")
+            scenario.setpoint = atof(value);
+        else if (arg == "--time")
+            scenario.time_s = atof(value);
+        else if (arg == "--kp")
+            scenario.gains.kp = atof(value);
+        else if (arg == "--ki")
+            scenario.gains.ki = atof(value);
+        else if (arg == "--kd")
+            scenario.gains.kd = atof(value);
+        else if (arg == "--d_tau")
+            scenario.gains.d_tau = atof(value);
+        else if (arg == "--csv")
+            csv_path = value;
+        else if (arg == "--record")
+            record_path = value;
+        else if (arg == "--seed")
+            config.seed = atoi(value);
+        else if (arg == "--loop_us")
+            config.loop_period_us = atoi(value);
+        else if (arg == "--load")
+        {
+            if (sscanf(value, "%lf@%lf", &scenario.load, &scenario.t_load) != 2)
+                usage();
+        }
+        else if (arg == "--tip")
+        {
+            const char *eq = strchr(value, '=');
+            if (eq == nullptr)
+                usage();
+            std::string name(value, eq - value);
+            for (TipModel &tip : config.tips)
+            {
+                if (!tip.set(name.c_str(), atof(eq + 1)))
+                {
+                    fprintf(stderr, "unknown tip parameter %s\n", name.c_str());
+                    return 2;
+                }
+            }
+        }
+        else
+            usage();
+    }
+
+    if (scenario.channel < 0 || scenario.channel > 3)
+        usage();
+
+    FILE *csv = nullptr;
+    if (csv_path != nullptr)
+    {
+        csv = fopen(csv_path, "w");
+        if (csv == nullptr)
+        {
+            perror(csv_path);
+            return 1;
+        }
+    }
+
+    FILE *record = nullptr;
+    if (record_path != nullptr)
+    {
+        record = fopen(record_path, "w");
+        if (record == nullptr)
+        {
+            perror(record_path);
+            return 1;
+        }
+    }
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    StepMetrics m;
+    bool ok = run_scenario(config, scenario, m, csv, record);
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    if (csv != nullptr)
+        fclose(csv);
+    if (record != nullptr)
+        fclose(record);
+    if (!ok)
+    {
+        fprintf(stderr, "channel setup failed\n");
+        return 1;
+    }
+
+    printf("heatup_s=%.3f\n", m.heatup_s);
+    printf("rise_s=%.3f\n", m.rise_s);
+    printf("overshoot_c=%.2f\n", m.overshoot_c);
+    printf("settling_s=%.3f\n", m.settling_s);
+    printf("steady_error_c=%.3f\n", m.steady_error_c);
+    printf("steady_sd_c=%.3f\n", m.steady_sd_c);
+    printf("load_dip_c=%.2f\n", m.load_dip_c);
+    printf("load_recovery_s=%.3f\n", m.load_recovery_s);
+    printf("score=%.3f\n", m.score(scenario.time_s));
+    printf("idle_pct=%.1f\n", station_health.idle_permille / 10.0f);
+    printf("sim_s=%.1f wall_s=%.2f speedup=%.0f\n", scenario.time_s, wall_s, scenario.time_s / wall_s);
+    return 0;
+}
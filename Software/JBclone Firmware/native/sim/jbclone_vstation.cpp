@@ -0,0 +1,239 @@
+/**
+ * @file jbclone_vstation.cpp
+ * @brief virtual station: the simulated station served on a pseudo-terminal.
+ *
+ * usage: jbclone_vstation [options]
+ *   --count N           run N independent stations, one process and pty each
+ *   --link PATH         symlink to the pty, with --count the index is appended (PATH0, PATH1...)
+ *   --speed X           simulated time per wall time, default 1, 0 runs as fast as possible
+ *   --kp/--ki/--kd/--d_tau X   PID settings applied to every channel at start
+ *   --tip name=value    tip model parameter (see TipModel::set), repeatable
+ *   --seed N            noise seed, incremented per instance
+ *
+ * Bytes written to the pty reach the firmware USB port unchanged and the station output
+ * is written back, so the tuner and scripts connect to the pty path (or link) like to a
+ * real station. Every instance prints "vstation <index> <pty path>" once ready.
+ */
+
+#include "station_sim.h"
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/wait.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static volatile sig_atomic_t vstation_stop = 0;
+
+static void vstation_signal(int)
+{
+    vstation_stop = 1;
+}
+
+struct VStationOptions
+{
+    SimConfig config;
+    std::string link;
+    double speed = 1.0;
+    float kp = 20.0f, ki = 0.5f, kd = 0.0f, d_tau = 0.25f;
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: jbclone_vstation [--count N] [--link PATH] [--speed X] [--kp X] [--ki X] [--kd X]\n"
+                    "                        [--d_tau X] [--tip name=value]... [--seed N]\n");
+    exit(2);
+}
+
+/**
+ * @brief opens a pty master in raw mode, the slave side is kept open so the master
+ * survives clients closing and reopening the port.
+ */
+static int vstation_open_pty(std::string &slave_path, int &slave_fd)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+        return -1;
+
+    slave_path = ptsname(master);
+    slave_fd = open(slave_path.c_str(), O_RDWR | O_NOCTTY);
+    if (slave_fd < 0)
+        return -1;
+
+    struct termios tio;
+    tcgetattr(slave_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd, TCSANOW, &tio);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+static int vstation_run(int index, const VStationOptions &options)
+{
+    std::string slave_path;
+    int slave_fd;
+    int master = vstation_open_pty(slave_path, slave_fd);
+    if (master < 0)
+    {
+        perror("pty");
+        return 1;
+    }
+
+    std::string link;
+    if (!options.link.empty())
+    {
+        link = options.link + (index >= 0 ? std::to_string(index) : "");
+        unlink(link.c_str());
+        if (symlink(slave_path.c_str(), link.c_str()) != 0)
+        {
+            perror(link.c_str());
+            return 1;
+        }
+    }
+
+    SimConfig config = options.config;
+    config.seed += index < 0 ? 0 : index;
+    StationSim sim(config);
+    for (int ch = 0; ch < 4; ch++)
+        sim.setup_channel(ch, options.kp, options.ki, options.kd, options.d_tau);
+    sim.drain_usb();
+
+    printf("vstation %d %s\n", index < 0 ? 0 : index, link.empty() ? slave_path.c_str() : link.c_str());
+    fflush(stdout);
+
+    constexpr double slice_s = 0.001;
+    auto wall_start = std::chrono::steady_clock::now();
+    const double sim_start = sim.time();
+
+    while (!vstation_stop)
+    {
+        char buffer[256];
+        ssize_t n;
+        while ((n = read(master, buffer, sizeof(buffer))) > 0)
+            sim.usb_write(std::string(buffer, n));
+
+        sim.run(slice_s);
+
+        std::string out = sim.drain_usb();
+        size_t written = 0;
+        while (written < out.size() && !vstation_stop)
+        {
+            ssize_t w = write(master, out.data() + written, out.size() - written);
+            if (w > 0)
+                written += w;
+            else if (errno == EAGAIN)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            else
+                break;
+        }
+
+        if (options.speed > 0.0)
+        {
+            auto due = wall_start + std::chrono::duration<double>((sim.time() - sim_start) / options.speed);
+            std::this_thread::sleep_until(due);
+        }
+    }
+
+    if (!link.empty())
+        unlink(link.c_str());
+    close(slave_fd);
+    close(master);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    VStationOptions options;
+    int count = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            usage();
+        const char *value = argv[++i];
+
+        if (arg == "--count")
+            count = atoi(value);
+        else if (arg == "--link")
+            options.link = value;
+        else if (arg == "--speed")
+            options.speed = atof(value);
+        else if (arg == "--kp")
+            options.kp = atof(value);
+        else if (arg == "--ki")
+            options.ki = atof(value);
+        else if (arg == "--kd")
+            options.kd = atof(value);
+        else if (arg == "--d_tau")
+            options.d_tau = atof(value);
+        else if (arg == "--seed")
+            options.config.seed = atoi(value);
+        else if (arg == "--tip")
+        {
+            const char *eq = strchr(value, '=');
+            if (eq == nullptr)
+                usage();
+            std::string name(value, eq - value);
+            for (TipModel &tip : options.config.tips)
+            {
+                if (!tip.set(name.c_str(), atof(eq + 1)))
+                {
+                    fprintf(stderr, "unknown tip parameter %s\n", name.c_str());
+                    return 2;
+                }
+            }
+        }
+        else
+            usage();
+    }
+
+    if (count < 1)
+        usage();
+
+    struct sigaction action = {};
+    action.sa_handler = vstation_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    if (count == 1)
+        return vstation_run(-1, options);
+
+    // the firmware state is global, one process per station
+    std::vector<pid_t> children;
+    for (int i = 0; i < count; i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+            return vstation_run(i, options);
+        if (pid < 0)
+        {
+            perror("fork");
+            vstation_stop = 1;
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    int status = 0;
+    for (pid_t child : children)
+    {
+        if (vstation_stop)
+            kill(child, SIGTERM);
+        int child_status;
+        while (waitpid(child, &child_status, 0) < 0 && errno == EINTR)
+            kill(child, SIGTERM);
+        if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0)
+            status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,85 @@
+#include "scenario.h"
+#include "Hardware.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief runs the scenario on a fresh StationSim and computes the response figures.
+ *
+ * @param config The station and tip models.
+ * @param scenario The scenario.
+ * @param metrics The response figures of the tip temperature.
+ * @param csv Optional 10ms record: t,tip_c,tc_c,measured_c,heater_on.
+ * @param recording Optional station recording ("s:record") from the setpoint command on,
+ *               the USB output as the station sends it.
+ * @return false if the station rejected the channel setup.
+ */
+bool run_scenario(const SimConfig &config, const Scenario &scenario, StepMetrics &metrics, FILE *csv, FILE *recording)
+{
+    const int ch = scenario.channel;
+    const PidGains &g = scenario.gains;
+
+    StationSim sim(config);
+    if (!sim.setup_channel(ch, g.kp, g.ki, g.kd, g.d_tau))
+        return false;
+
+    // keeps the recording lines the station sent between and with the commands
+    auto command = [&](const std::string &line) {
+        if (recording != nullptr)
+            fputs(sim.drain_usb().c_str(), recording);
+        std::string response = sim.command(line);
+        if (recording != nullptr)
+            fprintf(recording, "%s\n", response.c_str());
+        // the reply is the last line that is not part of the recording
+        std::string reply;
+        size_t start = 0;
+        while (start <= response.size())
+        {
+            size_t end = response.find('\n', start);
+            std::string line = response.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            if (line.compare(0, 2, "R:") != 0 && line.compare(0, 3, "RC:") != 0)
+                reply = line;
+            if (end == std::string::npos)
+                break;
+            start = end + 1;
+        }
+        return reply;
+    };
+
+    if (recording != nullptr && command("s:record:start") != "OK")
+        return false;
+
+    const std::string id = std::to_string(ch) + ":";
+    if (command(id + "set_t:" + std::to_string(scenario.setpoint)) != "OK")
+        return false;
+
+    if (csv != nullptr)
+        fprintf(csv, "t,tip_c,tc_c,measured_c,heater_on\n");
+
+    const double t_enable = sim.time();
+    command(id + "en:1");
+    const double t_load = scenario.t_load >= 0.0 ? t_enable + scenario.t_load : -1.0;
+
+    std::vector<TempSample> record;
+    constexpr double record_period = 0.01;
+    while (sim.time() - t_enable < scenario.time_s)
+    {
+        if (t_load >= 0.0 && sim.time() >= t_load)
+            sim.set_load(ch, scenario.load);
+
+        sim.run(record_period);
+
+        TipPlant &plant = sim.plant(ch);
+        record.push_back({sim.time(), plant.tip_temp()});
+        if (csv != nullptr)
+            fprintf(csv, "%.3f,%.3f,%.3f,%.2f,%d\n", sim.time() - t_enable, plant.tip_temp(), plant.tc_temp(),
+                    sim.measured_temp(ch), plant.heater_on());
+    }
+
+    if (recording != nullptr)
+        command("s:record:stop");
+
+    metrics = step_metrics(record, scenario.setpoint, _regulation_band_temp, t_enable, t_load);
+    return true;
+}
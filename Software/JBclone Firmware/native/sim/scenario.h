@@ -0,0 +1,33 @@
+#ifndef __SIM_SCENARIO_H__
+#define __SIM_SCENARIO_H__
+
+#include <stdio.h>
+
+#include "station_sim.h"
+#include "step_metrics.h"
+
+struct PidGains
+{
+    float kp = 20.0f;
+    float ki = 0.5f;
+    float kd = 0.0f;
+    float d_tau = 0.25f;
+};
+
+/**
+ * @brief heat-up from ambient to a setpoint on one channel, with an optional load step.
+ */
+struct Scenario
+{
+    int channel = 0;
+    double setpoint = 350.0;
+    double time_s = 20.0;
+    double load = 0.0;     // W/K extra tip loss
+    double t_load = -1.0;  // s after enable, negative for none
+    PidGains gains;
+};
+
+bool run_scenario(const SimConfig &config, const Scenario &scenario, StepMetrics &metrics, FILE *csv = nullptr,
+                  FILE *recording = nullptr);
+
+#endif
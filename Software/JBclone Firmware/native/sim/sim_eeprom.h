@@ -0,0 +1,174 @@
+#ifndef __SIM_EEPROM_H__
+#define __SIM_EEPROM_H__
+
+#include <Wire.h>
+#include <random>
+#include <string.h>
+
+#include "arduino_host.h"
+#include "Hardware.h"
+
+enum SimEepromFault
+{
+    SIM_EEPROM_OK,
+    SIM_EEPROM_NACK,          // no acknowledge at all, device missing or bus stuck
+    SIM_EEPROM_WRITE_TIMEOUT, // takes the first write, then never ends the write cycle
+};
+
+/**
+ * @brief 24C16 model: 2KB in 8 blocks of 256 bytes, 16 byte pages, self timed write cycle.
+ *
+ * - the block (A10..A8) is in the device address bits, 0x50..0x57, the word address is
+ *   the first byte of a write
+ * - a write lands in the page buffer, bytes past the end of the page wrap to its start and
+ *   overwrite the first ones; the page is programmed on the stop condition only, a repeated
+ *   start aborts it (that is how a random read sets the address)
+ * - during the write cycle (write_cycle_us after the stop) the device NACKs its address,
+ *   the ACK polling of the driver sees the busy time
+ * - reads are sequential from the address counter, which rolls over at the end of the array
+ * - optional bit errors: a stored bit flips while programming, a read bit flips on the bus
+ *
+ * Counters of programmed pages, busy NACKs and per byte writes (endurance) let a host test
+ * check what a persistence scheme costs. Bus time is accounted by the TwoWire shim.
+ */
+class SimEeprom : public I2cDevice
+{
+public:
+    static constexpr size_t memory_size = 2048;
+    static constexpr size_t page_size = 16;
+
+private:
+    uint8_t _memory[memory_size];
+    uint32_t _cell_writes[memory_size];
+    uint16_t _pointer = 0;
+    uint64_t _busy_until_us = 0;
+    uint32_t _write_cycle_us = 5000; // tWR, datasheet maximum
+    SimEepromFault _fault = SIM_EEPROM_OK;
+
+    double _write_bit_error = 0.0; // per programmed bit
+    double _read_bit_error = 0.0;  // per bit read
+    std::mt19937 _rng;
+    std::uniform_real_distribution<double> _uniform{0.0, 1.0};
+
+    uint32_t _page_writes = 0;
+    uint32_t _busy_nacks = 0;
+    uint32_t _aborted_writes = 0;
+    uint32_t _bit_errors = 0;
+
+    bool busy() const
+    {
+        return _fault == SIM_EEPROM_WRITE_TIMEOUT ? _page_writes > 0 : host_clock_us() < _busy_until_us;
+    }
+
+    uint8_t corrupt(uint8_t value, double rate)
+    {
+        if (rate <= 0.0)
+            return value;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            if (_uniform(_rng) < rate)
+            {
+                value ^= 1 << bit;
+                _bit_errors++;
+            }
+        }
+        return value;
+    }
+
+public:
+    explicit SimEeprom(uint32_t seed = 1) : _rng(seed)
+    {
+        memset(_memory, 0xFF, sizeof(_memory));
+        memset(_cell_writes, 0, sizeof(_cell_writes));
+    }
+
+    // configuration
+    void set_write_cycle_us(uint32_t us) { _write_cycle_us = us; }
+    void set_bit_errors(double write_rate, double read_rate)
+    {
+        _write_bit_error = write_rate;
+        _read_bit_error = read_rate;
+    }
+    void set_fault(SimEepromFault fault)
+    {
+        _fault = fault;
+        _page_writes = 0;
+        _busy_until_us = 0;
+    }
+
+    // content, bypassing the bus
+    uint8_t peek(uint16_t address) const { return _memory[address % memory_size]; }
+    void poke(uint16_t address, uint8_t value) { _memory[address % memory_size] = value; }
+
+    // statistics
+    uint32_t page_writes() const { return _page_writes; }
+    uint32_t busy_nacks() const { return _busy_nacks; }
+    uint32_t aborted_writes() const { return _aborted_writes; }
+    uint32_t bit_errors() const { return _bit_errors; }
+    uint32_t cell_writes(uint16_t address) const { return _cell_writes[address % memory_size]; }
+    uint32_t max_cell_writes() const
+    {
+        uint32_t n = 0;
+        for (uint32_t w : _cell_writes)
+            n = w > n ? w : n;
+        return n;
+    }
+
+    bool i2c_address(uint8_t address, bool read) override
+    {
+        (void)read;
+        if ((address & 0xF8) != _address_eeprom || _fault == SIM_EEPROM_NACK)
+            return false;
+        if (busy())
+        {
+            _busy_nacks++;
+            return false;
+        }
+        return true;
+    }
+
+    bool i2c_write(uint8_t address, const uint8_t *data, size_t length, bool stop) override
+    {
+        if (length == 0)
+            return true; // address only, ACK polling
+
+        _pointer = ((address & 0x07) << 8) | data[0];
+        if (length == 1)
+            return true; // word address of a random read
+
+        if (!stop)
+        {
+            _aborted_writes++;
+            return true;
+        }
+
+        // page buffer, the address counter wraps inside the page
+        const uint16_t page = _pointer & ~(page_size - 1);
+        uint8_t offset = _pointer & (page_size - 1);
+        for (size_t i = 1; i < length; i++)
+        {
+            const uint16_t cell = page | offset;
+            _memory[cell] = corrupt(data[i], _write_bit_error);
+            _cell_writes[cell]++;
+            offset = (offset + 1) & (page_size - 1);
+        }
+        _pointer = page | offset;
+
+        _page_writes++;
+        _busy_until_us = host_clock_us() + _write_cycle_us;
+        return true;
+    }
+
+    size_t i2c_read(uint8_t address, uint8_t *data, size_t length) override
+    {
+        (void)address;
+        for (size_t i = 0; i < length; i++)
+        {
+            data[i] = corrupt(_memory[_pointer], _read_bit_error);
+            _pointer = (_pointer + 1) % memory_size;
+        }
+        return length;
+    }
+};
+
+#endif
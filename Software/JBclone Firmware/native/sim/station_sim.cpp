@@ -0,0 +1,226 @@
+#include "station_sim.h"
+
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "sim_eeprom.h"
+
+#include <string.h>
+
+// firmware entry points, src/main.cpp
+void setup();
+void loop();
+
+static const int sim_tc_pins[4] = {_board1_temp, _board2_temp, _board3_temp, _board4_temp};
+static const int sim_heater_pins[4] = {_board1_heater, _board2_heater, _board3_heater, _board4_heater};
+static const int sim_stand_pins[4] = {_board1_stand, _board2_stand, _board3_stand, _board4_stand};
+static const float sim_tc_gains[4] = {_board1_tc_gain, _board2_tc_gain, _board3_tc_gain, _board4_tc_gain};
+
+StationSim::StationSim(const SimConfig &config)
+    : _config(config), _eeprom(new SimEeprom())
+{
+    _half_cycle_us = (uint32_t)(500000.0f / _config.mains_hz);
+    for (int i = 0; i < 4; i++)
+        _plants.emplace_back(_config.tips[i], _config.seed * 4 + i);
+
+    host_reset();
+    i2cBus.host_detach_all();
+    i2cBus.host_attach(_eeprom.get());
+
+    host_on_analog_read([this](uint32_t pin) {
+        for (int i = 0; i < 4; i++)
+        {
+            if ((int)pin == sim_tc_pins[i])
+                return _adc_fault[i] >= 0 ? _adc_fault[i] : _plants[i].adc_code(sim_tc_gains[i], host_adc_bits(), ADC_VREF);
+        }
+        return 0;
+    });
+
+    host_on_digital_write([this](uint32_t pin, int level) {
+        for (int i = 0; i < 4; i++)
+        {
+            if ((int)pin == sim_heater_pins[i])
+                _plants[i].set_heater(level == HIGH);
+        }
+    });
+
+    // tips lifted from the stand
+    for (int pin : sim_stand_pins)
+        host_pin_drive(pin, HIGH);
+
+    setup();
+    _last_us = host_clock_us();
+    _next_zero_cross_us = _last_us + _half_cycle_us;
+
+    host_on_clock_advance([this](uint64_t from_us, uint64_t to_us) {
+        (void)from_us;
+        advance(to_us);
+    });
+}
+
+StationSim::~StationSim()
+{
+    i2cBus.host_detach_all();
+    host_reset();
+}
+
+/**
+ * @brief one loop period and one loop() pass.
+ */
+void StationSim::step()
+{
+    host_clock_advance_us(_config.loop_period_us);
+
+    loop();
+
+    // nobody listens to the display
+    Serial1.host_tx();
+}
+
+/**
+ * @brief plants in slices of at most one loop period.
+ */
+void StationSim::integrate(uint64_t to_us)
+{
+    while (_last_us < to_us)
+    {
+        uint64_t slice = to_us - _last_us;
+        if (slice > _config.loop_period_us)
+            slice = _config.loop_period_us;
+        for (TipPlant &plant : _plants)
+            plant.step(slice * 1e-6);
+        _last_us += slice;
+    }
+}
+
+/**
+ * @brief clock advance callback: plants and zero crosses up to the new time.
+ *
+ * Each due zero cross runs the ISR with the clock at the edge, also in the middle of a
+ * blocking firmware call (bus transfers, serial timeouts), as on the target.
+ */
+void StationSim::advance(uint64_t to_us)
+{
+    while (_next_zero_cross_us <= to_us)
+    {
+        const uint64_t edge_us = _next_zero_cross_us;
+        _next_zero_cross_us += _half_cycle_us;
+        integrate(edge_us);
+        if (!_zero_cross_enabled)
+            continue;
+
+        host_clock_set_us(edge_us);
+        host_trigger_interrupt(_pin_zero_cross);
+        host_clock_set_us(to_us);
+        _zero_crosses++;
+        for (int i = 0; i < 4; i++)
+            _conducting[i] += _plants[i].heater_on();
+    }
+    integrate(to_us);
+}
+
+/**
+ * @brief runs the station for the given simulated time.
+ */
+void StationSim::run(double seconds)
+{
+    uint64_t end = host_clock_us() + (uint64_t)(seconds * 1e6);
+    while (host_clock_us() < end)
+        step();
+}
+
+/**
+ * @brief true once the output holds a full line that is not a recording line ("R:", "RC:"...).
+ */
+static bool has_reply(const std::string &out)
+{
+    size_t start = 0;
+    size_t end;
+    while ((end = out.find(_serial_usb_terminator, start)) != std::string::npos)
+    {
+        const size_t colon = out.find(':', start);
+        const bool recording = out[start] == 'R' && colon != std::string::npos && colon <= start + 2 && colon < end;
+        if (!recording)
+            return true;
+        start = end + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief sends a command line on the USB port and returns what the station answered.
+ *
+ * Bulk dumps are returned whole, lines separated by the USB terminator.
+ */
+std::string StationSim::command(const std::string &line)
+{
+    drain_usb();
+    Serial.host_rx(line + _serial_usb_terminator);
+    while (Serial.host_rx_pending() > 0)
+        step();
+    step();
+
+    // the coroutine build replies after the EEPROM writes of the command
+    constexpr uint64_t reply_timeout_us = 2000000;
+    const uint64_t deadline_us = host_clock_us() + reply_timeout_us;
+    std::string out = drain_usb();
+    while (!has_reply(out) && host_clock_us() < deadline_us)
+    {
+        step();
+        out += drain_usb();
+    }
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r'))
+        out.pop_back();
+    return out;
+}
+
+/**
+ * @brief restores a channel to the plant tc sensitivity and power, then applies PID gains.
+ *
+ * @return false if any command failed.
+ */
+bool StationSim::setup_channel(int channel, float kp, float ki, float kd, float d_tau)
+{
+    const TipModel &model = _config.tips[channel];
+    const std::string id = std::to_string(channel) + ":";
+
+    bool ok = true;
+    ok &= command(id + "restore:" + std::to_string(model.tc_uv_per_c)) == "OK";
+    ok &= command(id + "heater_w:" + std::to_string(model.power_w)) == "OK";
+    ok &= command(id + "pid_kp:" + std::to_string(kp)) == "OK";
+    ok &= command(id + "pid_ki:" + std::to_string(ki)) == "OK";
+    ok &= command(id + "pid_kd:" + std::to_string(kd)) == "OK";
+    ok &= command(id + "pid_d_tau:" + std::to_string(d_tau)) == "OK";
+    return ok;
+}
+
+void StationSim::set_stand(int channel, bool on_stand)
+{
+    host_pin_drive(sim_stand_pins[channel], on_stand ? LOW : HIGH);
+}
+
+double StationSim::time() const
+{
+    return host_clock_us() * 1e-6;
+}
+
+/**
+ * @brief temperature last measured by the firmware on the channel.
+ */
+float StationSim::measured_temp(int channel) const
+{
+    return heaters[channel].get_temp_pv();
+}
+
+/**
+ * @brief raw bytes received on the USB port, no framing added.
+ */
+void StationSim::usb_write(const std::string &data)
+{
+    Serial.host_rx(data);
+}
+
+std::string StationSim::drain_usb()
+{
+    return Serial.host_tx();
+}
@@ -0,0 +1,81 @@
+#ifndef __SIM_STATION_SIM_H__
+#define __SIM_STATION_SIM_H__
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tip_plant.h"
+
+class SimEeprom;
+
+struct SimConfig
+{
+    TipModel tips[4];
+    float mains_hz = 50.0f;
+    uint32_t loop_period_us = 20; // simulated duration of one firmware loop() pass
+    uint32_t seed = 1;
+};
+
+/**
+ * @brief the firmware (setup(), loop(), zero_cross_isr()) closed around simulated tips.
+ *
+ * Runs on the shim simulated clock: every step advances time by the loop period and runs
+ * one loop() pass. Every advance of the clock, also inside blocking firmware calls,
+ * integrates the plants with the heater pin levels and fires the zero cross interrupt
+ * at the time of each due mains zero cross, as the target preempts the loop.
+ * The firmware state is global, so only one StationSim can exist per process;
+ * run parallel stations as separate processes.
+ *
+ * Faults are injected on the simulated hardware: a fixed ADC code on a channel (open or
+ * shorted thermocouple), missing zero cross edges, EEPROM faults, stand levels.
+ */
+class StationSim
+{
+private:
+    SimConfig _config;
+    std::vector<TipPlant> _plants;
+    std::unique_ptr<SimEeprom> _eeprom;
+    uint64_t _last_us = 0;
+    uint64_t _next_zero_cross_us = 0;
+    uint32_t _half_cycle_us;
+    uint64_t _zero_crosses = 0;
+    uint64_t _conducting[4] = {};
+    int _adc_fault[4] = {-1, -1, -1, -1};
+    bool _zero_cross_enabled = true;
+
+    void advance(uint64_t to_us);
+    void integrate(uint64_t to_us);
+    void step();
+
+public:
+    explicit StationSim(const SimConfig &config = SimConfig());
+    ~StationSim();
+    StationSim(const StationSim &) = delete;
+    StationSim &operator=(const StationSim &) = delete;
+
+    void run(double seconds);
+    std::string command(const std::string &line);
+    bool setup_channel(int channel, float kp, float ki, float kd, float d_tau);
+
+    void set_stand(int channel, bool on_stand);
+    void set_load(int channel, double conductance) { _plants[channel].set_load(conductance); }
+
+    double time() const;
+    TipPlant &plant(int channel) { return _plants[channel]; }
+    float measured_temp(int channel) const;
+    uint64_t zero_crosses() const { return _zero_crosses; }
+    uint64_t conducting_half_cycles(int channel) const { return _conducting[channel]; }
+    uint32_t half_cycle_us() const { return _half_cycle_us; }
+
+    // fault injection
+    void set_adc_fault(int channel, int code) { _adc_fault[channel] = code; } // negative clears
+    void set_zero_cross(bool enabled) { _zero_cross_enabled = enabled; }
+    SimEeprom &eeprom() { return *_eeprom; }
+
+    void usb_write(const std::string &data);
+    std::string drain_usb();
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "step_metrics.h"
+
+#include <math.h>
+
+/**
+ * @brief single figure of merit, lower is better.
+ *
+ * Missing events (band never reached, no recovery) cost the whole horizon.
+ *
+ * @param horizon_s The simulated time, used as penalty for missing events.
+ */
+double StepMetrics::score(double horizon_s) const
+{
+    double heatup = heatup_s < 0.0 ? horizon_s : heatup_s;
+    double settling = settling_s < 0.0 ? horizon_s : settling_s;
+    double recovery = load_recovery_s < 0.0 ? horizon_s : load_recovery_s;
+
+    return heatup + 0.5 * settling + recovery + 0.2 * overshoot_c + 0.1 * load_dip_c +
+           fabs(steady_error_c) + steady_sd_c;
+}
+
+/**
+ * @brief computes the response figures from a temperature record.
+ *
+ * @param samples The tip temperature record, in time order.
+ * @param setpoint The setpoint in C.
+ * @param band The half width of the regulation band in C.
+ * @param t_enable The time the channel was enabled.
+ * @param t_load The time the load step was applied, negative for none.
+ */
+StepMetrics step_metrics(const std::vector<TempSample> &samples, double setpoint, double band,
+                         double t_enable, double t_load)
+{
+    StepMetrics m;
+    if (samples.empty())
+        return m;
+
+    const double t_end_regulation = t_load >= 0.0 ? t_load : samples.back().t;
+
+    double start_temp = samples.front().temp_c;
+    for (const TempSample &s : samples)
+    {
+        if (s.t >= t_enable)
+        {
+            start_temp = s.temp_c;
+            break;
+        }
+    }
+    const double t10 = start_temp + 0.1 * (setpoint - start_temp);
+    const double t90 = start_temp + 0.9 * (setpoint - start_temp);
+
+    double t_rise10 = -1.0;
+    double t_rise90 = -1.0;
+    double last_exit = t_enable;
+    bool was_in_band = false;
+    double sum = 0.0, sum2 = 0.0;
+    int n = 0;
+
+    for (const TempSample &s : samples)
+    {
+        if (s.t < t_enable || s.t >= t_end_regulation)
+            continue;
+
+        const double error = setpoint - s.temp_c;
+        const bool in_band = fabs(error) <= band;
+
+        if (t_rise10 < 0.0 && s.temp_c >= t10)
+            t_rise10 = s.t;
+        if (t_rise90 < 0.0 && s.temp_c >= t90)
+            t_rise90 = s.t;
+        if (m.heatup_s < 0.0 && in_band)
+            m.heatup_s = s.t - t_enable;
+        if (was_in_band && !in_band)
+            last_exit = s.t;
+        was_in_band = in_band;
+
+        if (-error > m.overshoot_c)
+            m.overshoot_c = -error;
+
+        if (s.t >= t_end_regulation - 2.0)
+        {
+            sum += error;
+            sum2 += error * error;
+            n++;
+        }
+    }
+
+    if (t_rise10 >= 0.0 && t_rise90 >= 0.0)
+        m.rise_s = t_rise90 - t_rise10;
+    if (m.heatup_s >= 0.0 && was_in_band)
+        m.settling_s = (last_exit > t_enable + m.heatup_s ? last_exit : t_enable + m.heatup_s) - t_enable;
+    if (n > 0)
+    {
+        m.steady_error_c = sum / n;
+        m.steady_sd_c = sqrt(fmax(0.0, sum2 / n - m.steady_error_c * m.steady_error_c));
+    }
+
+    if (t_load < 0.0)
+        return m;
+
+    bool left_band = false;
+    for (const TempSample &s : samples)
+    {
+        if (s.t < t_load)
+            continue;
+
+        const double error = setpoint - s.temp_c;
+        if (error > m.load_dip_c)
+            m.load_dip_c = error;
+
+        if (error > band)
+            left_band = true;
+        else if (left_band)
+        {
+            m.load_recovery_s = s.t - t_load;
+            break;
+        }
+    }
+    if (!left_band)
+        m.load_recovery_s = 0.0;
+
+    return m;
+}
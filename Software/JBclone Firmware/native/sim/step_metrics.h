@@ -0,0 +1,35 @@
+#ifndef __SIM_STEP_METRICS_H__
+#define __SIM_STEP_METRICS_H__
+
+#include <vector>
+
+struct TempSample
+{
+    double t;      // s
+    double temp_c;
+};
+
+/**
+ * @brief closed loop response figures of a heat-up followed by an optional load step.
+ *
+ * Times are in seconds, temperatures in C. Figures that did not happen are negative
+ * (e.g. heatup_s = -1 when the band is never reached).
+ */
+struct StepMetrics
+{
+    double heatup_s = -1.0;       // enable to first entry in the band
+    double rise_s = -1.0;         // 10% to 90% of the step
+    double overshoot_c = 0.0;     // above setpoint, before the load step
+    double settling_s = -1.0;     // enable to the last exit from the band, before the load step
+    double steady_error_c = 0.0;  // mean SP - PV over the last 2s before the load step
+    double steady_sd_c = 0.0;
+    double load_dip_c = 0.0;      // largest drop below setpoint after the load step
+    double load_recovery_s = -1.0; // load step to back in the band, 0 if it never fell below
+
+    double score(double horizon_s) const;
+};
+
+StepMetrics step_metrics(const std::vector<TempSample> &samples, double setpoint, double band,
+                         double t_enable, double t_load);
+
+#endif
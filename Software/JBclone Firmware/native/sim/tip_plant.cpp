@@ -0,0 +1,111 @@
+#include "tip_plant.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief sets a model parameter by name, used by the command line tools.
+ *
+ * @return false if the name is unknown.
+ */
+bool TipModel::set(const char *name, float value)
+{
+    struct Field
+    {
+        const char *name;
+        float TipModel::*member;
+    };
+    static const Field fields[] = {
+        {"power_w", &TipModel::power_w},
+        {"c_heater", &TipModel::heater_heat_capacity},
+        {"c_tip", &TipModel::tip_heat_capacity},
+        {"coupling", &TipModel::coupling},
+        {"loss", &TipModel::loss},
+        {"ambient", &TipModel::ambient_c},
+        {"delay", &TipModel::transport_delay_s},
+        {"tc_uv", &TipModel::tc_uv_per_c},
+        {"cold_junction", &TipModel::cold_junction_c},
+        {"amp_sat_v", &TipModel::amp_saturation_v},
+        {"amp_tau_us", &TipModel::amp_recovery_tau_us},
+        {"noise", &TipModel::adc_noise_codes},
+    };
+
+    for (const Field &field : fields)
+    {
+        if (strcmp(field.name, name) == 0)
+        {
+            this->*field.member = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+TipPlant::TipPlant(const TipModel &model, uint32_t seed)
+    : _model(model), _heater_c(model.ambient_c), _tip_c(model.ambient_c), _rng(seed)
+{
+}
+
+/**
+ * @brief integrates the thermal nodes over dt_s, explicit Euler.
+ *
+ * StationSim calls it with the loop period (tens of us), far below the node time constants.
+ */
+void TipPlant::step(double dt_s)
+{
+    const double power = _heater_on ? _model.power_w : 0.0;
+    const double flow = _model.coupling * (_heater_c - _tip_c);
+    const double losses = (_model.loss + _load) * (_tip_c - _model.ambient_c);
+
+    _heater_c += (power - flow) / _model.heater_heat_capacity * dt_s;
+    _tip_c += (flow - losses) / _model.tip_heat_capacity * dt_s;
+    _time_s += dt_s;
+    if (!_heater_on)
+        _off_time_s += dt_s;
+
+    _delay_line.emplace_back(_time_s, _tip_c);
+    while (_delay_line.size() > 1 && _delay_line[1].first <= _time_s - _model.transport_delay_s)
+        _delay_line.pop_front();
+}
+
+void TipPlant::set_heater(bool on)
+{
+    if (_heater_on && !on)
+        _off_time_s = 0.0;
+    _heater_on = on;
+}
+
+/**
+ * @brief temperature at the thermocouple junction, delayed tip temperature.
+ */
+double TipPlant::tc_temp() const
+{
+    return _delay_line.empty() ? _tip_c : _delay_line.front().second;
+}
+
+/**
+ * @brief ADC conversion of the amplified thermocouple voltage.
+ *
+ * While the heater conducts the amplifier sits at amp_saturation_v, after switch-off it
+ * recovers exponentially to the thermocouple voltage.
+ *
+ * @param amp_gain The TC amplifier gain of the channel.
+ * @param adc_bits The ADC resolution.
+ * @param adc_vref The ADC reference voltage.
+ */
+int TipPlant::adc_code(float amp_gain, int adc_bits, float adc_vref)
+{
+    const double tc_v = _model.tc_uv_per_c * (tc_temp() - _model.cold_junction_c) * 1e-6 * amp_gain;
+
+    double v = _model.amp_saturation_v;
+    if (!_heater_on)
+    {
+        double settle = exp(-_off_time_s * 1e6 / _model.amp_recovery_tau_us);
+        v = tc_v + (_model.amp_saturation_v - tc_v) * settle;
+    }
+
+    const int full_scale = 1 << adc_bits;
+    double code = v / adc_vref * full_scale + _noise(_rng) * _model.adc_noise_codes;
+    code = code < 0.0 ? 0.0 : code;
+    return code > full_scale - 1 ? full_scale - 1 : (int)lround(code);
+}
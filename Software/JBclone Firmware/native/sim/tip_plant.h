@@ -0,0 +1,65 @@
+#ifndef __SIM_TIP_PLANT_H__
+#define __SIM_TIP_PLANT_H__
+
+#include <stdint.h>
+#include <deque>
+#include <random>
+
+/**
+ * @brief thermal and measurement parameters of one cartridge.
+ *
+ * Two lumped thermal nodes: the heater element, heated by the burst fired power, and the
+ * tip, coupled to the heater and losing heat to ambient and to an optional load.
+ * The thermocouple sees the tip temperature after a transport delay.
+ */
+struct TipModel
+{
+    float power_w = 100.0f;               // heater power during a conducting half-cycle
+    float heater_heat_capacity = 0.3f;    // J/K
+    float tip_heat_capacity = 0.7f;       // J/K
+    float coupling = 2.0f;                // W/K heater to tip
+    float loss = 0.03f;                   // W/K tip to ambient
+    float ambient_c = 25.0f;
+    float transport_delay_s = 0.02f;      // tip to thermocouple junction
+    float tc_uv_per_c = 20.0f;            // thermocouple sensitivity
+    float cold_junction_c = 0.0f;         // 0 matches the firmware calibration table origin
+    float amp_saturation_v = 3.3f;        // TC amplifier output while the heater conducts
+    float amp_recovery_tau_us = 300.0f;   // amplifier recovery after switch-off
+    float adc_noise_codes = 1.5f;         // gaussian, rms
+
+    bool set(const char *name, float value);
+};
+
+/**
+ * @brief simulated cartridge, integrated by StationSim in simulated time.
+ */
+class TipPlant
+{
+private:
+    TipModel _model;
+    double _heater_c;
+    double _tip_c;
+    double _load = 0.0;     // W/K extra tip loss
+    double _time_s = 0.0;
+    double _off_time_s = 1.0; // since the last switch-off
+    bool _heater_on = false;
+    std::deque<std::pair<double, double>> _delay_line; // (time, tip temperature)
+    std::mt19937 _rng;
+    std::normal_distribution<float> _noise{0.0f, 1.0f};
+
+public:
+    TipPlant(const TipModel &model = TipModel(), uint32_t seed = 1);
+
+    void step(double dt_s);
+    void set_heater(bool on);
+    void set_load(double conductance) { _load = conductance; }
+
+    int adc_code(float amp_gain, int adc_bits, float adc_vref);
+    double tip_temp() const { return _tip_c; }
+    double heater_temp() const { return _heater_c; }
+    double tc_temp() const;
+    bool heater_on() const { return _heater_on; }
+    const TipModel &model() const { return _model; }
+};
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * @file jbclone_sysid.cpp
+ * @brief process model identification from a step test record and PID gains from it.
+ *
+ * usage: jbclone_sysid [options] FILE
+ *   FILE            "s:steptest:dump" output (P:t_us,pv lines and the state=...,duty=x line)
+ *                   or a CSV with a header row, "-" reads stdin
+ *   --t/--pv/--op   CSV column names for time (s), PV (C) and duty (0-1), default t,pv,op
+ *   --duty X        constant duty from t = 0, for records without a duty column
+ *   --order 1|2     FOPDT (default) or SOPDT model
+ *   --ch N          channel the output commands are for, default 0
+ *   --tc_uv X       thermocouple uV per C of the cal table, default 21
+ *   --tau_c S       closed loop time constant, default the fitted dead time
+ *
+ * The fit minimizes a Huber loss of the simulated model output, so ADC spikes and amplifier
+ * recovery glitches do not pull the estimate. Gains are converted to the firmware PID units:
+ * the error is normalized to the TC input full scale (ADC_VREF / tc gain), the output is duty.
+ */
+
+#include "process_model.h"
+
+#include "Hardware.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <math.h>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+struct Options
+{
+    std::string file;
+    std::string t_column = "t";
+    std::string pv_column = "pv";
+    std::string op_column = "op";
+    double duty = NAN;
+    int order = 1;
+    int ch = 0;
+    double tc_uv = 21.0;
+    double tau_c = NAN;
+};
+
+struct Record
+{
+    std::vector<double> t, u, y;
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: jbclone_sysid [--t NAME] [--pv NAME] [--op NAME] [--duty X] [--order 1|2] [--ch N]\n"
+                    "                     [--tc_uv X] [--tau_c S] FILE\n");
+    exit(2);
+}
+
+static std::vector<std::string> split(const std::string &line, char separator)
+{
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, separator))
+    {
+        field.erase(0, field.find_first_not_of(" \t\r"));
+        field.erase(field.find_last_not_of(" \t\r") + 1);
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+/**
+ * @brief reads a step test dump or a CSV file.
+ *
+ * Step test samples are timestamped from the start of the test, a t = 0 point at the first
+ * PV is added so the step lines up with the model input.
+ */
+static bool read_record(std::istream &in, const Options &opt, Record &record)
+{
+    std::string line;
+    std::vector<std::string> header;
+    int t_index = -1, pv_index = -1, op_index = -1;
+    double dump_duty = NAN;
+    bool dump = false;
+
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        if (line.compare(0, 2, "P:") == 0)
+        {
+            double t_us, pv;
+            if (sscanf(line.c_str() + 2, "%lf,%lf", &t_us, &pv) != 2)
+                return false;
+            record.t.push_back(t_us * 1e-6);
+            record.y.push_back(pv);
+            dump = true;
+            continue;
+        }
+        size_t duty_pos = line.find("duty=");
+        if (line.compare(0, 6, "state=") == 0 && duty_pos != std::string::npos)
+        {
+            dump_duty = atof(line.c_str() + duty_pos + 5);
+            continue;
+        }
+        if (dump)
+            continue;
+
+        std::vector<std::string> fields = split(line, ',');
+        if (header.empty())
+        {
+            header = fields;
+            for (size_t i = 0; i < header.size(); i++)
+            {
+                if (header[i] == opt.t_column)
+                    t_index = i;
+                if (header[i] == opt.pv_column)
+                    pv_index = i;
+                if (header[i] == opt.op_column)
+                    op_index = i;
+            }
+            if (t_index < 0 || pv_index < 0)
+            {
+                fprintf(stderr, "columns %s and %s not found\n", opt.t_column.c_str(), opt.pv_column.c_str());
+                return false;
+            }
+            continue;
+        }
+
+        if ((int)fields.size() <= std::max(std::max(t_index, pv_index), op_index))
+            continue;
+        record.t.push_back(atof(fields[t_index].c_str()));
+        record.y.push_back(atof(fields[pv_index].c_str()));
+        record.u.push_back(op_index >= 0 ? atof(fields[op_index].c_str()) : opt.duty);
+    }
+
+    if (dump)
+    {
+        double duty = !isnan(opt.duty) ? opt.duty : dump_duty;
+        if (isnan(duty) || record.t.empty())
+            return false;
+        record.t.insert(record.t.begin(), 0.0);
+        record.y.insert(record.y.begin(), record.y.front());
+        record.u.assign(record.t.size(), duty);
+    }
+
+    for (double u : record.u)
+        if (isnan(u))
+        {
+            fprintf(stderr, "no duty, add --op or --duty\n");
+            return false;
+        }
+    return record.t.size() >= 10;
+}
+
+static void print_model(const char *name, const ProcessModel &m, const FitQuality &q)
+{
+    printf("%s: gain=%.2f C/duty tau1=%.3f s", name, m.gain, m.tau1);
+    if (m.tau2 > 0.0)
+        printf(" tau2=%.3f s", m.tau2);
+    printf(" dead_time=%.3f s y0=%.1f C rmse=%.3f C r2=%.5f fit=%.2f%% sigma=%.3f C outliers=%zu\n", m.dead_time,
+           m.y0, q.rmse, q.r2, q.fit, q.sigma, q.outliers);
+}
+
+static void print_gains(const char *name, int ch, double kc, double ti, double td)
+{
+    double ki = ti > 0.0 ? kc / ti : 0.0;
+    double kd = kc * td;
+    printf("# %s: Kc=%.3f Ti=%.3f s Td=%.3f s\n", name, kc, ti, td);
+    printf("%d:pid_kp:%.5f\n", ch, kc);
+    printf("%d:pid_ki:%.5f\n", ch, ki);
+    printf("%d:pid_kd:%.5f\n", ch, kd);
+    // derivative filter at a tenth of Td, the firmware default without derivative action
+    printf("%d:pid_d_tau:%.5f\n", ch, td > 0.0 ? td / 10.0 : 0.25);
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0 || arg == "-")
+        {
+            if (!opt.file.empty())
+                usage();
+            opt.file = arg;
+            continue;
+        }
+        if (i + 1 >= argc)
+            usage();
+        const char *value = argv[++i];
+
+        if (arg == "--t")
+            opt.t_column = value;
+        else if (arg == "--pv")
+            opt.pv_column = value;
+        else if (arg == "--op")
+            opt.op_column = value;
+        else if (arg == "--duty")
+            opt.duty = atof(value);
+        else if (arg == "--order")
+            opt.order = atoi(value);
+        else if (arg == "--ch")
+            opt.ch = atoi(value);
+        else if (arg == "--tc_uv")
+            opt.tc_uv = atof(value);
+        else if (arg == "--tau_c")
+            opt.tau_c = atof(value);
+        else
+        {
+            fprintf(stderr, "invalid argument %s\n", arg.c_str());
+            usage();
+        }
+    }
+    if (opt.file.empty() || opt.order < 1 || opt.order > 2 || opt.ch < 0 || opt.ch > 3 || opt.tc_uv <= 0.0)
+        usage();
+
+    Record raw;
+    bool ok;
+    if (opt.file == "-")
+        ok = read_record(std::cin, opt, raw);
+    else
+    {
+        std::ifstream file(opt.file);
+        if (!file)
+        {
+            perror(opt.file.c_str());
+            return 1;
+        }
+        ok = read_record(file, opt, raw);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "%s: no usable record\n", opt.file.c_str());
+        return 1;
+    }
+
+    ResponseRecord record = resample(raw.t, raw.u, raw.y);
+    if (record.size() < 10)
+    {
+        fprintf(stderr, "record too short\n");
+        return 1;
+    }
+    printf("# %zu samples, resampled to %zu at dt=%.4f s\n", raw.t.size(), record.size(), record.dt);
+
+    ProcessModel model = fit_fopdt(record);
+    print_model("fopdt", model, fit_quality(record, model));
+    if (opt.order == 2)
+    {
+        model = fit_sopdt(record, model);
+        print_model("sopdt", model, fit_quality(record, model));
+    }
+    if (model.gain <= 0.0)
+    {
+        fprintf(stderr, "no positive process gain, nothing to tune\n");
+        return 1;
+    }
+
+    // process gain in firmware units: normalized error per unit duty
+    const float tc_gains[] = {_board1_tc_gain, _board2_tc_gain, _board3_tc_gain, _board4_tc_gain};
+    const double full_scale_uv = ADC_VREF * 1e6 / tc_gains[opt.ch];
+    const double kn = model.gain * opt.tc_uv / full_scale_uv;
+    const double theta = model.dead_time;
+    const double tau_c = isnan(opt.tau_c) ? std::max(theta, record.dt) : opt.tau_c;
+    printf("# normalized gain %.4f /duty (full scale %.0f uV), tau_c=%.3f s\n", kn, full_scale_uv, tau_c);
+
+    // SIMC (Skogestad): PI on the dominant lag, series PID when the second lag is fitted
+    {
+        double kc = model.tau1 / (kn * (tau_c + theta));
+        double ti = std::min(model.tau1, 4.0 * (tau_c + theta));
+        double td = model.tau2;
+        // series to parallel form
+        double f = 1.0 + td / ti;
+        print_gains(td > 0.0 ? "SIMC PID" : "SIMC PI", opt.ch, kc * f, ti * f, td / f);
+    }
+
+    // IMC PID (Rivera), first order Pade dead time, on the lumped FOPDT
+    {
+        double tau = model.tau1 + model.tau2;
+        double kc = (tau + theta / 2.0) / (kn * (tau_c + theta / 2.0));
+        double ti = tau + theta / 2.0;
+        double td = tau * theta / (2.0 * tau + theta);
+        print_gains("IMC PID", opt.ch, kc, ti, td);
+    }
+    return 0;
+}
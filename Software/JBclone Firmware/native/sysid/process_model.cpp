@@ -0,0 +1,342 @@
+#include "process_model.h"
+
+#include <algorithm>
+#include <functional>
+#include <math.h>
+
+/**
+ * @brief model output for the record input, exact ZOH discretization of each lag.
+ *
+ * The dead time is applied on the input with linear interpolation between samples.
+ */
+std::vector<double> ProcessModel::simulate(const ResponseRecord &record) const
+{
+    const size_t n = record.size();
+    std::vector<double> out(n, y0);
+    if (n == 0)
+        return out;
+
+    const double a1 = exp(-record.dt / tau1);
+    const double a2 = tau2 > 0.0 ? exp(-record.dt / tau2) : 0.0;
+    const double delay = dead_time / record.dt;
+
+    double x1 = 0.0; // first lag state, C above y0
+    double x2 = 0.0; // second lag state
+    for (size_t k = 1; k < n; k++)
+    {
+        // input applied over [k-1, k], delayed
+        double pos = (double)(k - 1) - delay;
+        double u = 0.0;
+        if (pos >= 0.0)
+        {
+            size_t i = (size_t)pos;
+            double frac = pos - i;
+            u = i + 1 < n ? record.u[i] * (1.0 - frac) + record.u[i + 1] * frac : record.u[n - 1];
+        }
+
+        x1 = a1 * x1 + (1.0 - a1) * gain * u;
+        x2 = tau2 > 0.0 ? a2 * x2 + (1.0 - a2) * x1 : x1;
+        out[k] = y0 + x2;
+    }
+    return out;
+}
+
+/**
+ * @brief resamples a record on a uniform grid at the median sample interval.
+ *
+ * The input is held (zero order), the PV is interpolated linearly.
+ */
+ResponseRecord resample(const std::vector<double> &t, const std::vector<double> &u, const std::vector<double> &y)
+{
+    ResponseRecord record;
+    if (t.size() < 3)
+        return record;
+
+    std::vector<double> intervals;
+    for (size_t i = 1; i < t.size(); i++)
+        intervals.push_back(t[i] - t[i - 1]);
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    record.dt = intervals[intervals.size() / 2];
+    if (record.dt <= 0.0)
+        return record;
+
+    size_t j = 0;
+    for (double time = t.front(); time <= t.back(); time += record.dt)
+    {
+        while (j + 2 < t.size() && t[j + 1] <= time)
+            j++;
+        double span = t[j + 1] - t[j];
+        double frac = span > 0.0 ? (time - t[j]) / span : 0.0;
+        frac = std::min(1.0, std::max(0.0, frac));
+        record.y.push_back(y[j] + (y[j + 1] - y[j]) * frac);
+        record.u.push_back(time >= t[j + 1] ? u[j + 1] : u[j]);
+    }
+    return record;
+}
+
+static double median(std::vector<double> v)
+{
+    if (v.empty())
+        return 0.0;
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+/**
+ * @brief robust residual scale, 1.4826 * median absolute deviation.
+ */
+static double robust_sigma(const std::vector<double> &residuals)
+{
+    std::vector<double> abs_dev;
+    double m = median(residuals);
+    for (double r : residuals)
+        abs_dev.push_back(fabs(r - m));
+    return 1.4826 * median(abs_dev);
+}
+
+static std::vector<double> residuals(const ResponseRecord &record, const ProcessModel &model)
+{
+    std::vector<double> sim = model.simulate(record);
+    std::vector<double> r(record.size());
+    for (size_t k = 0; k < record.size(); k++)
+        r[k] = record.y[k] - sim[k];
+    return r;
+}
+
+/**
+ * @brief Huber loss of the simulation residuals, quadratic within delta, linear beyond.
+ */
+static double huber_loss(const ResponseRecord &record, const ProcessModel &model, double delta)
+{
+    double loss = 0.0;
+    for (double r : residuals(record, model))
+    {
+        double a = fabs(r);
+        loss += a <= delta ? 0.5 * r * r : delta * (a - 0.5 * delta);
+    }
+    return loss;
+}
+
+/**
+ * @brief Nelder-Mead minimization, used on log-parameters.
+ */
+static std::vector<double> nelder_mead(const std::function<double(const std::vector<double> &)> &f,
+                                       std::vector<double> start, double step, int iterations)
+{
+    const size_t n = start.size();
+    std::vector<std::vector<double>> simplex(n + 1, start);
+    for (size_t i = 0; i < n; i++)
+        simplex[i + 1][i] += step;
+
+    std::vector<double> values(n + 1);
+    for (size_t i = 0; i <= n; i++)
+        values[i] = f(simplex[i]);
+
+    for (int it = 0; it < iterations; it++)
+    {
+        std::vector<size_t> order(n + 1);
+        for (size_t i = 0; i <= n; i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return values[a] < values[b]; });
+
+        const size_t best = order[0], worst = order[n], second = order[n - 1];
+        if (fabs(values[worst] - values[best]) <= 1e-10 * (fabs(values[best]) + 1e-12))
+            break;
+
+        std::vector<double> centroid(n, 0.0);
+        for (size_t i = 0; i <= n; i++)
+            if (i != worst)
+                for (size_t d = 0; d < n; d++)
+                    centroid[d] += simplex[i][d] / n;
+
+        auto along = [&](double factor) {
+            std::vector<double> p(n);
+            for (size_t d = 0; d < n; d++)
+                p[d] = centroid[d] + factor * (simplex[worst][d] - centroid[d]);
+            return p;
+        };
+
+        std::vector<double> reflected = along(-1.0);
+        double fr = f(reflected);
+        if (fr < values[best])
+        {
+            std::vector<double> expanded = along(-2.0);
+            double fe = f(expanded);
+            if (fe < fr)
+                simplex[worst] = expanded, values[worst] = fe;
+            else
+                simplex[worst] = reflected, values[worst] = fr;
+        }
+        else if (fr < values[second])
+            simplex[worst] = reflected, values[worst] = fr;
+        else
+        {
+            std::vector<double> contracted = along(0.5);
+            double fc = f(contracted);
+            if (fc < values[worst])
+                simplex[worst] = contracted, values[worst] = fc;
+            else
+            {
+                for (size_t i = 0; i <= n; i++)
+                {
+                    if (i == best)
+                        continue;
+                    for (size_t d = 0; d < n; d++)
+                        simplex[i][d] = simplex[best][d] + 0.5 * (simplex[i][d] - simplex[best][d]);
+                    values[i] = f(simplex[i]);
+                }
+            }
+        }
+    }
+
+    size_t best = std::min_element(values.begin(), values.end()) - values.begin();
+    return simplex[best];
+}
+
+/**
+ * @brief minimizes the Huber loss of the simulation error over the model parameters.
+ *
+ * The Huber threshold is 1.345 robust sigma of the starting model residuals.
+ */
+static ProcessModel refine(const ResponseRecord &record, ProcessModel model, bool second_order)
+{
+    double delta = 1.345 * std::max(robust_sigma(residuals(record, model)), 1e-3);
+
+    // log parameters keep gain and time constants positive, the dead time is offset by one sample
+    auto unpack = [&](const std::vector<double> &p) {
+        ProcessModel m = model;
+        m.gain = exp(p[0]);
+        m.tau1 = exp(p[1]);
+        m.dead_time = exp(p[2]) - record.dt;
+        if (m.dead_time < 0.0)
+            m.dead_time = 0.0;
+        if (second_order)
+            m.tau2 = exp(p[3]);
+        return m;
+    };
+
+    std::vector<double> start = {log(fabs(model.gain) + 1e-9), log(model.tau1), log(model.dead_time + record.dt)};
+    if (second_order)
+        start.push_back(log(std::max(model.tau2, record.dt)));
+
+    auto cost = [&](const std::vector<double> &p) { return huber_loss(record, unpack(p), delta); };
+    for (int restart = 0; restart < 3; restart++)
+        start = nelder_mead(cost, start, 0.3, 2000);
+    return unpack(start);
+}
+
+/**
+ * @brief first order plus dead time fit.
+ *
+ * For every candidate dead time a discrete ARX model dy = a (y - y0) + b u(k - d) is solved
+ * by reweighted (Huber) least squares; the candidate with the smallest simulation error
+ * seeds a Nelder-Mead refinement of the Huber loss on the simulated output.
+ */
+ProcessModel fit_fopdt(const ResponseRecord &record)
+{
+    ProcessModel best;
+    best.y0 = record.y.empty() ? 0.0 : record.y[0];
+    double best_loss = INFINITY;
+    const size_t n = record.size();
+    if (n < 10)
+        return best;
+
+    for (size_t d = 0; d < n / 3; d++)
+    {
+        double a = 0.0, b = 0.0;
+        std::vector<double> w(n, 1.0);
+        for (int pass = 0; pass < 4; pass++)
+        {
+            // 2x2 weighted normal equations
+            double s11 = 0, s12 = 0, s22 = 0, r1 = 0, r2 = 0;
+            for (size_t k = d; k + 1 < n; k++)
+            {
+                double x1 = record.y[k] - best.y0;
+                double x2 = record.u[k - d];
+                double dy = record.y[k + 1] - record.y[k];
+                s11 += w[k] * x1 * x1;
+                s12 += w[k] * x1 * x2;
+                s22 += w[k] * x2 * x2;
+                r1 += w[k] * x1 * dy;
+                r2 += w[k] * x2 * dy;
+            }
+            double det = s11 * s22 - s12 * s12;
+            if (fabs(det) < 1e-12)
+                break;
+            a = (r1 * s22 - r2 * s12) / det;
+            b = (s11 * r2 - s12 * r1) / det;
+
+            std::vector<double> r;
+            for (size_t k = d; k + 1 < n; k++)
+                r.push_back(record.y[k + 1] - record.y[k] - a * (record.y[k] - best.y0) - b * record.u[k - d]);
+            double delta = 1.345 * std::max(robust_sigma(r), 1e-6);
+            for (size_t k = d; k + 1 < n; k++)
+            {
+                double abs_r = fabs(r[k - d]);
+                w[k] = abs_r <= delta ? 1.0 : delta / abs_r;
+            }
+        }
+
+        if (a >= 0.0 || a <= -1.0 || b == 0.0)
+            continue;
+
+        ProcessModel candidate;
+        candidate.y0 = best.y0;
+        candidate.tau1 = -record.dt / log(1.0 + a);
+        candidate.gain = -b / a;
+        candidate.dead_time = d * record.dt;
+
+        std::vector<double> r = residuals(record, candidate);
+        double loss = 0.0;
+        for (double v : r)
+            loss += v * v;
+        if (loss < best_loss)
+        {
+            best_loss = loss;
+            best = candidate;
+        }
+    }
+
+    return refine(record, best, false);
+}
+
+/**
+ * @brief second order plus dead time fit seeded from the FOPDT fit.
+ *
+ * The FOPDT time constant is split 4:1 and part of the dead time handed to the second lag.
+ */
+ProcessModel fit_sopdt(const ResponseRecord &record, const ProcessModel &fopdt)
+{
+    ProcessModel seed = fopdt;
+    seed.tau1 = 0.8 * fopdt.tau1;
+    seed.tau2 = std::max(0.2 * fopdt.tau1, record.dt);
+    seed.dead_time = 0.5 * fopdt.dead_time;
+    return refine(record, seed, true);
+}
+
+FitQuality fit_quality(const ResponseRecord &record, const ProcessModel &model)
+{
+    FitQuality q;
+    std::vector<double> r = residuals(record, model);
+    if (r.empty())
+        return q;
+
+    double mean = 0.0;
+    for (double y : record.y)
+        mean += y / record.size();
+
+    double sse = 0.0, sst = 0.0;
+    for (size_t k = 0; k < r.size(); k++)
+    {
+        sse += r[k] * r[k];
+        sst += (record.y[k] - mean) * (record.y[k] - mean);
+    }
+
+    q.rmse = sqrt(sse / r.size());
+    q.r2 = sst > 0.0 ? 1.0 - sse / sst : 0.0;
+    q.fit = sst > 0.0 ? 100.0 * (1.0 - sqrt(sse) / sqrt(sst)) : 0.0;
+    q.sigma = robust_sigma(r);
+    for (double v : r)
+        q.outliers += fabs(v) > 3.0 * std::max(q.sigma, 1e-9);
+    return q;
+}
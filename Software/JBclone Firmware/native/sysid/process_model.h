@@ -0,0 +1,51 @@
+#ifndef __SYSID_PROCESS_MODEL_H__
+#define __SYSID_PROCESS_MODEL_H__
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * @brief uniformly resampled step response record.
+ *
+ * u is the output duty (0-1), held from t[k] to t[k+1]; y is the PV in C.
+ */
+struct ResponseRecord
+{
+    double dt = 0.0;
+    std::vector<double> u;
+    std::vector<double> y;
+
+    size_t size() const { return y.size(); }
+};
+
+/**
+ * @brief first (tau2 = 0) or second order plus dead time model around the initial PV.
+ *
+ * y = y0 + gain / ((tau1 s + 1)(tau2 s + 1)) * exp(-dead_time s) * u
+ */
+struct ProcessModel
+{
+    double gain = 0.0;      // C per unit duty
+    double tau1 = 1.0;      // s
+    double tau2 = 0.0;      // s, 0 for FOPDT
+    double dead_time = 0.0; // s
+    double y0 = 0.0;        // C
+
+    std::vector<double> simulate(const ResponseRecord &record) const;
+};
+
+struct FitQuality
+{
+    double rmse = 0.0;     // C
+    double r2 = 0.0;
+    double fit = 0.0;      // NRMSE fit, percent
+    size_t outliers = 0;   // residuals beyond 3 robust sigma
+    double sigma = 0.0;    // robust residual scale (MAD), C
+};
+
+ResponseRecord resample(const std::vector<double> &t, const std::vector<double> &u, const std::vector<double> &y);
+ProcessModel fit_fopdt(const ResponseRecord &record);
+ProcessModel fit_sopdt(const ResponseRecord &record, const ProcessModel &fopdt);
+FitQuality fit_quality(const ResponseRecord &record, const ProcessModel &model);
+
+#endif
@@ -0,0 +1,475 @@
+/**
+ * @file jbclone_unit.cpp
+ * @brief unit checks of the parsers, the thermocouple conversion, the PID step, the
+ * command routing, the control tick bound, the zero cross period capture and the recorder
+ * command lines, against the firmware build of the host tools.
+ *
+ * usage: jbclone_unit
+ *
+ * The heaters run from a snapshot with the control tick stopped, a PID step is one
+ * control_update() on an ADC code chosen by the check. Commands go to eval_serial_command().
+ *
+ * Exits with 1 if a check failed.
+ */
+
+#include "arduino_host.h"
+#include "Hardware.h"
+#include "objects.h"
+#include "health.h"
+#include "control.h"
+#include "zc_timing.h"
+#include "parser.h"
+#include "recorder.h"
+#include "sim_eeprom.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// firmware entry points, src/main.cpp and src/Serial_controls.h
+void setup();
+bool eval_serial_command(const String message, String &response);
+
+static int failures = 0;
+
+static void check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+static bool near(float a, float b, float tolerance)
+{
+    return fabsf(a - b) <= tolerance;
+}
+
+// type K, uV at 0..450C in 50C steps, curved enough to catch a wrong segment
+static const float type_k_table[10][2] = {
+    {0.0f, 0.0f}, {2023.0f, 50.0f}, {4096.0f, 100.0f}, {6138.0f, 150.0f}, {8138.0f, 200.0f},
+    {10153.0f, 250.0f}, {12209.0f, 300.0f}, {14293.0f, 350.0f}, {16397.0f, 400.0f}, {18516.0f, 450.0f},
+};
+
+static void parser_checks()
+{
+    struct FloatCase
+    {
+        const char *text;
+        bool ok;
+        float value;
+    };
+    static const FloatCase floats[] = {
+        {"0", true, 0.0f},
+        {"42", true, 42.0f},
+        {"-1.5", true, -1.5f},
+        {"+2.25", true, 2.25f},
+        {".5", true, 0.5f},
+        {"5.", true, 5.0f},
+        {"-0", true, 0.0f},
+        {"1234567890", true, 1234567890.0f},
+        {"0.1234567890", true, 0.123456789f},
+        {"", false, 0.0f},
+        {"-", false, 0.0f},
+        {"+", false, 0.0f},
+        {".", false, 0.0f},
+        {"-.", false, 0.0f},
+        {"--1", false, 0.0f},
+        {"+-1", false, 0.0f},
+        {"1.2.3", false, 0.0f},
+        {"1e6", false, 0.0f},
+        {" 1", false, 0.0f},
+        {"1 ", false, 0.0f},
+        {"0x10", false, 0.0f},
+        {"12345678901", false, 0.0f},
+        {"0.12345678901", false, 0.0f},
+        {"nan", false, 0.0f},
+    };
+
+    for (const FloatCase &c : floats)
+    {
+        float value = -99.0f;
+        const bool ok = parseFloat(String(c.text), value);
+        char what[64];
+        snprintf(what, sizeof(what), "parseFloat(\"%s\")", c.text);
+        check(ok == c.ok, what);
+        if (ok && c.ok)
+            check(near(value, c.value, fabsf(c.value) * 1e-6f), what);
+    }
+
+    struct BoolCase
+    {
+        const char *text;
+        bool ok;
+        bool value;
+    };
+    static const BoolCase bools[] = {
+        {"1", true, true}, {"0", true, false}, {"", false, false}, {"2", false, false},
+        {"10", false, false}, {"01", false, false}, {" 1", false, false}, {"true", false, false},
+    };
+
+    for (const BoolCase &c : bools)
+    {
+        String text(c.text);
+        bool value = !c.value;
+        const bool ok = parseBool(text, value);
+        char what[64];
+        snprintf(what, sizeof(what), "parseBool(\"%s\")", c.text);
+        check(ok == c.ok, what);
+        if (ok)
+            check(value == c.value, what);
+        else
+            check(value == !c.value, "parseBool leaves the result alone on failure");
+    }
+}
+
+/**
+ * @brief channel 0 from its current snapshot with a changed calibration table.
+ */
+static void load_table(const float table[10][2])
+{
+    Heater::Snapshot snapshot;
+    heaters[0].snapshot_save(snapshot);
+    memcpy(snapshot.tc_cal_table, table, sizeof(snapshot.tc_cal_table));
+    heaters[0].snapshot_load(snapshot);
+}
+
+static void conversion_checks()
+{
+    Heater &heater = heaters[0];
+    Heater::Snapshot original;
+    heater.snapshot_save(original);
+    load_table(type_k_table);
+
+    // the table points themselves
+    bool points = true;
+    for (const auto &row : type_k_table)
+        points &= near(heater.tcv_to_temp(row[0]), row[1], 1e-3f) && near(heater.temp_to_tcv(row[1]), row[0], 1e-2f);
+    check(points, "conversion at the table points");
+
+    // round trip inside the table and along the extrapolated end segments
+    bool round_trip = true;
+    for (float temp = -50.0f; temp <= 550.0f; temp += 2.5f)
+        round_trip &= near(heater.tcv_to_temp(heater.temp_to_tcv(temp)), temp, 1e-2f);
+    check(round_trip, "temp_to_tcv/tcv_to_temp round trip -50..550C");
+
+    // monotonic across segment boundaries
+    bool monotonic = true;
+    for (float uv = -1000.0f; uv < 20000.0f; uv += 10.0f)
+        monotonic &= heater.tcv_to_temp(uv + 10.0f) > heater.tcv_to_temp(uv);
+    check(monotonic, "tcv_to_temp monotonic");
+
+    // outside the table the end segments continue, no clamp to the end points
+    const float slope_low = (50.0f - 0.0f) / (2023.0f - 0.0f);
+    const float slope_high = (450.0f - 400.0f) / (18516.0f - 16397.0f);
+    check(near(heater.tcv_to_temp(-500.0f), -500.0f * slope_low, 1e-3f), "tcv_to_temp extrapolates below the table");
+    check(near(heater.tcv_to_temp(20000.0f), 450.0f + (20000.0f - 18516.0f) * slope_high, 1e-3f),
+          "tcv_to_temp extrapolates above the table");
+
+    // the setpoint range clamps what the conversion is asked for
+    String response;
+    check(eval_serial_command("0:set_min_t:100", response), "set_min_t");
+    check(eval_serial_command("0:set_max_t:400", response), "set_max_t");
+    check(!eval_serial_command("0:set_t:401", response) && response == "out of bounds", "set_t above the range");
+    check(!eval_serial_command("0:set_t:99.9", response) && response == "out of bounds", "set_t below the range");
+    check(eval_serial_command("0:set_t:400", response) && response == "OK", "set_t at the range end");
+    check(eval_serial_command("0:set_uv:?", response) && near(response.toFloat(), 16397.0f, 1.0f), "set_t converts to uV");
+    check(eval_serial_command("0:set_max_t:320", response), "set_max_t below the setpoint");
+    check(eval_serial_command("0:set_t:?", response) && response == "320.00", "setpoint clamped to the new range");
+    const String above_hardware(heater.tcv_to_temp(original.tc_max_voltage_setpoint) + 1.0f, 1);
+    check(!eval_serial_command("0:set_max_t:" + above_hardware, response) &&
+              response == "temperature exceeds hardware capability",
+          "set_max_t above the amplifier range");
+
+    // a table that does not convert leaves the setpoint alone
+    float flat[10][2];
+    memcpy(flat, type_k_table, sizeof(flat));
+    for (auto &row : flat)
+        row[1] = 200.0f;
+    load_table(flat);
+    check(!eval_serial_command("0:set_t:250", response) && response == "invalid calibration table",
+          "set_t with a broken table");
+    check(eval_serial_command("0:set_t:?", response) && response == "320.00", "setpoint kept with a broken table");
+
+    heater.snapshot_load(original);
+}
+
+struct PidCase
+{
+    float kp, ki, kd, tau;
+    float integral;      // integral state before the step
+    float prev_error;    // derivative state before the step
+    float prev_output;   // output before the step, anti-windup
+    float sp_uv;
+    int adc_code;
+    uint32_t dt_us;
+};
+
+/**
+ * @brief one PID step of channel 0 from a known state, returns the output.
+ */
+static float pid_step(const PidCase &c, Heater::Snapshot &after)
+{
+    static int adc_code = 0;
+    adc_code = c.adc_code;
+    host_on_analog_read([](uint32_t) { return adc_code; });
+
+    Heater::Snapshot snapshot;
+    heaters[0].snapshot_save(snapshot);
+    snapshot.state = HEATER_REGULATING;
+    snapshot.fault = FAULT_NONE;
+    snapshot.temp_runaway_threshold = 1000.0f;
+    snapshot.tc_max_voltage_setpoint = 20000.0f;
+    snapshot.pid_kp = c.kp;
+    snapshot.pid_ki = c.ki;
+    snapshot.pid_kd = c.kd;
+    snapshot.pid_derivative_filter_tau = c.tau;
+    snapshot.pid_integral = c.integral;
+    snapshot.pid_derivative_prev_e_t = c.prev_error;
+    snapshot.pid_output = c.prev_output;
+    snapshot.pid_TCvoltage_sp = c.sp_uv;
+    snapshot.heating_check_active = 0;
+
+    // the sample window opened past the amplifier recovery, the last sample dt_us ago
+    const uint32_t now = micros();
+    snapshot.sample_scheduled = 1;
+    snapshot.sample_schedule_timestamp = now - _tc_amp_recovery_time - 1;
+    snapshot.pv_old_timestamp = now - 2 * c.dt_us;
+    snapshot.pv_timestamp = now - c.dt_us;
+    snapshot.pid_update_pending = 0;
+    heaters[0].snapshot_load(snapshot);
+
+    heaters[0].control_update();
+    heaters[0].snapshot_save(after);
+    return after.pid_output;
+}
+
+static void pid_checks()
+{
+    const float span = 20000.0f;
+
+    Heater::Snapshot state;
+    heaters[0].snapshot_save(state);
+    const float tc_gain = state.tc_gain;
+    auto uv_of = [tc_gain](int code) { return (code / ADC_RES) * ADC_VREF / tc_gain * 1e6f; };
+
+    // P only, inside the output range
+    {
+        const PidCase c = {2.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 10000.0f, 1000, 20000};
+        Heater::Snapshot after;
+        const float out = pid_step(c, after);
+        const float error = (c.sp_uv - uv_of(c.adc_code)) / span;
+        check(near(after.pid_TCvoltage_pv, uv_of(c.adc_code), 1e-2f), "PID sample converts the ADC code to uV");
+        check(near(out, c.kp * error, 1e-5f), "PID P step");
+    }
+
+    // P saturates at both ends
+    {
+        const PidCase high = {100.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 18000.0f, 10, 20000};
+        const PidCase low = {100.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 100.0f, 2000, 20000};
+        Heater::Snapshot after;
+        check(pid_step(high, after) == 1.0f, "PID output clamped to 1");
+        check(pid_step(low, after) == 0.0f, "PID output clamped to 0");
+    }
+
+    // I from zero: integral += error * dt, no anti-windup correction while unsaturated
+    {
+        const PidCase c = {0.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 12000.0f, 1000, 20000};
+        Heater::Snapshot after;
+        const float out = pid_step(c, after);
+        const float error = (c.sp_uv - uv_of(c.adc_code)) / span;
+        check(near(after.pid_integral, error * 0.02f, 1e-6f), "PID integral step");
+        check(near(out, c.ki * error * 0.02f, 1e-6f), "PID I output");
+    }
+
+    // I back calculation: the saturated last output pulls the integral back
+    {
+        const PidCase c = {0.0f, 5.0f, 0.0f, 0.0f, 0.1f, 0.0f, 0.2f, 12000.0f, 1000, 20000};
+        Heater::Snapshot after;
+        pid_step(c, after);
+        const float error = (c.sp_uv - uv_of(c.adc_code)) / span;
+        const float expected = c.integral + (error + (c.prev_output - c.ki * c.integral)) * 0.02f;
+        check(near(after.pid_integral, expected, 1e-6f), "PID anti-windup back calculation");
+    }
+
+    // I clamp: the integral never holds more than the full output
+    {
+        const PidCase c = {0.0f, 5.0f, 0.0f, 0.0f, 0.199f, 0.0f, 1.0f, 20000.0f, 0, 1000000};
+        Heater::Snapshot after;
+        check(pid_step(c, after) == 1.0f && near(after.pid_integral, 1.0f / c.ki, 1e-6f), "PID integral clamp");
+    }
+
+    // D unfiltered and filtered, on the error
+    {
+        const PidCase c = {0.0f, 0.0f, 0.01f, 0.0f, 0.0f, 0.1f, 0.0f, 12000.0f, 1000, 20000};
+        Heater::Snapshot after;
+        const float out = pid_step(c, after);
+        const float error = (c.sp_uv - uv_of(c.adc_code)) / span;
+        check(near(out, constrain(c.kd * (error - c.prev_error) / 0.02f, 0.0f, 1.0f), 1e-5f), "PID D step");
+        check(near(after.pid_derivative_prev_e_t, error, 1e-6f), "PID D keeps the error");
+
+        const PidCase f = {0.0f, 0.0f, 0.01f, 0.06f, 0.0f, 0.1f, 0.0f, 12000.0f, 1000, 20000};
+        const float alpha = 0.02f / (f.tau + 0.02f);
+        const float filtered = alpha * error + (1.0f - alpha) * f.prev_error;
+        const float out_f = pid_step(f, after);
+        check(near(out_f, constrain(f.kd * (filtered - f.prev_error) / 0.02f, 0.0f, 1.0f), 1e-5f), "PID filtered D step");
+        check(near(after.pid_derivative_prev_e_t, filtered, 1e-6f), "PID filtered D keeps the filtered error");
+    }
+
+    // a NAN setpoint turns the heater off instead of propagating
+    {
+        const PidCase c = {2.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, NAN, 1000, 20000};
+        Heater::Snapshot after;
+        check(pid_step(c, after) == 0.0f, "PID output off on a NAN setpoint");
+    }
+
+    // a sample less than 1ms after the last one is skipped
+    {
+        const PidCase c = {2.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.3f, 10000.0f, 1000, 500};
+        Heater::Snapshot after;
+        check(pid_step(c, after) == 0.3f, "PID step skipped below 1ms");
+    }
+
+    host_on_analog_read(nullptr);
+}
+
+static void command_checks()
+{
+    String response;
+    const uint32_t parse_errors = station_health.serial_parse_errors;
+
+    struct ErrorCase
+    {
+        const char *message;
+        const char *response;
+    };
+    static const ErrorCase errors[] = {
+        {"", "Malformed command. Format: id:command:value_or_?"},
+        {"0", "Malformed command. Format: id:command:value_or_?"},
+        {"0:set_t", "Malformed command. Format: id:command:value_or_?"},
+        {"0:nope:?", "Unknown command"},
+        {"0::?", "Unknown command"},
+        {"s:nope:?", "Unknown command"},
+        {"s:set_t:?", "Unknown command"},
+        {"4:set_t:?", "Invalid device ID"},
+        {"12:set_t:?", "Invalid device ID"},
+        {"-1:set_t:?", "Invalid device ID"},
+        {"x:set_t:?", "Invalid device ID"},
+        {":set_t:?", "Invalid device ID"},
+    };
+    for (const ErrorCase &c : errors)
+    {
+        response = "";
+        const bool ok = eval_serial_command(c.message, response);
+        char what[64];
+        snprintf(what, sizeof(what), "reply to \"%s\"", c.message);
+        check(!ok && response == c.response, what);
+    }
+    const size_t error_count = sizeof(errors) / sizeof(errors[0]);
+    check(station_health.serial_parse_errors - parse_errors == error_count, "parse errors counted");
+
+    // handler errors are not parse errors
+    check(!eval_serial_command("0:set_t:abc", response) && response == "invalid float value", "set_t invalid value");
+    check(!eval_serial_command("0:pid_kp:-1", response) && response == "invalid kp", "pid_kp negative");
+    check(!eval_serial_command("s:idle:bogus", response) && response == "invalid value", "station handler error");
+    check(station_health.serial_parse_errors - parse_errors == error_count, "handler errors not counted as parse errors");
+
+    // the id selects the channel, the value after the second ':' is passed whole
+    check(eval_serial_command("1:pid_kp:3.5", response) && response == "OK", "pid_kp set on channel 1");
+    check(eval_serial_command("1:pid_kp:?", response) && response == "3.50000", "pid_kp read on channel 1");
+    check(eval_serial_command("0:pid_kp:?", response) && response != "3.50000", "channel 0 unchanged");
+    check(eval_serial_command("2:tc_cal_table:3", response) && response.startsWith("["), "value with no ':' passed");
+    check(!eval_serial_command("0:tc_cal_table:1[2:3]", response), "value with ':' passed to the handler");
+
+    // station commands
+    check(eval_serial_command("s:idle:?", response) && response.startsWith("idle_pct="), "station command routed");
+    check(eval_serial_command("s:health:?", response) && response.length() > 0, "s:health");
+}
+
+static void control_bound_checks()
+{
+    uint32_t arrivals;
+
+    // one edge per mains half cycle, a tick far shorter than that sees one ISR
+    check(control_response_bound_ns(100000, 5000, 10000000, arrivals) == 105000 && arrivals == 1,
+          "tick bound with one zero cross ISR");
+
+    // edges 50us apart: R = 100 + ceil(R / 50) * 5 settles at 115us with 3 ISRs
+    check(control_response_bound_ns(100000, 5000, 50000, arrivals) == 115000 && arrivals == 3,
+          "tick bound iterated over close edges");
+
+    // edges closer than the ISR time, the tick never completes within its period
+    check(control_response_bound_ns(100000, 5000, 4000, arrivals) > _control_tick_us * 1000,
+          "tick bound past the period on an edge storm");
+
+    // no ISR measured yet
+    check(control_response_bound_ns(100000, 0, 10000000, arrivals) == 100000, "tick bound without ISR time");
+}
+
+static void zc_timing_checks()
+{
+    String response;
+    check(eval_serial_command("s:zc:clear", response), "s:zc:clear");
+
+    // 10ms half cycles, then two missed edges: 30ms is past the 21.8ms capture range and
+    // wraps to 8.2ms
+    const uint32_t intervals_us[] = {10000, 10000, 30000, 10000};
+    zc_timing_isr_enter();
+    zc_timing_isr_exit();
+    for (uint32_t interval_us : intervals_us)
+    {
+        host_clock_advance_us(interval_us);
+        zc_timing_isr_enter();
+        zc_timing_isr_exit();
+    }
+
+    check(zc_timing_period_min_ns() == 10000000, "zero cross period_min ignores a wrapped capture");
+    check(eval_serial_command("s:zc:?", response) && response.indexOf(";gap=1;") >= 0, "zero cross gap counted");
+    check(eval_serial_command("s:zc:clear", response), "s:zc:clear");
+}
+
+static void recorder_checks()
+{
+    String response;
+    check(eval_serial_command("s:record:start", response) && response == "OK", "s:record:start");
+    Serial.host_tx();
+
+    // RC: lines wait for record_update(), a line that does not fit is dropped whole
+    record_command(0, "0:pid_kp:?");
+    record_command(1, String(std::string(record_text_size, 'x')));
+    check(Serial.host_tx().empty(), "command line written before record_update()");
+    record_update(Serial);
+    const std::string lines = Serial.host_tx();
+    check(lines.compare(0, 3, "RC:") == 0 && lines.find(",0,0:pid_kp:?\n") != std::string::npos &&
+              lines.find("xxx") == std::string::npos,
+          "command lines sent by record_update()");
+    check(eval_serial_command("s:record:?", response) && response.endsWith(",dropped=1"), "command line too long dropped");
+
+    check(eval_serial_command("s:record:stop", response) && response == "OK", "s:record:stop");
+    Serial.host_tx();
+}
+
+int main()
+{
+    host_reset();
+    SimEeprom *memory = new SimEeprom(1);
+    memory->set_write_cycle_us(0);
+    i2cBus.host_detach_all();
+    i2cBus.host_attach(memory);
+    setup();
+    host_timers_enable(false);
+    host_clock_advance_us(1000000);
+    Serial.host_tx();
+
+    parser_checks();
+    conversion_checks();
+    pid_checks();
+    command_checks();
+    control_bound_checks();
+    zc_timing_checks();
+    recorder_checks();
+
+    printf("%d checks failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+#ifndef STM32_FREERTOS_CONFIG_H
+#define STM32_FREERTOS_CONFIG_H
+
+/**
+ * @file STM32FreeRTOSConfig.h
+ * @brief kernel configuration of the RTOS build (env:rtos), STM32F103 at 72MHz.
+ *
+ * Picked up by the STM32duino FreeRTOS library in place of its default configuration.
+ * The control tick (TIM4) and the zero cross interrupts are above
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY: kernel critical sections never delay them, and
+ * they do not call the kernel. Run time statistics count microseconds.
+ *
+ * The kernel allocates from the newlib heap (heap_useNewlib_ST), the one String uses:
+ * the library's __malloc_lock()/__malloc_unlock() suspend the scheduler, so the comms and
+ * HMI tasks build their Strings without corrupting the heap. The task stacks come from
+ * this heap at run time, past the linker's RAM check; tasks.h checks the RAM budget.
+ * Newlib reentrancy is off: of the newlib state only malloc is shared, under its lock.
+ */
+
+#include <stdint.h>
+extern uint32_t SystemCoreClock;
+extern uint32_t rtos_run_time_us(void);
+
+#define configUSE_PREEMPTION 1
+#define configUSE_IDLE_HOOK 0 // loop() is not run, the tasks do its work
+#define configUSE_TICK_HOOK 0
+#define configCPU_CLOCK_HZ (SystemCoreClock)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configMAX_PRIORITIES 5
+#define configMINIMAL_STACK_SIZE ((uint16_t)128)
+#define configMAX_TASK_NAME_LEN 8
+#define configUSE_16_BIT_TICKS 0
+#define configIDLE_SHOULD_YIELD 1
+#define configUSE_MUTEXES 1
+#define configUSE_RECURSIVE_MUTEXES 1
+#define configUSE_COUNTING_SEMAPHORES 0
+#define configUSE_TASK_NOTIFICATIONS 1
+#define configQUEUE_REGISTRY_SIZE 0
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configCHECK_FOR_STACK_OVERFLOW 0
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configSUPPORT_STATIC_ALLOCATION 0
+#define configMEMMANG_HEAP_NB -1        // heap_useNewlib_ST, malloc with scheduler locks
+#define configISR_STACK_SIZE_WORDS 128 // main stack kept for the interrupts, the heap stops below
+#define configUSE_NEWLIB_REENTRANT 0
+#define configUSE_CMSIS_RTOS_V2 0
+#define configUSE_TIMERS 0
+#define configUSE_CO_ROUTINES 0
+
+// task statistics, s:rtos:?
+#define configUSE_TRACE_FACILITY 1
+#define configGENERATE_RUN_TIME_STATS 1
+#define configUSE_STATS_FORMATTING_FUNCTIONS 0
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() rtos_run_time_us()
+
+#define INCLUDE_vTaskPrioritySet 0
+#define INCLUDE_uxTaskPriorityGet 0
+#define INCLUDE_vTaskDelete 0
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_vTaskDelayUntil 1
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTaskGetIdleTaskHandle 1 // idle time, see idle.h
+#define INCLUDE_xSemaphoreGetMutexHolder 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+
+// Cortex-M3, 4 priority bits, lower number is higher priority
+#ifdef __NVIC_PRIO_BITS
+#define configPRIO_BITS __NVIC_PRIO_BITS
+#else
+#define configPRIO_BITS 4
+#endif
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY 15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 11 // above _control_tick_irq_priority
+#define configKERNEL_INTERRUPT_PRIORITY (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+#define configASSERT(x)           \
+    if ((x) == 0)                 \
+    {                             \
+        taskDISABLE_INTERRUPTS(); \
+        for (;;)                  \
+            ;                     \
+    }
+
+#define vPortSVCHandler SVC_Handler
+#define xPortPendSVHandler PendSV_Handler
+// SysTick is shared with the HAL tick, the library calls xPortSysTickHandler
+
+#endif
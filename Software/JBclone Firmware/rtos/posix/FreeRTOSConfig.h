@@ -0,0 +1,62 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/**
+ * @file FreeRTOSConfig.h
+ * @brief kernel configuration of the host RTOS build (JBCLONE_RTOS_POSIX), POSIX port.
+ *
+ * Same task set and kernel features as rtos/STM32FreeRTOSConfig.h, host sized stacks and
+ * heap. Run time statistics count microseconds of the host monotonic clock.
+ */
+
+#include <stdint.h>
+extern uint32_t rtos_run_time_us(void);
+
+#define configUSE_PREEMPTION 1
+#define configUSE_IDLE_HOOK 0
+#define configUSE_TICK_HOOK 0
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configMAX_PRIORITIES 6 // the host interrupt task above the firmware tasks
+#define configMINIMAL_STACK_SIZE ((unsigned short)4096) // words, at least PTHREAD_STACK_MIN
+#define configTOTAL_HEAP_SIZE ((size_t)(1024 * 1024))
+#define configMAX_TASK_NAME_LEN 8
+#define configUSE_16_BIT_TICKS 0
+#define configIDLE_SHOULD_YIELD 1
+#define configUSE_MUTEXES 1
+#define configUSE_RECURSIVE_MUTEXES 1
+#define configUSE_COUNTING_SEMAPHORES 0
+#define configUSE_TASK_NOTIFICATIONS 1
+#define configQUEUE_REGISTRY_SIZE 0
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configCHECK_FOR_STACK_OVERFLOW 0
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configSUPPORT_STATIC_ALLOCATION 0
+#define configUSE_TIMERS 0
+#define configUSE_CO_ROUTINES 0
+
+// task statistics, s:rtos:?
+#define configUSE_TRACE_FACILITY 1
+#define configGENERATE_RUN_TIME_STATS 1
+#define configUSE_STATS_FORMATTING_FUNCTIONS 0
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() rtos_run_time_us()
+
+#define INCLUDE_vTaskPrioritySet 0
+#define INCLUDE_uxTaskPriorityGet 0
+#define INCLUDE_vTaskDelete 0
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_vTaskDelayUntil 1
+#define INCLUDE_xTaskDelayUntil 1
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTaskGetIdleTaskHandle 1 // idle time, see idle.h
+#define INCLUDE_xSemaphoreGetMutexHolder 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+
+#define configASSERT(x) \
+    if ((x) == 0)       \
+        vAssertCalled(__FILE__, __LINE__)
+extern void vAssertCalled(const char *file, unsigned long line);
+
+#endif
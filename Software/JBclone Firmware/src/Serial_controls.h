@@ -1,79 +1,148 @@
-#ifndef _SERIAL_CONTROLS_H_
-#define _SERIAL_CONTROLS_H_
-
-#include <Arduino.h>
-#include "objects.h"
-#include "Heater.h"
-
-/**
- * @brief Evaluates and executes a serial command addressed to a heater device.
- *
- * This function parses a colon-separated serial command string in the format:
- *     "id:command:value"
- *
- * - `id` must be a single-digit heater index (e.g., 0–9).
- * - `command` is matched against entries in the command table.
- * - `value` is the value to pass to the command function as text.
- *
- * If the command is valid, the corresponding Heater method is called.
- *
- * @param message        Null-terminated command string from serial input.
- * @param response       Optional output buffer for a response string.
- * @param responseSize   Size of the response buffer (in bytes).
- *
- * @return true if the command was successfully parsed and executed,
- *         false if the command was malformed, unknown, or failed to execute.
- */
-bool eval_serial_command(const String message, String& response)
-{
-
-    // Find the first ':' separator (between ID and command)
-    int c1 = message.indexOf(':');
-
-    // Find the second ':' separator (between command and value)
-    int c2 = message.indexOf(':', c1 + 1);
-
-    // If either separator is missing, report malformed command
-    if (c1 == -1 || c2 == -1)
-    {
-        response = "Malformed command. Format: id:command:value_or_?";
-        return false;
-    }
-
-    // Parse device ID (only valid for single-digit IDs)
-    int id = -1;
-    if (isdigit(message[0]))
-    {
-        id = message[0] - '0';
-    }
-
-    // Validate heater index
-    if (id < 0 || id >= (int)(sizeof(heaters) / sizeof(heaters[0])))
-    {
-        response = "Invalid device ID";
-        return false;
-    }
-
-    // Extract command and value parts
-    String command = message.substring(c1 + 1, c2);
-    String target_cmd = message.substring(c2 + 1);
-
-    // Resolve the target heater object
-    Heater& target = heaters[id];
-
-    // Look for the command in the command table
-    for (int i = 0; i < commandTableSize; ++i)
-    {
-        if (command == commandTable[i].name)
-        {
-            return (target.*(commandTable[i].func))(target_cmd, response);
-        }
-    }
-
-    // Command not recognized
-    response = "Unknown command";
-    return false;
-}
-
-
+#ifndef _SERIAL_CONTROLS_H_
+#define _SERIAL_CONTROLS_H_
+
+#include <Arduino.h>
+#include "objects.h"
+#include "Heater.h"
+#include "Hardware.h"
+#include "health.h"
+#include "control.h"
+#include "trace.h"
+#include "recorder.h"
+
+/**
+ * @brief Evaluates and executes a serial command addressed to a heater device.
+ *
+ * This function parses a colon-separated serial command string in the format:
+ *     "id:command:value"
+ *
+ * - `id` must be a single-digit heater index (e.g., 0–9), or `_station_command_id`
+ *   for station wide commands looked up in the station command table.
+ * - `command` is matched against entries in the command table.
+ * - `value` is the value to pass to the command function as text.
+ *
+ * If the command is valid, the corresponding Heater method is called.
+ * The control tick is masked while the command runs. An EEPROM save lets it run again, so do
+ * the station handlers while they write bulk output to the USB port (trace, scope, steptest
+ * and record), which a slow host could otherwise stretch without bound.
+ *
+ * @param message        Null-terminated command string from serial input.
+ * @param response       Optional output buffer for a response string.
+ * @param responseSize   Size of the response buffer (in bytes).
+ *
+ * @return true if the command was successfully parsed and executed,
+ *         false if the command was malformed, unknown, or failed to execute.
+ */
+bool eval_serial_command(const String message, String& response)
+{
+    ControlLock lock;
+
+    // Find the first ':' separator (between ID and command)
+    int c1 = message.indexOf(':');
+
+    // Find the second ':' separator (between command and value)
+    int c2 = message.indexOf(':', c1 + 1);
+
+    // If either separator is missing, report malformed command
+    if (c1 == -1 || c2 == -1)
+    {
+        response = "Malformed command. Format: id:command:value_or_?";
+        station_health.serial_parse_errors++;
+        return false;
+    }
+
+    // Extract command and value parts
+    String command = message.substring(c1 + 1, c2);
+    String target_cmd = message.substring(c2 + 1);
+
+    // Station wide commands
+    if (c1 == 1 && message[0] == _station_command_id)
+    {
+        for (size_t i = 0; i < stationCommandTableSize; ++i)
+        {
+            if (command == stationCommandTable[i].name)
+            {
+                return stationCommandTable[i].func(target_cmd, response);
+            }
+        }
+
+        response = "Unknown command";
+        station_health.serial_parse_errors++;
+        return false;
+    }
+
+    // Parse device ID (only valid for single-digit IDs, "12:..." is not heater 1)
+    int id = -1;
+    if (c1 == 1 && isdigit(message[0]))
+    {
+        id = message[0] - '0';
+    }
+
+    // Validate heater index
+    if (id < 0 || id >= (int)(sizeof(heaters) / sizeof(heaters[0])))
+    {
+        response = "Invalid device ID";
+        station_health.serial_parse_errors++;
+        return false;
+    }
+
+    // Resolve the target heater object
+    Heater& target = heaters[id];
+
+    // Look for the command in the command table
+    for (int i = 0; i < commandTableSize; ++i)
+    {
+        if (command == commandTable[i].name)
+        {
+            return (target.*(commandTable[i].func))(target_cmd, response);
+        }
+    }
+
+    // Command not recognized
+    response = "Unknown command";
+    station_health.serial_parse_errors++;
+    return false;
+}
+
+/**
+ * @brief executes a command line received on the USB port and writes back the reply.
+ *
+ * Failed commands reply "ERROR " and their response, commands without a response and
+ * without error reply nothing.
+ *
+ * @param message Command line without terminator.
+ */
+void usb_command(const String &message)
+{
+    String response;
+
+    TRACE_EVENT(TRACE_COMMAND, 0, message.length());
+    RECORD_COMMAND(0, message);
+    bool success = eval_serial_command(message, response);
+
+    if (!success)
+        _serial_usb.print("ERROR ");
+
+    if (response.length())
+        _serial_usb.print(response);
+
+    if (!success || response.length() > 0)
+        _serial_usb.print(_serial_usb_terminator);
+}
+
+/**
+ * @brief executes a command received from the HMI, the HMI gets no reply.
+ *
+ * @param message Command without the display terminator.
+ */
+void hmi_command(const String &message)
+{
+    String response;
+
+    TRACE_EVENT(TRACE_COMMAND, 1, message.length());
+    RECORD_COMMAND(1, message);
+    eval_serial_command(message, response);
+}
+
+
 #endif
\ No newline at end of file
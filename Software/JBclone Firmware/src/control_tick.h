@@ -0,0 +1,39 @@
+#ifndef __CONTROL_TICK_H__
+#define __CONTROL_TICK_H__
+
+#include <Arduino.h>
+#include "objects.h"
+#include "profiler.h"
+#include "control.h"
+#include "zero_cross.h"
+#include "scope.h"
+
+/**
+ * @brief control timer interrupt service routine.
+ *
+ * Called every _control_tick_us by the control timer. Takes the zero cross events, checks
+ * the zero cross watchdog, then samples and computes the PID of every heater that is due,
+ * then runs a triggered scope capture. The capture stretches its tick on purpose, it runs
+ * after the tick timing of control.h so it stays out of the measured bound. Only the zero
+ * cross ISR preempts it, the main loop masks it with ControlLock.
+ *
+ * @note This function should be called in the control timer interrupt handler.
+ */
+void control_tick()
+{
+    PROFILE_SCOPE(PROF_CONTROL_TICK);
+
+    {
+        ControlTickTiming control_timing;
+
+        zero_cross_events();
+        zero_cross_watchdog();
+
+        for (int i = 0; i < _heater_count; i++)
+            heaters[i].control_update();
+    }
+
+    scope_update();
+}
+
+#endif
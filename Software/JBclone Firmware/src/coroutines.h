@@ -0,0 +1,197 @@
+#ifndef __COROUTINES_H__
+#define __COROUTINES_H__
+
+#include <Arduino.h>
+#include "Hardware.h"
+#include "objects.h"
+#include "coro.h"
+#include "Serial_controls.h"
+#include "display.h"
+#include "trace.h"
+#include "recorder.h"
+
+/**
+ * @file coroutines.h
+ * @brief coroutine threads of the coroutine build (JBCLONE_CORO), run by coro_run() in loop().
+ *
+ *   usb      USB command lines, replies once the saves of the command are written
+ *   hmi_rx   display commands, same as usb without reply
+ *   hmi_tx   display refresh, written as the serial buffer frees up
+ *   storage  EEPROM writes requested by the channels (Heater::storage_request())
+ *
+ * A command that saves gets "OK" from its handler, then waits for the storage thread; a
+ * failed write turns the reply into "ERROR FAIL TO SAVE" as a blocking save would. A write
+ * failure of another channel meanwhile also fails the reply.
+ */
+
+constexpr uint32_t coroutines_hmi_refresh_us = 10000;
+
+static uint32_t coroutines_storage_failures = 0;
+static bool coroutines_storage_busy = false;
+
+static bool coroutines_storage_idle()
+{
+    if (coroutines_storage_busy)
+        return false;
+    for (int i = 0; i < _heater_count; i++)
+    {
+        if (heaters[i].storage_pending())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief evaluates a command, then waits for the EEPROM writes it requested.
+ *
+ * @param message The command line.
+ * @param response The response string, "FAIL TO SAVE" if a write failed.
+ * @return true if the command and its writes were successful, false otherwise.
+ */
+CoroTask<bool> command_async(String message, String &response)
+{
+    const uint32_t failures = coroutines_storage_failures;
+    bool success = eval_serial_command(message, response);
+
+    co_await coro_until(coroutines_storage_idle);
+    if (success && coroutines_storage_failures != failures)
+    {
+        response = "FAIL TO SAVE";
+        success = false;
+    }
+    co_return success;
+}
+
+/**
+ * @brief executes a USB command line and writes back the reply, as usb_command().
+ */
+CoroTask<void> usb_command_async(String message)
+{
+    String response;
+
+    TRACE_EVENT(TRACE_COMMAND, 0, message.length());
+    RECORD_COMMAND(0, message);
+    bool success = co_await command_async(message, response);
+
+    if (!success)
+        _serial_usb.print("ERROR ");
+
+    if (response.length())
+        _serial_usb.print(response);
+
+    if (!success || response.length() > 0)
+        _serial_usb.print(_serial_usb_terminator);
+}
+
+/**
+ * @brief usb thread: assembles command lines from the received bytes.
+ *
+ * A line without terminator is taken after the port timeout, as readStringUntil() returns it.
+ */
+CoroTask<void> usb_thread()
+{
+    String line;
+    for (;;)
+    {
+        if (line.length() == 0)
+            co_await coro_readable(_serial_usb);
+        else
+            co_await coro_readable(_serial_usb, _serial_usb_timeout * 1000UL);
+
+        if (_serial_usb.available() == 0)
+        {
+            co_await usb_command_async(line);
+            line = "";
+            continue;
+        }
+
+        while (_serial_usb.available() > 0)
+        {
+            const char incoming = _serial_usb.read();
+            if (incoming != _serial_usb_terminator)
+            {
+                line += incoming;
+                continue;
+            }
+
+            co_await usb_command_async(line);
+            line = "";
+        }
+    }
+}
+
+/**
+ * @brief hmi_rx thread: display commands, as hmi_command().
+ */
+CoroTask<void> hmi_rx_thread()
+{
+    String message;
+    for (;;)
+    {
+        co_await coro_readable(_hmi.input());
+
+        while (_hmi.poll(message))
+        {
+            String response;
+            TRACE_EVENT(TRACE_COMMAND, 1, message.length());
+            RECORD_COMMAND(1, message);
+            co_await command_async(message, response);
+        }
+    }
+}
+
+/**
+ * @brief hmi_tx thread: channel values to the display, one channel per serial buffer.
+ */
+CoroTask<void> hmi_tx_thread()
+{
+    for (;;)
+    {
+        for (int i = 0; i < _heater_count; i++)
+        {
+            heaters[i].hmi_refresh();
+            while (!_hmi.tx_flush())
+                co_await coro_yield();
+        }
+        co_await coro_sleep_us(coroutines_hmi_refresh_us);
+    }
+}
+
+/**
+ * @brief storage thread: EEPROM writes of every channel, in channel order.
+ */
+CoroTask<void> storage_thread()
+{
+    for (;;)
+    {
+        // requests from here on wake the wait below
+        const uint32_t seen = Heater::storage_requested.count();
+
+        coroutines_storage_busy = true;
+        for (int i = 0; i < _heater_count; i++)
+        {
+            if (!heaters[i].storage_pending())
+                continue;
+            bool written = co_await heaters[i].storage_write_async();
+            coroutines_storage_failures += !written;
+        }
+        coroutines_storage_busy = false;
+
+        co_await coro_event(Heater::storage_requested, seen);
+    }
+}
+
+/**
+ * @brief starts the coroutine threads, they run from the next loop().
+ *
+ * @note Call at the end of setup().
+ */
+void coroutines_start()
+{
+    coro_spawn("usb", usb_thread());
+    coro_spawn("hmi_rx", hmi_rx_thread());
+    coro_spawn("hmi_tx", hmi_tx_thread());
+    coro_spawn("storage", storage_thread());
+}
+
+#endif
@@ -1,66 +1,112 @@
-#include <Arduino.h>
-#include "Hardware.h"
-#include "objects.h"
-#include "zero_cross.h"
-#include "hartbeat.h"
-#include "Serial_controls.h"
-#include "display.h"
-
-void setup()
-{
-
-    // pheripheral init
-    _serial_usb.begin(_serial_usb_baud);
-    _serial_usb.setTimeout(_serial_usb_timeout);
-
-    i2cBus.begin();
-
-    _hmi.init(_serial_hmi_baud, _serial_hmi_timeout);
-
-    // board init
-    analogReadResolution(ADC_BITS);
-    attachInterrupt(digitalPinToInterrupt(_pin_zero_cross), zero_cross_isr, RISING);
-    pinMode(_pin_hartbeat, OUTPUT);
-    hartbeat_set();
-
-    // heaters init
-    for (int i = 0; i < _heater_count; i++)
-        heaters[i].init();
-}
-
-void loop()
-{
-    // hartbear routine
-    update_hartbeat();
-
-    // heater update
-    for (int i = 0; i < _heater_count; i++)
-    {
-        heaters[i].update();
-    }
-
-    // interfaces
-    String message;
-    String response;
-
-    if (_serial_usb.available() > 0)
-    {
-        message = _serial_usb.readStringUntil(_serial_usb_terminator);
-        bool success = eval_serial_command(message, response);
-
-        if (!success)
-            _serial_usb.print("ERROR ");
-
-        if (response.length())
-            _serial_usb.print(response);
-
-        if (!success || response.length() > 0)
-            _serial_usb.print(_serial_usb_terminator);
-    }
-
-    bool hmi_message = _hmi.read(message);
-    if (hmi_message)
-    {
-        eval_serial_command(message, response);
-    }
-}
+#include <Arduino.h>
+#include "Hardware.h"
+#include "objects.h"
+#include "zero_cross.h"
+#include "control_tick.h"
+#include "hartbeat.h"
+#include "Serial_controls.h"
+#include "display.h"
+#include "profiler.h"
+#include "zc_timing.h"
+#include "trace.h"
+#include "health.h"
+#include "memstat.h"
+#include "steptest.h"
+#include "recorder.h"
+#include "events.h"
+#include "idle.h"
+#ifdef JBCLONE_RTOS
+#include "tasks.h"
+#endif
+#ifdef JBCLONE_CORO
+#include "coroutines.h"
+#endif
+
+void setup()
+{
+    // stack high water mark reference, must run first
+    memstat_paint_stack();
+
+    // cycle counter for profiling and timestamps
+    cycle_counter_init();
+
+    // pheripheral init
+    _serial_usb.begin(_serial_usb_baud);
+    _serial_usb.setTimeout(_serial_usb_timeout);
+
+    i2cBus.begin();
+
+    _hmi.init(_serial_hmi_baud, _serial_hmi_timeout);
+
+    // board init
+    analogReadResolution(ADC_BITS);
+    zc_timing_init();
+    zero_cross_timestamp = micros();
+    event_queue_init();
+    attachInterrupt(digitalPinToInterrupt(_pin_zero_cross), zero_cross_isr, RISING);
+    pinMode(_pin_hartbeat, OUTPUT);
+    hartbeat_set();
+
+    // heaters init
+    for (int i = 0; i < _heater_count; i++)
+        heaters[i].init(i);
+
+    // sampling and PID from here on run in the control tick
+    control_init(control_tick);
+
+#ifdef JBCLONE_RTOS
+    // the loop work runs in tasks from here on, does not return
+    tasks_start();
+#endif
+#ifdef JBCLONE_CORO
+    // interfaces and EEPROM writes, run by loop()
+    coroutines_start();
+#endif
+}
+
+/**
+ * @brief true if the loop has input waiting, the idle sleep would delay it.
+ */
+static bool loop_pending()
+{
+#ifdef JBCLONE_CORO
+    return coro_pending();
+#else
+    return _serial_usb.available() > 0 || _hmi.input().available() > 0;
+#endif
+}
+
+void loop()
+{
+    // until the next interrupt if nothing is waiting, see idle.h
+    idle_sleep(loop_pending);
+
+    PROFILE_SCOPE(PROF_LOOP);
+
+    health_update();
+
+    // hartbear routine
+    update_hartbeat();
+
+    // heater update, HMI and sleep detection
+    for (int i = 0; i < _heater_count; i++)
+    {
+        heaters[i].update();
+    }
+    steptest_update();
+    record_update(_serial_usb);
+
+#ifdef JBCLONE_CORO
+    // interfaces, HMI refresh and EEPROM writes
+    coro_run();
+#else
+    // interfaces
+    if (_serial_usb.available() > 0)
+        usb_command(_serial_usb.readStringUntil(_serial_usb_terminator));
+
+    String message;
+    bool hmi_message = _hmi.read(message);
+    if (hmi_message)
+        hmi_command(message);
+#endif
+}
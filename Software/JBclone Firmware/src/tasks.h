@@ -0,0 +1,159 @@
+#ifndef __TASKS_H__
+#define __TASKS_H__
+
+#include <Arduino.h>
+#include "Hardware.h"
+#include "objects.h"
+#include "rtos.h"
+#include "hartbeat.h"
+#include "Serial_controls.h"
+#include "display.h"
+#include "profiler.h"
+#include "health.h"
+#include "steptest.h"
+#include "recorder.h"
+#include "trace.h"
+#include "events.h"
+#include "scope.h"
+
+/**
+ * @file tasks.h
+ * @brief task bodies of the RTOS build (JBCLONE_RTOS), the work of loop() split by deadline.
+ *
+ * See rtos.h for the task set. Stack sizes are in words and sized for the String work of
+ * command evaluation; "s:rtos:?" reports the free stack each task had at worst.
+ * In this build the health loop rate is the control task rate.
+ */
+
+constexpr UBaseType_t tasks_control_priority = 4;
+constexpr UBaseType_t tasks_comms_priority = 3;
+constexpr UBaseType_t tasks_hmi_priority = 2;
+constexpr UBaseType_t tasks_storage_priority = 1;
+
+#ifdef ARDUINO_ARCH_STM32
+constexpr uint16_t tasks_stack_scale = 1;
+#else
+constexpr uint16_t tasks_stack_scale = 16; // POSIX port, 64 bit words and PTHREAD_STACK_MIN
+#endif
+constexpr uint16_t tasks_control_stack = 256 * tasks_stack_scale; // words
+constexpr uint16_t tasks_comms_stack = 512 * tasks_stack_scale;
+constexpr uint16_t tasks_hmi_stack = 384 * tasks_stack_scale;
+constexpr uint16_t tasks_storage_stack = 256 * tasks_stack_scale;
+
+#ifdef ARDUINO_ARCH_STM32
+// RAM budget of the STM32F103C8. The stacks come from the heap at run time, the linker
+// does not see them: the big buffers, the heaters, the stacks (idle task and interrupts
+// included) and the kernel objects must leave the reserve free.
+constexpr size_t tasks_ram_size = 20 * 1024;
+constexpr size_t tasks_ram_reserve = 4 * 1024; // core USB and serial buffers, other module data, String heap
+constexpr size_t tasks_kernel_ram = 1024;      // TCBs, storage queue, control mutex, heap chunk headers
+constexpr size_t tasks_stack_ram = (tasks_control_stack + tasks_comms_stack + tasks_hmi_stack + tasks_storage_stack +
+                                    configMINIMAL_STACK_SIZE + configISR_STACK_SIZE_WORDS) *
+                                   sizeof(StackType_t);
+constexpr size_t tasks_buffer_ram = sizeof(heaters) + sizeof(TraceEvent) * trace_buffer_size +
+                                    sizeof(IsrEvent) * event_queue_size + sizeof(uint16_t) * scope_buffer_size +
+                                    sizeof(StepTestSample) * steptest_buffer_size +
+                                    (sizeof(RecordEvent) + 1) * record_buffer_size + record_text_size +
+                                    sizeof(Heater::Snapshot) * (sizeof(heaters) / sizeof(heaters[0]));
+static_assert(tasks_buffer_ram + tasks_stack_ram + tasks_kernel_ram + tasks_ram_reserve <= tasks_ram_size,
+              "RTOS build over the RAM budget: shrink a buffer or a stack");
+#endif
+
+constexpr uint32_t tasks_control_period_ms = 1;
+constexpr uint32_t tasks_comms_period_ms = 1;
+constexpr uint32_t tasks_hmi_period_ms = 10;
+
+/**
+ * @brief control task: health, hartbeat, heater update (energy, sleep), step tests.
+ */
+void control_task(void *parameters)
+{
+    (void)parameters;
+
+    TickType_t wake = xTaskGetTickCount();
+    for (;;)
+    {
+        {
+            PROFILE_SCOPE(PROF_LOOP);
+
+            health_update();
+            update_hartbeat();
+
+            for (int i = 0; i < _heater_count; i++)
+                heaters[i].update();
+            steptest_update();
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(tasks_control_period_ms));
+    }
+}
+
+/**
+ * @brief comms task: USB command lines and recorder output.
+ *
+ * Lines are assembled from the bytes already received, so a partial line does not block
+ * the lower priority tasks as readStringUntil() would until the port timeout.
+ */
+void comms_task(void *parameters)
+{
+    (void)parameters;
+
+    String line;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;)
+    {
+        while (_serial_usb.available() > 0)
+        {
+            const char incoming = _serial_usb.read();
+            if (incoming != _serial_usb_terminator)
+            {
+                line += incoming;
+                continue;
+            }
+            usb_command(line);
+            line = "";
+        }
+
+        record_update(_serial_usb);
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(tasks_comms_period_ms));
+    }
+}
+
+/**
+ * @brief HMI task: display commands and channel values refresh.
+ */
+void hmi_task(void *parameters)
+{
+    (void)parameters;
+
+    String message;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;)
+    {
+        if (_hmi.read(message))
+            hmi_command(message);
+
+        for (int i = 0; i < _heater_count; i++)
+            heaters[i].hmi_refresh();
+
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(tasks_hmi_period_ms));
+    }
+}
+
+/**
+ * @brief creates the tasks and starts the scheduler.
+ *
+ * @note Call at the end of setup(), after control_init(). Does not return.
+ */
+void tasks_start()
+{
+    rtos_storage_init();
+
+    xTaskCreate(control_task, "control", tasks_control_stack, nullptr, tasks_control_priority, nullptr);
+    xTaskCreate(comms_task, "comms", tasks_comms_stack, nullptr, tasks_comms_priority, nullptr);
+    xTaskCreate(hmi_task, "hmi", tasks_hmi_stack, nullptr, tasks_hmi_priority, nullptr);
+    xTaskCreate(rtos_storage_task, "storage", tasks_storage_stack, nullptr, tasks_storage_priority, nullptr);
+
+    vTaskStartScheduler();
+}
+
+#endif
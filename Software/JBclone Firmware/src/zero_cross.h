@@ -1,42 +1,146 @@
-#ifndef __ZERO_CROSS_H__
-#define __ZERO_CROSS_H__
-
-#include <Arduino.h>
-#include "hartbeat.h"
-#include "objects.h"
-
-static int zero_cross_counter = 0;
-
-/**
- * @brief Zero cross interrupt service routine.
- * 
- * This function is called when a zero cross event occurs.
- * Turns off heatersand samples thermocouple every _zero_cross_period cycles.
- * Updates the heater output and sets hartbeat flag every time it is called.
- * 
- * @note This function should be called in the zero cross interrupt handler.
- */
-void zero_cross_isr()
-{
-    // flag hartbeat for update
-    hartbeat_set();
-
-    // temperature acquisituin cycle
-    if (zero_cross_counter >= _zero_cross_period)
-    {
-        //sample
-        for (int i = 0; i < _heater_count; i++)
-            heaters[i].pid_schedule_sample();
-        
-        zero_cross_counter = 0;
-        return;
-    }
-    
-    float op_level = float(zero_cross_counter) / float(_zero_cross_period);
-    for (int i = 0; i < _heater_count; i++)
-        heaters[i].update_output(op_level);
-    
-    zero_cross_counter++;
-}
-
+#ifndef __ZERO_CROSS_H__
+#define __ZERO_CROSS_H__
+
+#include <Arduino.h>
+#include "hartbeat.h"
+#include "objects.h"
+#include "profiler.h"
+#include "zc_timing.h"
+#include "trace.h"
+#include "health.h"
+#include "scope.h"
+#include "recorder.h"
+#include "events.h"
+#include "control.h"
+
+// sampling window number, ISR side
+static uint16_t zero_cross_window = 0;
+
+/**
+ * @brief Zero cross interrupt service routine.
+ * 
+ * This function is called when a zero cross event occurs.
+ * Turns off heatersand samples thermocouple every _zero_cross_period cycles.
+ * Updates the heater output every time it is called. Everything the loop has to learn
+ * from the edge is queued as an event, see zero_cross_events().
+ * 
+ * @note This function should be called in the zero cross interrupt handler.
+ */
+void zero_cross_isr()
+{
+    ZcIsrTiming zc_timing;
+    PROFILE_SCOPE(PROF_ZERO_CROSS_ISR);
+
+    const uint32_t now = micros();
+    event_push(EVENT_MAINS_EDGE, 0, zero_cross_counter, now);
+
+    TRACE_EVENT(TRACE_ZERO_CROSS, 0, zero_cross_counter);
+    RECORD_ZERO_CROSS(zero_cross_counter);
+    station_health.zero_cross_edges++;
+    scope_trigger(SCOPE_TRIGGER_ZERO_CROSS, 0);
+
+    // temperature acquisituin cycle
+    if (zero_cross_counter >= _zero_cross_period)
+    {
+        //sample
+        zero_cross_window++;
+        event_push(EVENT_WINDOW_START, 0, zero_cross_window, now);
+        for (int i = 0; i < _heater_count; i++)
+        {
+            heaters[i].pid_schedule_sample(zero_cross_window);
+            event_push(EVENT_SAMPLE_DUE, i, zero_cross_window, now);
+        }
+        
+        zero_cross_counter = 0;
+        return;
+    }
+    
+    float op_level = float(zero_cross_counter) / float(_zero_cross_period);
+    uint16_t output_mask = 0;
+    for (int i = 0; i < _heater_count; i++)
+    {
+        if (heaters[i].update_output(op_level))
+            output_mask |= 1 << i;
+    }
+    TRACE_EVENT(TRACE_OUTPUT_MASK, 0, output_mask);
+    RECORD_OUTPUT_MASK(output_mask);
+    
+    zero_cross_counter++;
+}
+
+/**
+ * @brief feeds the zero cross watchdog, never back in time.
+ *
+ * Events queued before an overflow are older than the overflow that fed it already.
+ */
+static void zero_cross_feed(uint32_t timestamp)
+{
+    if ((int32_t)(timestamp - zero_cross_timestamp) > 0)
+        zero_cross_timestamp = timestamp;
+}
+
+/**
+ * @brief takes the zero cross events queued by the ISR.
+ *
+ * Mains edges pulse the hartbeat and feed the zero cross watchdog, sample due events open
+ * the sample window of their channel. Dropped events still prove the ISR is running, the
+ * timestamp of the last one feeds the watchdog when the overflow count goes up; a count
+ * cleared by "s:events:clear" only moves the baseline. At most _control_events_per_tick
+ * events are taken per call, the rest waits for the next tick.
+ *
+ * @note Call from the control tick, before zero_cross_watchdog() and the heater updates.
+ */
+void zero_cross_events()
+{
+    static uint32_t overflows = 0;
+
+    IsrEvent event;
+    for (uint32_t n = 0; n < _control_events_per_tick; n++)
+    {
+        ControlPhaseTiming timing(CONTROL_PHASE_EVENT);
+        if (!event_pop(event))
+            break;
+
+        switch (event.type)
+        {
+        case EVENT_MAINS_EDGE:
+            hartbeat_set();
+            zero_cross_feed(event.timestamp);
+            break;
+        case EVENT_SAMPLE_DUE:
+            heaters[event.channel].sample_due(event.timestamp, event.arg);
+            break;
+        default:
+            break;
+        }
+    }
+
+    const uint32_t dropped = event_overflows();
+    if (dropped > overflows)
+        zero_cross_feed(event_last_overflow_timestamp());
+    overflows = dropped;
+}
+
+/**
+ * @brief turns the heaters off when the zero cross edges stop.
+ *
+ * The ISR is the only writer of the heater outputs, without edges an output stays at its
+ * last level and no sample (so no runaway check) is taken. Enabled heaters go to FAULT
+ * after _zero_cross_timeout_us without an edge.
+ *
+ * @note Call from the control tick, after zero_cross_events() and before the heater updates.
+ */
+void zero_cross_watchdog()
+{
+    if (micros() - zero_cross_timestamp <= _zero_cross_timeout_us)
+        return;
+
+    for (int i = 0; i < _heater_count; i++)
+    {
+        const HeaterState state = heaters[i].get_state();
+        if (state != HEATER_OFF && state != HEATER_FAULT)
+            heaters[i].fault(FAULT_ZERO_CROSS);
+    }
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+"""Convert a station trace dump ("s:trace:?") to Chrome/Perfetto trace JSON.
+
+The dump can be read from a text file captured from the USB port or fetched
+directly from a connected station:
+
+    python trace_to_chrome.py dump.txt -o trace.json
+    python trace_to_chrome.py --port COM5 -o trace.json
+
+Open the output in chrome://tracing or https://ui.perfetto.dev
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+from typing import Dict, List, Optional, Tuple
+
+EVENT_FORMAT = "<IBBH"
+EVENT_SIZE = struct.calcsize(EVENT_FORMAT)
+DEFAULT_F_CPU = 72_000_000
+CHANNELS = 4
+
+# must match TraceEventType in lib/trace/trace.h
+TRACE_ZERO_CROSS = 1
+TRACE_SAMPLE_SCHEDULED = 2
+TRACE_SAMPLE_TAKEN = 3
+TRACE_PID_COMPUTE = 4
+TRACE_OUTPUT_MASK = 5
+TRACE_COMMAND = 6
+TRACE_SAVE_START = 7
+TRACE_SAVE_END = 8
+TRACE_HMI_FLUSH = 9
+
+# timeline rows
+TID_MAINS = 1
+TID_COMMS = 2
+TID_STORAGE = 3
+TID_HMI = 4
+TID_CHANNEL_BASE = 10
+
+
+def parse_dump(lines: List[str]) -> Tuple[List[Tuple[int, int, int, int]], int]:
+    """Decode dump lines into (cycles, type, channel, arg) tuples and the CPU clock."""
+    events = []
+    f_cpu = DEFAULT_F_CPU
+    for line in lines:
+        line = line.strip()
+        if line.startswith("T:"):
+            raw = bytes.fromhex(line[2:])
+            for offset in range(0, len(raw) - EVENT_SIZE + 1, EVENT_SIZE):
+                events.append(struct.unpack_from(EVENT_FORMAT, raw, offset))
+        else:
+            match = re.search(r"f_cpu=(\d+)", line)
+            if match:
+                f_cpu = int(match.group(1))
+    return events, f_cpu
+
+
+def unwrap_cycles(events: List[Tuple[int, int, int, int]]) -> List[int]:
+    """Extend the 32 bit cycle counter to a monotonic value, events are in order."""
+    unwrapped = []
+    offset = 0
+    previous: Optional[int] = None
+    for cycles, _, _, _ in events:
+        if previous is not None and cycles < previous:
+            offset += 1 << 32
+        unwrapped.append(cycles + offset)
+        previous = cycles
+    return unwrapped
+
+
+def to_chrome_trace(events: List[Tuple[int, int, int, int]], f_cpu: int) -> Dict:
+    """Build the Chrome trace event dictionary."""
+    trace: List[Dict] = []
+
+    def meta(tid: int, name: str) -> None:
+        trace.append(
+            {"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": name}}
+        )
+
+    trace.append({"ph": "M", "pid": 1, "name": "process_name", "args": {"name": "station"}})
+    meta(TID_MAINS, "mains")
+    meta(TID_COMMS, "comms")
+    meta(TID_STORAGE, "storage")
+    meta(TID_HMI, "hmi")
+    for ch in range(CHANNELS):
+        meta(TID_CHANNEL_BASE + ch, f"channel {ch}")
+
+    if not events:
+        return {"traceEvents": trace, "displayTimeUnit": "ns"}
+
+    timestamps = unwrap_cycles(events)
+    origin = timestamps[0]
+    sample_open = [False] * CHANNELS
+    save_open = False
+
+    for (cycles, kind, channel, arg), ts_cycles in zip(events, timestamps):
+        ts = (ts_cycles - origin) * 1e6 / f_cpu  # us
+        base = {"pid": 1, "ts": ts}
+        ch_tid = TID_CHANNEL_BASE + channel
+
+        if kind == TRACE_ZERO_CROSS:
+            trace.append({**base, "ph": "i", "s": "t", "tid": TID_MAINS, "name": "zero_cross", "args": {"counter": arg}})
+        elif kind == TRACE_OUTPUT_MASK:
+            outputs = {f"ch{ch}": (arg >> ch) & 1 for ch in range(CHANNELS)}
+            trace.append({**base, "ph": "C", "tid": TID_MAINS, "name": "outputs", "args": outputs})
+        elif kind == TRACE_SAMPLE_SCHEDULED and channel < CHANNELS:
+            if sample_open[channel]:
+                trace.append({**base, "ph": "E", "tid": ch_tid, "name": "sample window", "args": {"missed": 1}})
+            trace.append({**base, "ph": "B", "tid": ch_tid, "name": "sample window"})
+            sample_open[channel] = True
+        elif kind == TRACE_SAMPLE_TAKEN and channel < CHANNELS:
+            trace.append({**base, "ph": "i", "s": "t", "tid": ch_tid, "name": "sample", "args": {"adc": arg}})
+            if sample_open[channel]:
+                trace.append({**base, "ph": "E", "tid": ch_tid, "name": "sample window"})
+                sample_open[channel] = False
+        elif kind == TRACE_PID_COMPUTE:
+            trace.append({**base, "ph": "i", "s": "t", "tid": ch_tid, "name": "pid_compute", "args": {"output": arg / 1000.0}})
+        elif kind == TRACE_COMMAND:
+            source = "hmi" if channel else "usb"
+            trace.append({**base, "ph": "i", "s": "t", "tid": TID_COMMS, "name": f"command {source}", "args": {"length": arg}})
+        elif kind == TRACE_SAVE_START:
+            trace.append({**base, "ph": "B", "tid": TID_STORAGE, "name": f"save ch{channel}"})
+            save_open = True
+        elif kind == TRACE_SAVE_END and save_open:
+            trace.append({**base, "ph": "E", "tid": TID_STORAGE, "name": f"save ch{channel}", "args": {"ok": arg}})
+            save_open = False
+        elif kind == TRACE_HMI_FLUSH:
+            trace.append({**base, "ph": "i", "s": "t", "tid": TID_HMI, "name": f"hmi ch{channel}"})
+
+    return {"traceEvents": trace, "displayTimeUnit": "ns"}
+
+
+def read_from_station(port_name: str, baud: int = 152000) -> List[str]:
+    """Request the trace dump from a connected station."""
+    import serial
+
+    with serial.Serial(port_name, baud, timeout=2) as port:
+        port.reset_input_buffer()
+        port.write(b"s:trace:?\n")
+        lines = []
+        while True:
+            line = port.read_until().decode(errors="replace").strip()
+            if not line:
+                raise TimeoutError("station did not answer")
+            lines.append(line)
+            if line.startswith("ERROR "):
+                raise RuntimeError(line)
+            if line.startswith("events="):
+                return lines
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", nargs="?", help="text file with the trace dump")
+    parser.add_argument("--port", help="read the dump from the station on this serial port")
+    parser.add_argument("-o", "--output", default="trace.json", help="output JSON file")
+    args = parser.parse_args()
+
+    if args.port:
+        lines = read_from_station(args.port)
+    elif args.dump:
+        with open(args.dump, "r", encoding="ascii", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        parser.error("either a dump file or --port is required")
+
+    events, f_cpu = parse_dump(lines)
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(to_chrome_trace(events, f_cpu), f)
+
+    print(f"{len(events)} events written to {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())